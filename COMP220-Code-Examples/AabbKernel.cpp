@@ -0,0 +1,169 @@
+#include "AabbKernel.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "SimdPlatform.h"
+
+//Reads CPUID leaf and subleaf into registers, eax ebx ecx edx
+static void ReadCpuid(unsigned int leaf, unsigned int subleaf, unsigned int registers[4])
+{
+	registers[0] = registers[1] = registers[2] = registers[3] = 0;
+#if defined(SIMD_HAS_AVX2) && (GLM_COMPILER & GLM_COMPILER_VC)
+	int values[4];
+	__cpuidex(values, leaf, subleaf);
+	for (int i = 0; i < 4; i++) registers[i] = static_cast<unsigned int>(values[i]);
+#elif defined(SIMD_HAS_AVX2)
+	__cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#else
+	(void)leaf;
+	(void)subleaf;
+#endif
+}
+
+static AabbKernelLevel DetectAabbKernel()
+{
+#if defined(SIMD_HAS_AVX2)
+	unsigned int registers[4];
+	ReadCpuid(0, 0, registers);
+	unsigned int highestLeaf = registers[0];
+
+	ReadCpuid(1, 0, registers);
+	bool hasOsxsave = (registers[2] & (1u << 27)) != 0;
+	bool hasAvx = (registers[2] & (1u << 28)) != 0;
+
+	if (highestLeaf >= 7 && hasOsxsave && hasAvx)
+	{
+		//The OS also has to save the upper halves of the ymm registers on a context switch
+#if (GLM_COMPILER & GLM_COMPILER_VC)
+		unsigned long long enabledState = _xgetbv(0);
+#else
+		unsigned int eax, edx;
+		__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		unsigned long long enabledState = (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+		ReadCpuid(7, 0, registers);
+		bool hasAvx2 = (registers[1] & (1u << 5)) != 0;
+		if (hasAvx2 && (enabledState & 0x6) == 0x6) return AABB_KERNEL_AVX2;
+	}
+	return AABB_KERNEL_SSE;
+#elif defined(SIMD_HAS_SSE)
+	return AABB_KERNEL_SSE;
+#else
+	return AABB_KERNEL_SCALAR;
+#endif
+}
+
+AabbKernelLevel GetBestAabbKernel()
+{
+	static const AabbKernelLevel bestLevel = DetectAabbKernel();
+	return bestLevel;
+}
+
+bool IsAabbKernelSupported(AabbKernelLevel level)
+{
+	return level <= GetBestAabbKernel();
+}
+
+const char* GetAabbKernelName(AabbKernelLevel level)
+{
+	switch (level)
+	{
+	case AABB_KERNEL_AVX2: return "avx2";
+	case AABB_KERNEL_SSE: return "sse";
+	default: return "scalar";
+	}
+}
+
+//The same six comparisons as the original per particle check, one particle at a time
+static void OverlapScalar(const ParticleStore& p, size_t begin, size_t first, size_t last, const AABB& collider, uint32_t* hitMask)
+{
+	for (size_t k = first; k < last; k++)
+	{
+		size_t i = begin + k;
+		if (
+			p.maximumX[i] >= collider.minimum.x && p.minimumX[i] <= collider.maximum.x &&
+			p.maximumY[i] >= collider.minimum.y && p.minimumY[i] <= collider.maximum.y &&
+			p.maximumZ[i] >= collider.minimum.z && p.minimumZ[i] <= collider.maximum.z)
+		{
+			hitMask[k / 32] |= 1u << (k % 32);
+		}
+	}
+}
+
+#if defined(SIMD_HAS_SSE)
+//Returns how many particles it handled, the rest are left for the scalar loop
+//first has to be a multiple of 4 so each group of 4 bits lands inside one mask word
+static size_t OverlapSse(const ParticleStore& p, size_t begin, size_t first, size_t last, const AABB& collider, uint32_t* hitMask)
+{
+	const __m128 colliderMinimumX = _mm_set1_ps(collider.minimum.x), colliderMaximumX = _mm_set1_ps(collider.maximum.x);
+	const __m128 colliderMinimumY = _mm_set1_ps(collider.minimum.y), colliderMaximumY = _mm_set1_ps(collider.maximum.y);
+	const __m128 colliderMinimumZ = _mm_set1_ps(collider.minimum.z), colliderMaximumZ = _mm_set1_ps(collider.maximum.z);
+
+	size_t k = first;
+	for (; k + 4 <= last; k += 4)
+	{
+		size_t i = begin + k;
+		__m128 hit = _mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(&p.maximumX[i]), colliderMinimumX), _mm_cmple_ps(_mm_loadu_ps(&p.minimumX[i]), colliderMaximumX));
+		hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(&p.maximumY[i]), colliderMinimumY), _mm_cmple_ps(_mm_loadu_ps(&p.minimumY[i]), colliderMaximumY)));
+		hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(&p.maximumZ[i]), colliderMinimumZ), _mm_cmple_ps(_mm_loadu_ps(&p.minimumZ[i]), colliderMaximumZ)));
+		hitMask[k / 32] |= static_cast<uint32_t>(_mm_movemask_ps(hit)) << (k % 32);
+	}
+	return k;
+}
+#endif
+
+#if defined(SIMD_HAS_AVX2)
+SIMD_AVX2_FUNCTION
+//first has to be a multiple of 8 so each group of 8 bits lands inside one mask word
+static size_t OverlapAvx2(const ParticleStore& p, size_t begin, size_t first, size_t last, const AABB& collider, uint32_t* hitMask)
+{
+	const __m256 colliderMinimumX = _mm256_set1_ps(collider.minimum.x), colliderMaximumX = _mm256_set1_ps(collider.maximum.x);
+	const __m256 colliderMinimumY = _mm256_set1_ps(collider.minimum.y), colliderMaximumY = _mm256_set1_ps(collider.maximum.y);
+	const __m256 colliderMinimumZ = _mm256_set1_ps(collider.minimum.z), colliderMaximumZ = _mm256_set1_ps(collider.maximum.z);
+
+	size_t k = first;
+	for (; k + 8 <= last; k += 8)
+	{
+		size_t i = begin + k;
+		__m256 hit = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(&p.maximumX[i]), colliderMinimumX, _CMP_GE_OQ), _mm256_cmp_ps(_mm256_loadu_ps(&p.minimumX[i]), colliderMaximumX, _CMP_LE_OQ));
+		hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(&p.maximumY[i]), colliderMinimumY, _CMP_GE_OQ), _mm256_cmp_ps(_mm256_loadu_ps(&p.minimumY[i]), colliderMaximumY, _CMP_LE_OQ)));
+		hit = _mm256_and_ps(hit, _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(&p.maximumZ[i]), colliderMinimumZ, _CMP_GE_OQ), _mm256_cmp_ps(_mm256_loadu_ps(&p.minimumZ[i]), colliderMaximumZ, _CMP_LE_OQ)));
+		hitMask[k / 32] |= static_cast<uint32_t>(_mm256_movemask_ps(hit)) << (k % 32);
+	}
+	return k;
+}
+#endif
+
+void OverlapAabbBatch(const ParticleStore& particles, size_t begin, size_t count, const AABB& collider, uint32_t* hitMask)
+{
+	OverlapAabbBatch(particles, begin, count, collider, hitMask, GetBestAabbKernel());
+}
+
+void OverlapAabbBatch(const ParticleStore& particles, size_t begin, size_t count, const AABB& collider, uint32_t* hitMask, AabbKernelLevel level)
+{
+	if (!IsAabbKernelSupported(level)) level = GetBestAabbKernel();
+
+	//The vector loads read straight through memory, so the batch is worked through one particle chunk at a time
+	size_t k = 0;
+	while (k < count)
+	{
+		size_t chunkEnd = std::min(count, ((((begin + k) >> particleChunkBits) + 1) << particleChunkBits) - begin);
+
+		//Scalar up to the first whole group of 8 so the vector loops never split their bits over two mask words
+		size_t vectorFirst = std::min(chunkEnd, (k + 7) & ~static_cast<size_t>(7));
+		OverlapScalar(particles, begin, k, vectorFirst, collider, hitMask);
+
+		size_t handled = vectorFirst;
+#if defined(SIMD_HAS_AVX2)
+		if (level == AABB_KERNEL_AVX2) handled = OverlapAvx2(particles, begin, vectorFirst, chunkEnd, collider, hitMask);
+#endif
+#if defined(SIMD_HAS_SSE)
+		if (level == AABB_KERNEL_SSE) handled = OverlapSse(particles, begin, vectorFirst, chunkEnd, collider, hitMask);
+#endif
+
+		//Whatever did not fill a whole vector, or everything if there is no SIMD
+		OverlapScalar(particles, begin, handled, chunkEnd, collider, hitMask);
+		k = chunkEnd;
+	}
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Bounds.h"
+#include "ParticleStore.h"
+
+//Instruction sets the overlap kernel can run with, picked at runtime from what the CPU supports
+enum AabbKernelLevel
+{
+	AABB_KERNEL_SCALAR,
+	AABB_KERNEL_SSE,	//4 particles per instruction
+	AABB_KERNEL_AVX2	//8 particles per instruction
+};
+
+//Best level this CPU and build can run, worked out with CPUID the first time it is asked
+AabbKernelLevel GetBestAabbKernel();
+bool IsAabbKernelSupported(AabbKernelLevel level);
+const char* GetAabbKernelName(AabbKernelLevel level);
+
+//Number of 32 bit words needed to hold one hit bit per particle
+inline size_t GetHitMaskWords(size_t count) { return (count + 31) / 32; }
+
+//Tests particles [begin, begin + count) against collider using the SoA bounds in particles
+//Bit k of hitMask[w] is set if particle begin + w * 32 + k overlaps, hitMask needs GetHitMaskWords(count) words
+//Bits are only ever set, never cleared, so one zeroed mask can collect the hits from several colliders
+void OverlapAabbBatch(const ParticleStore& particles, size_t begin, size_t count, const AABB& collider, uint32_t* hitMask);
+//Same as above but forces a specific level, used to compare them
+void OverlapAabbBatch(const ParticleStore& particles, size_t begin, size_t count, const AABB& collider, uint32_t* hitMask, AabbKernelLevel level);
@@ -0,0 +1,142 @@
+#include "AssetQueue.h"
+
+namespace
+{
+	double MillisecondsBetween(std::chrono::steady_clock::time_point startTime, std::chrono::steady_clock::time_point endTime)
+	{
+		return std::chrono::duration<double, std::milli>(endTime - startTime).count();
+	}
+}
+
+AssetQueue::AssetQueue(unsigned int threadCount)
+	: m_FinishedCount(0), m_Quit(false)
+{
+	if (threadCount == 0)
+	{
+		unsigned int coreCount = std::thread::hardware_concurrency();
+		threadCount = coreCount > 1 ? coreCount - 1 : 1;
+	}
+	for (unsigned int i = 0; i < threadCount; i++)
+	{
+		m_Workers.push_back(std::thread(&AssetQueue::workerLoop, this));
+	}
+}
+
+AssetQueue::~AssetQueue()
+{
+	shutdown();
+}
+
+void AssetQueue::shutdown()
+{
+	//Loads already running finish, anything still queued is dropped
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Quit = true;
+	}
+	m_WorkAvailable.notify_all();
+	for (std::thread& worker : m_Workers)
+	{
+		if (worker.joinable()) worker.join();
+	}
+}
+
+AssetHandle AssetQueue::request(const std::string& name, LoadFunction load, UploadFunction upload)
+{
+	std::unique_ptr<Asset> asset(new Asset);
+	asset->name = name;
+	asset->load = std::move(load);
+	asset->upload = std::move(upload);
+	asset->state.store(ASSET_LOADING, std::memory_order_relaxed);
+	asset->loaded = false;
+	asset->requestTime = Clock::now();
+	asset->timing = AssetTiming();
+
+	AssetHandle handle = static_cast<AssetHandle>(m_Assets.size());
+	Asset* queuedAsset = asset.get();
+	m_Assets.push_back(std::move(asset));
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_LoadQueue.push_back(queuedAsset);
+	}
+	m_WorkAvailable.notify_one();
+	return handle;
+}
+
+void AssetQueue::workerLoop()
+{
+	for (;;)
+	{
+		Asset* asset;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_WorkAvailable.wait(lock, [this] { return m_Quit || !m_LoadQueue.empty(); });
+			if (m_Quit) return;
+			asset = m_LoadQueue.front();
+			m_LoadQueue.pop_front();
+		}
+
+		asset->loadStartTime = Clock::now();
+		asset->loaded = asset->load(asset->error);
+		asset->loadEndTime = Clock::now();
+
+		//Failures still go through the upload queue so the render thread is the only one that finishes assets
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		asset->state.store(ASSET_UPLOADING, std::memory_order_release);
+		m_UploadQueue.push_back(asset);
+	}
+}
+
+unsigned int AssetQueue::processUploads(double budgetMilliseconds)
+{
+	Clock::time_point startTime = Clock::now();
+	unsigned int uploadCount = 0;
+	for (;;)
+	{
+		Asset* asset;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (m_UploadQueue.empty()) break;
+			asset = m_UploadQueue.front();
+			m_UploadQueue.pop_front();
+		}
+
+		Clock::time_point uploadStartTime = Clock::now();
+		if (asset->loaded)
+		{
+			asset->upload();
+			uploadCount++;
+		}
+		Clock::time_point uploadEndTime = Clock::now();
+
+		//Nothing needs the functions again, so whatever they captured is freed now rather than with the queue
+		asset->load = LoadFunction();
+		asset->upload = UploadFunction();
+
+		AssetTiming& timing = asset->timing;
+		timing.queuedMilliseconds = MillisecondsBetween(asset->requestTime, asset->loadStartTime);
+		timing.loadMilliseconds = MillisecondsBetween(asset->loadStartTime, asset->loadEndTime);
+		timing.waitingMilliseconds = MillisecondsBetween(asset->loadEndTime, uploadStartTime);
+		timing.uploadMilliseconds = MillisecondsBetween(uploadStartTime, uploadEndTime);
+		timing.latencyMilliseconds = MillisecondsBetween(asset->requestTime, uploadEndTime);
+		asset->state.store(asset->loaded ? ASSET_READY : ASSET_FAILED, std::memory_order_release);
+		m_FinishedCount++;
+
+		if (MillisecondsBetween(startTime, Clock::now()) >= budgetMilliseconds) break;
+	}
+	return uploadCount;
+}
+
+void AssetQueue::printReport(FILE* output) const
+{
+	fprintf(output, "%-24s %8s %10s %10s %10s %10s %10s\n", "asset", "state", "queued", "load", "waiting", "upload", "latency");
+	for (const std::unique_ptr<Asset>& asset : m_Assets)
+	{
+		AssetState state = asset->state.load(std::memory_order_acquire);
+		if (state != ASSET_READY && state != ASSET_FAILED) continue;
+
+		const AssetTiming& timing = asset->timing;
+		fprintf(output, "%-24s %8s %10.2f %10.2f %10.2f %10.2f %10.2f\n", asset->name.c_str(), state == ASSET_READY ? "ready" : "failed",
+			timing.queuedMilliseconds, timing.loadMilliseconds, timing.waitingMilliseconds, timing.uploadMilliseconds, timing.latencyMilliseconds);
+	}
+}
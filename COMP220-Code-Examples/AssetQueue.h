@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//Lightweight reference to an asset requested from an AssetQueue
+typedef unsigned int AssetHandle;
+const AssetHandle invalidAssetHandle = ~0u;
+
+enum AssetState
+{
+	//Waiting for or running on a worker thread
+	ASSET_LOADING,
+	//Load has finished, whether or not it worked, and is waiting for its turn in processUploads
+	ASSET_UPLOADING,
+	//Only ever set by processUploads, once the timing and error are filled in
+	ASSET_READY,
+	ASSET_FAILED
+};
+
+//How long each part of an assets load took, all in milliseconds
+struct AssetTiming
+{
+	//From the request to a worker picking it up
+	double queuedMilliseconds;
+	//Running the load function on the worker
+	double loadMilliseconds;
+	//From the load finishing to processUploads getting to it
+	double waitingMilliseconds;
+	//Running the upload function on the render thread
+	double uploadMilliseconds;
+	//From the request to the asset being ready, everything above added up
+	double latencyMilliseconds;
+};
+
+//Loads assets on worker threads and hands them back to the render thread to upload, a little at a time each frame
+//The load half does the file reading and decoding that can happen anywhere, the upload half does whatever needs the GL context
+//Everything but the load functions belongs to the one thread that makes the requests
+class AssetQueue
+{
+public:
+	//Runs on a worker thread, returns false and fills in error if the asset could not be loaded
+	typedef std::function<bool(std::string& error)> LoadFunction;
+	//Runs on the thread calling processUploads once the load has succeeded
+	typedef std::function<void()> UploadFunction;
+
+	//0 uses one worker per hardware core, leaving one for the render thread
+	explicit AssetQueue(unsigned int threadCount = 0);
+	~AssetQueue();
+
+	//Waits for loads already running to finish and drops anything still queued, after this no worker touches what a load function captured
+	//Call it before destroying anything the load functions write to, the destructor calls it too
+	void shutdown();
+
+	//Queues the load straight away and returns without waiting for it, name is only used in the report
+	AssetHandle request(const std::string& name, LoadFunction load, UploadFunction upload);
+
+	//Runs the uploads of loaded assets in the order they finished loading until budgetMilliseconds has gone
+	//Always runs at least one if any are waiting, so a single large upload still gets through, returns how many ran
+	unsigned int processUploads(double budgetMilliseconds);
+
+	AssetState getState(AssetHandle handle) const { return m_Assets[handle]->state.load(std::memory_order_acquire); }
+	//Only filled in once the asset is ready or has failed
+	const AssetTiming& getTiming(AssetHandle handle) const { return m_Assets[handle]->timing; }
+	//Why the load failed, only filled in once the asset has failed
+	const std::string& getError(AssetHandle handle) const { return m_Assets[handle]->error; }
+	const std::string& getName(AssetHandle handle) const { return m_Assets[handle]->name; }
+	size_t getAssetCount() const { return m_Assets.size(); }
+	//True once every requested asset is ready or has failed
+	bool isFinished() const { return m_FinishedCount == m_Assets.size(); }
+	unsigned int getThreadCount() const { return static_cast<unsigned int>(m_Workers.size()); }
+
+	//Prints the timing of every finished asset
+	void printReport(FILE* output) const;
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Asset
+	{
+		std::string name;
+		LoadFunction load;
+		UploadFunction upload;
+		std::atomic<AssetState> state;
+		//Written by the worker before it queues the upload, only read by processUploads after that
+		bool loaded;
+		std::string error;
+		Clock::time_point requestTime;
+		Clock::time_point loadStartTime;
+		Clock::time_point loadEndTime;
+		AssetTiming timing;
+	};
+
+	void workerLoop();
+
+	//Only touched by the thread making requests, workers are handed Asset pointers so this can grow under them
+	std::vector<std::unique_ptr<Asset>> m_Assets;
+	size_t m_FinishedCount;
+
+	std::vector<std::thread> m_Workers;
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkAvailable;
+	std::deque<Asset*> m_LoadQueue;
+	//Loaded on a worker, waiting for processUploads
+	std::deque<Asset*> m_UploadQueue;
+	bool m_Quit;
+};
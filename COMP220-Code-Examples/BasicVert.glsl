@@ -3,6 +3,8 @@
 layout(location = 0) in vec3 vertexPosition;
 layout(location = 1) in vec3 vertexNormal;
 layout(location = 2) in vec2 vertexUV;
+//Per-instance attribute, particle position in xyz and its uniform scale in w
+layout(location = 3) in vec4 instancePositionScale;
 
 out vec3 vertNorm;
 out vec2 vertUV;
@@ -10,9 +12,21 @@ out vec2 vertUV;
 uniform mat4 transform;
 uniform mat4 transform2;
 
+//When instanced is set each vertex is placed using its instance attribute and viewProjection instead of transform
+uniform bool instanced;
+uniform mat4 viewProjection;
+
 void main()
 {
-	gl_Position = transform * vec4(vertexPosition, 1.0f);
+	if (instanced)
+	{
+		vec3 worldPosition = vertexPosition * instancePositionScale.w + instancePositionScale.xyz;
+		gl_Position = viewProjection * vec4(worldPosition, 1.0f);
+	}
+	else
+	{
+		gl_Position = transform * vec4(vertexPosition, 1.0f);
+	}
 
 	//vec3 newVertexPosition = vertexPosition;
 	//gl_Position = vec4(newVertexPosition,1.0f);
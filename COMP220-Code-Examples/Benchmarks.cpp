@@ -0,0 +1,1364 @@
+#include "Benchmarks.h"
+#include "Headless.h"
+#include "JobSystem.h"
+#include "AabbKernel.h"
+#include "AssetQueue.h"
+#include "FixedTimestep.h"
+#include "SimulationThread.h"
+#include "MemoryStats.h"
+#include "MeshCache.h"
+#include "ParticleStore.h"
+#include "Random.h"
+#include "UniformGrid.h"
+#include "VerletIntegrator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+//Side length of the particles and colliders the benchmarks scatter around
+const float benchmarkParticleSize = 0.01f;
+const float benchmarkColliderSize = 0.05f;
+
+static float RandomRange(float minimum, float maximum)
+{
+	return minimum + static_cast<float>(rand()) / RAND_MAX * (maximum - minimum);
+}
+
+static double MillisecondsSince(std::chrono::steady_clock::time_point startTime)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+//Heap counts only cover the particle allocator unless the replacement operator new is linked in, so says so rather than under-report quietly
+static void PrintAllocationCountingNote()
+{
+	if (!IsOperatorNewCounted()) printf("operator new is not counted in this build, run ParticleSimHeadless for the full heap figures\n");
+}
+
+//Fills the store with moving particles spread through a cube, worldSize wide, with their bounds already set
+static void ScatterParticles(ParticleStore& particles, size_t numOfParticles, float worldSize)
+{
+	particles.resize(0);
+	particles.resize(numOfParticles);
+	float halfSize = benchmarkParticleSize * 0.5f;
+	for (size_t i = 0; i < numOfParticles; i++)
+	{
+		particles.positionX[i] = RandomRange(-worldSize, worldSize);
+		particles.positionY[i] = RandomRange(-worldSize, worldSize);
+		particles.positionZ[i] = RandomRange(-worldSize, worldSize);
+		particles.minimumX[i] = particles.positionX[i] - halfSize;
+		particles.minimumY[i] = particles.positionY[i] - halfSize;
+		particles.minimumZ[i] = particles.positionZ[i] - halfSize;
+		particles.maximumX[i] = particles.positionX[i] + halfSize;
+		particles.maximumY[i] = particles.positionY[i] + halfSize;
+		particles.maximumZ[i] = particles.positionZ[i] + halfSize;
+		particles.state[i] = PARTICLE_MOVING;
+	}
+}
+
+static std::vector<AABB> ScatterColliders(size_t numOfColliders, float worldSize)
+{
+	std::vector<AABB> colliders;
+	for (size_t c = 0; c < numOfColliders; c++)
+	{
+		glm::vec3 centre = glm::vec3(RandomRange(-worldSize, worldSize), RandomRange(-worldSize, worldSize), RandomRange(-worldSize, worldSize));
+		AABB collider = { centre - glm::vec3(benchmarkColliderSize * 0.5f), centre + glm::vec3(benchmarkColliderSize * 0.5f) };
+		colliders.push_back(collider);
+	}
+	return colliders;
+}
+
+static bool ParticleOverlaps(const ParticleStore& p, size_t i, const AABB& collider)
+{
+	return
+		p.maximumX[i] >= collider.minimum.x && p.minimumX[i] <= collider.maximum.x &&
+		p.maximumY[i] >= collider.minimum.y && p.minimumY[i] <= collider.maximum.y &&
+		p.maximumZ[i] >= collider.minimum.z && p.minimumZ[i] <= collider.maximum.z;
+}
+
+static bool ParticlesOverlap(const ParticleStore& p, size_t i, size_t j)
+{
+	return
+		p.maximumX[i] >= p.minimumX[j] && p.minimumX[i] <= p.maximumX[j] &&
+		p.maximumY[i] >= p.minimumY[j] && p.minimumY[i] <= p.maximumY[j] &&
+		p.maximumZ[i] >= p.minimumZ[j] && p.minimumZ[i] <= p.maximumZ[j];
+}
+
+int RunBroadphaseBenchmark(int argc, char** argv)
+{
+	size_t numOfColliders = 1024;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--colliders") == 0 && i + 1 < argc) numOfColliders = strtoul(argv[++i], nullptr, 10);
+	}
+
+	//Brute force is skipped once it would need more than this many AABB tests
+	const double bruteForceTestLimit = 2e9;
+	const size_t particleCounts[] = { 1000, 10000, 100000, 1000000 };
+
+	printf("%10s %10s %12s %12s %12s %12s %10s %12s %12s %10s\n", "particles", "colliders", "build ms", "query ms", "brute ms", "candidates", "hits",
+		"pairs ms", "pair brute", "pair hits");
+
+	for (size_t run = 0; run < sizeof(particleCounts) / sizeof(particleCounts[0]); run++)
+	{
+		size_t numOfParticles = particleCounts[run];
+		//Grows the world with the particle count so the density, and so the work per particle, stays the same
+		float worldSize = 0.5f * std::cbrt(static_cast<float>(numOfParticles) / 1000.0f);
+
+		srand(1);
+		ParticleStore particles;
+		ScatterParticles(particles, numOfParticles, worldSize);
+		std::vector<AABB> colliders = ScatterColliders(numOfColliders, worldSize);
+		//A ground plane and a particle stretched across the world cover too many cells to bucket, so the grid's fallback is checked too
+		AABB groundPlane = { glm::vec3(-worldSize, -worldSize, -worldSize), glm::vec3(worldSize, -worldSize + benchmarkParticleSize, worldSize) };
+		colliders.push_back(groundPlane);
+		particles.minimumX[0] = particles.minimumY[0] = -worldSize;
+		particles.maximumX[0] = particles.maximumY[0] = worldSize;
+
+		UniformGrid grid;
+		grid.setCellSize(benchmarkParticleSize * 2.0f);
+		std::vector<CollisionPair> pairs;
+
+		auto startTime = std::chrono::steady_clock::now();
+		grid.build(particles, true);
+		double buildMilliseconds = MillisecondsSince(startTime);
+
+		startTime = std::chrono::steady_clock::now();
+		grid.findColliderPairs(particles, colliders, pairs);
+		size_t gridHits = 0;
+		for (size_t pair = 0; pair < pairs.size(); pair++)
+		{
+			if (ParticleOverlaps(particles, pairs[pair].particle, colliders[pairs[pair].other])) gridHits++;
+		}
+		double queryMilliseconds = MillisecondsSince(startTime);
+
+		char bruteForceText[32] = "-";
+		if (static_cast<double>(numOfParticles) * numOfColliders <= bruteForceTestLimit)
+		{
+			startTime = std::chrono::steady_clock::now();
+			size_t bruteForceHits = 0;
+			for (size_t i = 0; i < numOfParticles; i++)
+			{
+				for (size_t c = 0; c < colliders.size(); c++)
+				{
+					if (ParticleOverlaps(particles, i, colliders[c])) bruteForceHits++;
+				}
+			}
+			snprintf(bruteForceText, sizeof(bruteForceText), "%.2f", MillisecondsSince(startTime));
+			if (bruteForceHits != gridHits)
+			{
+				printf("grid found %zu hits but brute force found %zu\n", gridHits, bruteForceHits);
+				return 1;
+			}
+		}
+
+		//Particle against particle, the grid's pairs have to find exactly the overlaps testing every pair once does
+		std::vector<CollisionPair> particlePairs;
+		startTime = std::chrono::steady_clock::now();
+		grid.findParticlePairs(particles, particlePairs);
+		size_t gridPairHits = 0;
+		for (size_t pair = 0; pair < particlePairs.size(); pair++)
+		{
+			if (ParticlesOverlap(particles, particlePairs[pair].particle, particlePairs[pair].other)) gridPairHits++;
+		}
+		double pairMilliseconds = MillisecondsSince(startTime);
+
+		char bruteForcePairText[32] = "-";
+		if (static_cast<double>(numOfParticles) * numOfParticles * 0.5 <= bruteForceTestLimit)
+		{
+			startTime = std::chrono::steady_clock::now();
+			size_t bruteForcePairHits = 0;
+			for (size_t i = 0; i < numOfParticles; i++)
+			{
+				for (size_t j = i + 1; j < numOfParticles; j++)
+				{
+					if (ParticlesOverlap(particles, i, j)) bruteForcePairHits++;
+				}
+			}
+			snprintf(bruteForcePairText, sizeof(bruteForcePairText), "%.2f", MillisecondsSince(startTime));
+			if (bruteForcePairHits != gridPairHits)
+			{
+				printf("grid found %zu particle pairs but brute force found %zu\n", gridPairHits, bruteForcePairHits);
+				return 1;
+			}
+		}
+
+		printf("%10zu %10zu %12.2f %12.2f %12s %12zu %10zu %12.2f %12s %10zu\n", numOfParticles, colliders.size(), buildMilliseconds, queryMilliseconds, bruteForceText, pairs.size(), gridHits,
+			pairMilliseconds, bruteForcePairText, gridPairHits);
+	}
+
+	return 0;
+}
+
+int RunThreadScalingBenchmark(int argc, char** argv)
+{
+	unsigned int numOfParticles = 1000000;
+	unsigned int numOfSteps = 100;
+	unsigned int numOfColliders = 1;
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--particles") == 0 && hasValue) numOfParticles = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--steps") == 0 && hasValue) numOfSteps = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--colliders") == 0 && hasValue) numOfColliders = strtoul(argv[++i], nullptr, 10);
+	}
+
+	//Doubles up to the core count, then makes sure the core count itself is measured too
+	std::vector<unsigned int> threadCounts;
+	unsigned int coreCount = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned int threads = 1; threads < coreCount; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(coreCount);
+
+	printf("%d cores, %u particles, %u colliders, %u steps\n", coreCount, numOfParticles, numOfColliders, numOfSteps);
+	printf("%8s %12s %10s %12s\n", "threads", "steps/sec", "speedup", "collisions");
+
+	double singleThreadStepsPerSecond = 0.0;
+	for (size_t run = 0; run < threadCounts.size(); run++)
+	{
+		//Same seed every run so each thread count simulates exactly the same particles
+		srand(1);
+		JobSystem jobSystem(threadCounts[run]);
+		ParticleSimulation simulation;
+		simulation.setJobSystem(&jobSystem);
+		SetUpHeadlessScene(simulation, numOfColliders);
+		simulation.spawn(numOfParticles);
+
+		auto startTime = std::chrono::steady_clock::now();
+		for (unsigned int i = 0; i < numOfSteps; i++)
+		{
+			simulation.step(1.0f / 60.0f);
+		}
+		double stepsPerSecond = numOfSteps / (MillisecondsSince(startTime) / 1000.0);
+		if (run == 0) singleThreadStepsPerSecond = stepsPerSecond;
+
+		printf("%8u %12.1f %9.2fx %12u\n", threadCounts[run], stepsPerSecond, stepsPerSecond / singleThreadStepsPerSecond, simulation.getCollisionCount());
+	}
+
+	return 0;
+}
+
+int RunAabbKernelBenchmark(int argc, char** argv)
+{
+	size_t numOfParticles = 1000000;
+	unsigned int numOfRepeats = 50;
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--particles") == 0 && hasValue) numOfParticles = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--repeats") == 0 && hasValue) numOfRepeats = strtoul(argv[++i], nullptr, 10);
+	}
+
+	srand(1);
+	ParticleStore particles;
+	ScatterParticles(particles, numOfParticles, 1.0f);
+	//Roughly the glass, a thin pane a quarter of the particles straddle in x and y
+	AABB collider = { glm::vec3(-0.5f, -0.5f, -0.05f), glm::vec3(0.5f, 0.5f, 0.05f) };
+
+	std::vector<uint32_t> scalarMask(GetHitMaskWords(numOfParticles), 0);
+	std::vector<uint32_t> hitMask(scalarMask.size(), 0);
+
+	printf("best kernel: %s, %zu particles, %u repeats\n", GetAabbKernelName(GetBestAabbKernel()), numOfParticles, numOfRepeats);
+	printf("%8s %14s %10s %10s\n", "kernel", "Mparticles/s", "speedup", "hits");
+
+	double scalarRate = 0.0;
+	const AabbKernelLevel levels[] = { AABB_KERNEL_SCALAR, AABB_KERNEL_SSE, AABB_KERNEL_AVX2 };
+	for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++)
+	{
+		if (!IsAabbKernelSupported(levels[l])) continue;
+
+		std::vector<uint32_t>& mask = levels[l] == AABB_KERNEL_SCALAR ? scalarMask : hitMask;
+		auto startTime = std::chrono::steady_clock::now();
+		for (unsigned int r = 0; r < numOfRepeats; r++)
+		{
+			std::fill(mask.begin(), mask.end(), 0u);
+			OverlapAabbBatch(particles, 0, numOfParticles, collider, &mask[0], levels[l]);
+		}
+		double rate = static_cast<double>(numOfParticles) * numOfRepeats / (MillisecondsSince(startTime) * 1000.0);
+		if (levels[l] == AABB_KERNEL_SCALAR) scalarRate = rate;
+
+		size_t hits = 0;
+		for (size_t w = 0; w < mask.size(); w++)
+		{
+			for (uint32_t bits = mask[w]; bits != 0; bits &= bits - 1) hits++;
+		}
+		if (mask != scalarMask)
+		{
+			printf("%s kernel does not match the scalar kernel\n", GetAabbKernelName(levels[l]));
+			return 1;
+		}
+
+		printf("%8s %14.1f %9.2fx %10zu\n", GetAabbKernelName(levels[l]), rate, rate / scalarRate, hits);
+	}
+
+	return 0;
+}
+
+int RunStorageBenchmark(int argc, char** argv)
+{
+	unsigned int maxParticles = 10000000;
+	unsigned int growBy = 1000000;
+	unsigned int numOfColliders = 1;
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--max-particles") == 0 && hasValue) maxParticles = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--grow-by") == 0 && hasValue) growBy = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--colliders") == 0 && hasValue) numOfColliders = strtoul(argv[++i], nullptr, 10);
+	}
+
+	if (growBy == 0) growBy = 1;
+
+	srand(1);
+	ParticleSimulation simulation;
+	SetUpHeadlessScene(simulation, numOfColliders);
+	simulation.spawn(0);
+	const ParticleStore& particles = simulation.getParticles();
+
+	printf("%zu particles per chunk, growing by %u up to %u particles\n", particleChunkSize, growBy, maxParticles);
+	PrintAllocationCountingNote();
+	printf("%12s %8s %10s %10s %12s %12s %8s\n", "particles", "chunks", "grow ms", "step ms", "live MB", "bytes/each", "moved");
+
+	//Addresses of the first particle and of the last one before each growth, neither should ever change
+	const float* firstAddress = nullptr;
+	const float* lastAddress = nullptr;
+	size_t lastIndex = 0;
+	unsigned int movedCount = 0;
+	while (particles.size() < maxParticles)
+	{
+		unsigned int numToAdd = std::min(growBy, maxParticles - static_cast<unsigned int>(particles.size()));
+		auto growStart = std::chrono::steady_clock::now();
+		simulation.addParticles(numToAdd);
+		double growMilliseconds = MillisecondsSince(growStart);
+
+		bool moved = (firstAddress && &particles.positionX[0] != firstAddress) || (lastAddress && &particles.positionX[lastIndex] != lastAddress);
+		if (moved) movedCount++;
+
+		auto stepStart = std::chrono::steady_clock::now();
+		simulation.step(1.0f / 60.0f);
+		double stepMilliseconds = MillisecondsSince(stepStart);
+
+		firstAddress = &particles.positionX[0];
+		lastIndex = particles.size() - 1;
+		lastAddress = &particles.positionX[lastIndex];
+
+		printf("%12zu %8zu %10.2f %10.2f %12.1f %12.1f %8s\n", particles.size(), particles.positionX.getChunkCount(), growMilliseconds, stepMilliseconds,
+			GetLiveBytes() / (1024.0 * 1024.0), static_cast<double>(GetLiveBytes()) / particles.size(), moved ? "yes" : "no");
+	}
+	printf("peak live %.1f MB, peak resident %.1f MB\n", GetPeakLiveBytes() / (1024.0 * 1024.0), GetPeakResidentBytes() / (1024.0 * 1024.0));
+
+	if (movedCount > 0)
+	{
+		printf("existing particles moved in memory on %u growths\n", movedCount);
+		return 1;
+	}
+	return 0;
+}
+
+int RunEmitterBenchmark(int argc, char** argv)
+{
+	float emitRate = 100000.0f;
+	float numOfSeconds = 10.0f;
+	unsigned int numOfThreads = 1;
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--emit-rate") == 0 && hasValue) emitRate = strtof(argv[++i], nullptr);
+		else if (strcmp(argv[i], "--seconds") == 0 && hasValue) numOfSeconds = strtof(argv[++i], nullptr);
+		else if (strcmp(argv[i], "--threads") == 0 && hasValue) numOfThreads = strtoul(argv[++i], nullptr, 10);
+	}
+
+	srand(1);
+	JobSystem jobSystem(numOfThreads);
+	ParticleSimulation simulation;
+	simulation.setJobSystem(&jobSystem);
+	SetUpHeadlessScene(simulation, 1);
+	simulation.setDeletionDelay(0.5f);
+	simulation.spawn(0);
+
+	//A thin slab just in front of the glass, so particles reach it within a couple of seconds and the run settles quickly
+	ParticleEmitter emitter = CreateSpawnEmitter(emitRate);
+	AABB spawnVolume = { glm::vec3(-1.0f, -1.0f, 0.2f), glm::vec3(1.0f, 1.0f, 0.35f) };
+	emitter.setSpawnVolume(spawnVolume);
+	simulation.addEmitter(emitter);
+
+	const float deltaTime = 1.0f / 60.0f;
+	const unsigned int stepsPerSecond = 60;
+	unsigned int numOfSteps = static_cast<unsigned int>(numOfSeconds * stepsPerSecond);
+
+	printf("%.0f particles/s for %.1f s, %u threads\n", emitRate, numOfSeconds, jobSystem.getThreadCount());
+	printf("%8s %12s %12s %12s %10s\n", "seconds", "emitted", "live", "slots", "step ms");
+
+	double intervalMilliseconds = 0.0;
+	for (unsigned int s = 1; s <= numOfSteps; s++)
+	{
+		auto stepStart = std::chrono::steady_clock::now();
+		simulation.step(deltaTime);
+		intervalMilliseconds += MillisecondsSince(stepStart);
+
+		if (s % stepsPerSecond == 0 || s == numOfSteps)
+		{
+			unsigned int intervalSteps = s % stepsPerSecond == 0 ? stepsPerSecond : s % stepsPerSecond;
+			printf("%8.1f %12llu %12u %12u %10.3f\n", s * deltaTime, simulation.getEmitter(0).getEmittedCount(), simulation.getLiveParticleCount(), simulation.getParticleCount(), intervalMilliseconds / intervalSteps);
+			intervalMilliseconds = 0.0;
+		}
+	}
+
+	//Without slot reuse the store would hold every particle ever emitted
+	printf("store holds %u slots for %llu particles emitted (%.1f%%)\n", simulation.getParticleCount(), simulation.getEmitter(0).getEmittedCount(),
+		100.0 * simulation.getParticleCount() / std::max(1ull, simulation.getEmitter(0).getEmittedCount()));
+	return 0;
+}
+
+int RunCompactionBenchmark(int argc, char** argv)
+{
+	unsigned int numOfParticles = 200000;
+	float numOfSeconds = 24.0f;
+	unsigned int numOfThreads = 1;
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--particles") == 0 && hasValue) numOfParticles = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--seconds") == 0 && hasValue) numOfSeconds = strtof(argv[++i], nullptr);
+		else if (strcmp(argv[i], "--threads") == 0 && hasValue) numOfThreads = strtoul(argv[++i], nullptr, 10);
+	}
+
+	//Same seed for both so they hold exactly the same particles, one never compacts and one uses the default threshold
+	JobSystem jobSystem(numOfThreads);
+	ParticleSimulation simulations[2];
+	for (int s = 0; s < 2; s++)
+	{
+		srand(1);
+		simulations[s].setJobSystem(&jobSystem);
+		SetUpHeadlessScene(simulations[s], 1);
+		simulations[s].spawn(numOfParticles);
+	}
+	simulations[0].setCompactionThreshold(2.0f);
+
+	const float deltaTime = 1.0f / 60.0f;
+	const unsigned int stepsPerSecond = 60;
+	unsigned int numOfSteps = static_cast<unsigned int>(numOfSeconds * stepsPerSecond);
+
+	printf("%u particles for %.1f s, %u threads\n", numOfParticles, numOfSeconds, jobSystem.getThreadCount());
+	printf("%8s %10s | %10s %10s | %10s %10s %12s\n", "seconds", "live", "slots", "step ms", "slots", "step ms", "compactions");
+	printf("%8s %10s | %21s | %34s\n", "", "", "never compacted", "compacted");
+
+	//Steps the two in turn so anything else slowing the machine down hits both equally
+	double intervalMilliseconds[2] = { 0.0, 0.0 };
+	double totalMilliseconds[2] = { 0.0, 0.0 };
+	for (unsigned int step = 1; step <= numOfSteps; step++)
+	{
+		for (int s = 0; s < 2; s++)
+		{
+			auto stepStart = std::chrono::steady_clock::now();
+			simulations[s].step(deltaTime);
+			double stepMilliseconds = MillisecondsSince(stepStart);
+			intervalMilliseconds[s] += stepMilliseconds;
+			totalMilliseconds[s] += stepMilliseconds;
+		}
+
+		if (step % stepsPerSecond == 0 || step == numOfSteps)
+		{
+			unsigned int intervalSteps = step % stepsPerSecond == 0 ? stepsPerSecond : step % stepsPerSecond;
+			printf("%8.1f %10u | %10u %10.3f | %10u %10.3f %12u\n", step * deltaTime, simulations[1].getLiveParticleCount(),
+				simulations[0].getParticleCount(), intervalMilliseconds[0] / intervalSteps,
+				simulations[1].getParticleCount(), intervalMilliseconds[1] / intervalSteps, simulations[1].getCompactionCount());
+			intervalMilliseconds[0] = intervalMilliseconds[1] = 0.0;
+		}
+	}
+
+	printf("total: never compacted %.1f ms, compacted %.1f ms (%.2fx)\n", totalMilliseconds[0], totalMilliseconds[1], totalMilliseconds[0] / totalMilliseconds[1]);
+	//Compaction must not change what happens to the particles, only where they are stored
+	if (simulations[0].getCollisionCount() != simulations[1].getCollisionCount() || simulations[0].getDeletionCount() != simulations[1].getDeletionCount())
+	{
+		printf("compacted run does not match, %u/%u collisions and %u/%u deletions\n", simulations[1].getCollisionCount(), simulations[0].getCollisionCount(),
+			simulations[1].getDeletionCount(), simulations[0].getDeletionCount());
+		return 1;
+	}
+	return 0;
+}
+
+//FNV-1a over the bits of every spawned position and velocity, any difference at all changes it
+static uint64_t HashSpawnedParticles(const ParticleStore& p)
+{
+	uint64_t hash = 14695981039346656037ull;
+	const ChunkedArray<float>* fields[] = { &p.positionX, &p.positionY, &p.positionZ, &p.velocityX, &p.velocityY, &p.velocityZ };
+	for (size_t f = 0; f < sizeof(fields) / sizeof(fields[0]); f++)
+	{
+		for (size_t i = 0; i < p.size(); i++)
+		{
+			uint32_t bits;
+			memcpy(&bits, &(*fields[f])[i], sizeof(bits));
+			hash = (hash ^ bits) * 1099511628211ull;
+		}
+	}
+	return hash;
+}
+
+int RunSpawnBenchmark(int argc, char** argv)
+{
+	unsigned int numOfParticles = 4000000;
+	uint64_t seed = 1;
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--particles") == 0 && hasValue) numOfParticles = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--seed") == 0 && hasValue) seed = strtoull(argv[++i], nullptr, 10);
+	}
+
+	//The bulk fill on its own at each level, into one buffer the size of a particle chunk
+	std::vector<float> values(particleChunkSize);
+	unsigned int fillRepeats = std::max(1u, numOfParticles / static_cast<unsigned int>(particleChunkSize));
+	printf("bulk fill, %zu values x %u\n", values.size(), fillRepeats);
+	printf("%8s %14s %10s\n", "kernel", "Mvalues/s", "speedup");
+
+	//What spawn used to do, rand() one number at a time
+	srand(1);
+	auto randStart = std::chrono::steady_clock::now();
+	for (unsigned int r = 0; r < fillRepeats; r++)
+	{
+		for (size_t i = 0; i < values.size(); i++) values[i] = static_cast<float>(rand()) / RAND_MAX * 2.0f - 1.0f;
+	}
+	double randRate = static_cast<double>(values.size()) * fillRepeats / (MillisecondsSince(randStart) * 1000.0);
+	printf("%8s %14.1f %9.2fx\n", "rand()", randRate, 1.0);
+
+	const AabbKernelLevel levels[] = { AABB_KERNEL_SCALAR, AABB_KERNEL_SSE, AABB_KERNEL_AVX2 };
+	uint64_t key = MakeRandomKey(seed, 0);
+	for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++)
+	{
+		if (!IsAabbKernelSupported(levels[l])) continue;
+
+		auto startTime = std::chrono::steady_clock::now();
+		for (unsigned int r = 0; r < fillRepeats; r++)
+		{
+			FillRandomRange(key, r * static_cast<uint32_t>(values.size()), -1.0f, 1.0f, &values[0], values.size(), levels[l]);
+		}
+		double rate = static_cast<double>(values.size()) * fillRepeats / (MillisecondsSince(startTime) * 1000.0);
+		printf("%8s %14.1f %9.2fx\n", GetAabbKernelName(levels[l]), rate, rate / randRate);
+	}
+
+	//Whole spawns on more and more threads, every one has to come out bit for bit the same
+	std::vector<unsigned int> threadCounts;
+	unsigned int coreCount = std::max(1u, std::thread::hardware_concurrency());
+	for (unsigned int threads = 1; threads < coreCount; threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(coreCount);
+	//More threads than cores still has to give the same particles, even if it is not any faster
+	threadCounts.push_back(coreCount * 2 + 1);
+
+	printf("\nspawn, %u particles, seed %llu\n", numOfParticles, static_cast<unsigned long long>(seed));
+	printf("%8s %10s %14s %18s\n", "threads", "ms", "Mparticles/s", "hash");
+
+	uint64_t firstHash = 0;
+	bool allMatch = true;
+	for (size_t run = 0; run < threadCounts.size(); run++)
+	{
+		JobSystem jobSystem(threadCounts[run]);
+		ParticleSimulation simulation;
+		simulation.setJobSystem(&jobSystem);
+		SetUpHeadlessScene(simulation, 1);
+		simulation.setSeed(seed);
+
+		auto startTime = std::chrono::steady_clock::now();
+		simulation.spawn(numOfParticles);
+		double milliseconds = MillisecondsSince(startTime);
+
+		uint64_t hash = HashSpawnedParticles(simulation.getParticles());
+		if (run == 0) firstHash = hash;
+		if (hash != firstHash) allMatch = false;
+		printf("%8u %10.2f %14.1f %18llx%s\n", threadCounts[run], milliseconds, numOfParticles / (milliseconds * 1000.0), static_cast<unsigned long long>(hash), hash == firstHash ? "" : " MISMATCH");
+	}
+
+	if (!allMatch)
+	{
+		printf("spawns on different thread counts do not match\n");
+		return 1;
+	}
+	return 0;
+}
+
+//Scatters moving particles with random velocities, every other one is left stopped so both paths through the integrator are timed
+static void ScatterMovingParticles(ParticleStore& particles, size_t numOfParticles)
+{
+	ScatterParticles(particles, numOfParticles, 1.0f);
+	for (size_t i = 0; i < numOfParticles; i++)
+	{
+		particles.velocityX[i] = RandomRange(-1.0f, 1.0f);
+		particles.velocityY[i] = RandomRange(-1.0f, 1.0f);
+		particles.velocityZ[i] = RandomRange(-1.0f, 1.0f);
+		particles.state[i] = (i % 2 == 0) ? PARTICLE_MOVING : PARTICLE_COLLIDED;
+	}
+}
+
+static bool ParticlesMatch(const ParticleStore& a, const ParticleStore& b)
+{
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		if (a.positionX[i] != b.positionX[i] || a.positionY[i] != b.positionY[i] || a.positionZ[i] != b.positionZ[i]) return false;
+		if (a.velocityX[i] != b.velocityX[i] || a.velocityY[i] != b.velocityY[i] || a.velocityZ[i] != b.velocityZ[i]) return false;
+	}
+	return true;
+}
+
+int RunIntegratorBenchmark(int argc, char** argv)
+{
+	size_t numOfParticles = 1000000;
+	unsigned int numOfSteps = 100;
+	unsigned int numOfThreads = 0;
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--particles") == 0 && hasValue) numOfParticles = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--steps") == 0 && hasValue) numOfSteps = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--threads") == 0 && hasValue) numOfThreads = strtoul(argv[++i], nullptr, 10);
+	}
+
+	//Every force on at once, so the numbers are the worst case
+	IntegratorSettings settings;
+	settings.gravity = glm::vec3(0.0f, -9.81f, 0.0f);
+	settings.wind = glm::vec3(0.5f, 0.0f, 0.2f);
+	settings.drag = 0.3f;
+	settings.constrainToBounds = true;
+	settings.bounds = { glm::vec3(-1.0f), glm::vec3(1.0f) };
+	const float deltaTime = 1.0f / 60.0f;
+
+	srand(1);
+	ParticleStore scalarParticles;
+	ScatterMovingParticles(scalarParticles, numOfParticles);
+
+	printf("best kernel: %s, %zu particles, %u steps, gravity, drag, wind and bounds on\n", GetAabbKernelName(GetBestAabbKernel()), numOfParticles, numOfSteps);
+	printf("%10s %8s %16s %10s\n", "kernel", "threads", "Mparticles/s/core", "speedup");
+
+	//What step used to do, move by velocity and nothing else
+	{
+		srand(1);
+		ParticleStore particles;
+		ScatterMovingParticles(particles, numOfParticles);
+		auto startTime = std::chrono::steady_clock::now();
+		for (unsigned int step = 0; step < numOfSteps; step++)
+		{
+			for (size_t i = 0; i < numOfParticles; i++)
+			{
+				float moveTime = particles.state[i] == PARTICLE_MOVING ? deltaTime : 0.0f;
+				particles.positionX[i] += particles.velocityX[i] * moveTime;
+				particles.positionY[i] += particles.velocityY[i] * moveTime;
+				particles.positionZ[i] += particles.velocityZ[i] * moveTime;
+			}
+		}
+		double rate = static_cast<double>(numOfParticles) * numOfSteps / (MillisecondsSince(startTime) * 1000.0);
+		printf("%10s %8u %16.1f %10s\n", "translate", 1u, rate, "-");
+	}
+
+	//Each level on one thread, a chunk at a time, checked against the scalar results afterwards
+	double scalarRate = 0.0;
+	const AabbKernelLevel levels[] = { AABB_KERNEL_SCALAR, AABB_KERNEL_SSE, AABB_KERNEL_AVX2 };
+	for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++)
+	{
+		if (!IsAabbKernelSupported(levels[l])) continue;
+
+		ParticleStore otherParticles;
+		ParticleStore& particles = levels[l] == AABB_KERNEL_SCALAR ? scalarParticles : otherParticles;
+		if (levels[l] != AABB_KERNEL_SCALAR)
+		{
+			srand(1);
+			ScatterMovingParticles(particles, numOfParticles);
+		}
+
+		auto startTime = std::chrono::steady_clock::now();
+		for (unsigned int step = 0; step < numOfSteps; step++)
+		{
+			for (size_t begin = 0; begin < numOfParticles; begin += particleChunkSize)
+			{
+				IntegrateVerlet(settings, deltaTime, particles, begin, std::min(particleChunkSize, numOfParticles - begin), levels[l]);
+			}
+		}
+		double rate = static_cast<double>(numOfParticles) * numOfSteps / (MillisecondsSince(startTime) * 1000.0);
+		if (levels[l] == AABB_KERNEL_SCALAR) scalarRate = rate;
+
+		if (!ParticlesMatch(particles, scalarParticles))
+		{
+			printf("%s integrator does not match the scalar integrator\n", GetAabbKernelName(levels[l]));
+			return 1;
+		}
+		printf("%10s %8u %16.1f %9.2fx\n", GetAabbKernelName(levels[l]), 1u, rate, rate / scalarRate);
+	}
+
+	//The best level spread over the job system, the same way ParticleSimulation::step runs it
+	JobSystem jobSystem(numOfThreads);
+	ParticleStore particles;
+	srand(1);
+	ScatterMovingParticles(particles, numOfParticles);
+	auto startTime = std::chrono::steady_clock::now();
+	for (unsigned int step = 0; step < numOfSteps; step++)
+	{
+		jobSystem.parallelFor(numOfParticles, particleGrainSize, [&](size_t begin, size_t end, unsigned int)
+		{
+			//A range can hold several grains, so it is cut where the chunks change
+			while (begin < end)
+			{
+				size_t chunkEnd = std::min(end, ((begin >> particleChunkBits) + 1) << particleChunkBits);
+				IntegrateVerlet(settings, deltaTime, particles, begin, chunkEnd - begin);
+				begin = chunkEnd;
+			}
+		});
+	}
+	double rate = static_cast<double>(numOfParticles) * numOfSteps / (MillisecondsSince(startTime) * 1000.0);
+	printf("%10s %8u %16.1f %9.2fx\n", GetAabbKernelName(GetBestAabbKernel()), jobSystem.getThreadCount(), rate / jobSystem.getThreadCount(), rate / scalarRate);
+
+	return 0;
+}
+
+int RunMeshCacheBenchmark(int argc, char** argv)
+{
+	size_t numOfVertices = 1000000;
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--vertices") == 0 && hasValue) numOfVertices = strtoul(argv[++i], nullptr, 10);
+	}
+
+	//A triangle list the size an import would give, one index per vertex
+	srand(1);
+	MeshData mesh;
+	mesh.filePath = "meshcache_benchmark";
+	mesh.texturePath = "tex/crate_color.png";
+	mesh.vertices.resize(numOfVertices);
+	mesh.indices.resize(numOfVertices);
+	for (size_t i = 0; i < numOfVertices; i++)
+	{
+		Vertex& vertex = mesh.vertices[i];
+		vertex.x = RandomRange(-1.0f, 1.0f);
+		vertex.y = RandomRange(-1.0f, 1.0f);
+		vertex.z = RandomRange(-1.0f, 1.0f);
+		vertex.nx = 0.0f;
+		vertex.ny = 1.0f;
+		vertex.nz = 0.0f;
+		vertex.u = RandomRange(0.0f, 1.0f);
+		vertex.v = RandomRange(0.0f, 1.0f);
+		mesh.indices[i] = static_cast<unsigned int>(i);
+	}
+	mesh.localBounds = CalculateLocalBounds(mesh.vertices);
+
+	const std::string cachePath = GetMeshCachePath(mesh.filePath);
+	const uint32_t importFlags = 1;
+	double megabytes = static_cast<double>(numOfVertices * (sizeof(Vertex) + sizeof(unsigned int))) / (1024.0 * 1024.0);
+	printf("%zu vertices, %.1f MB of vertex and index data\n", numOfVertices, megabytes);
+
+	//The cache file stands in for the model here, it is hashed the same way a model is on every load
+	auto startTime = std::chrono::steady_clock::now();
+	if (!WriteMeshCache(cachePath, mesh, 1, 0, importFlags))
+	{
+		printf("Could not write %s\n", cachePath.c_str());
+		return 1;
+	}
+	double writeMilliseconds = MillisecondsSince(startTime);
+
+	startTime = std::chrono::steady_clock::now();
+	uint64_t sourceSize = 0;
+	uint64_t sourceHash = HashFile(cachePath, &sourceSize);
+	double hashMilliseconds = MillisecondsSince(startTime);
+	WriteMeshCache(cachePath, mesh, sourceHash, sourceSize, importFlags);
+
+	startTime = std::chrono::steady_clock::now();
+	MeshData loadedMesh;
+	bool hit = ReadMeshCache(cachePath, sourceHash, sourceSize, importFlags, loadedMesh);
+	double readMilliseconds = MillisecondsSince(startTime);
+
+	printf("%10s %10s %10s\n", "stage", "ms", "MB/s");
+	printf("%10s %10.2f %10.0f\n", "write", writeMilliseconds, megabytes / (writeMilliseconds / 1000.0));
+	printf("%10s %10.2f %10.0f\n", "hash", hashMilliseconds, megabytes / (hashMilliseconds / 1000.0));
+	printf("%10s %10.2f %10.0f\n", "map+copy", readMilliseconds, megabytes / (readMilliseconds / 1000.0));
+
+	bool matches = hit && loadedMesh.texturePath == mesh.texturePath
+		&& loadedMesh.vertices.size() == mesh.vertices.size() && loadedMesh.indices == mesh.indices
+		&& memcmp(loadedMesh.vertices.data(), mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex)) == 0
+		&& loadedMesh.localBounds.minimum == mesh.localBounds.minimum && loadedMesh.localBounds.maximum == mesh.localBounds.maximum;
+
+	//Anything that no longer matches the source has to fall back to importing
+	MeshData rejectedMesh;
+	bool changedSourceMissed = !ReadMeshCache(cachePath, sourceHash + 1, sourceSize, importFlags, rejectedMesh)
+		&& !ReadMeshCache(cachePath, sourceHash, sourceSize + 1, importFlags, rejectedMesh);
+	bool changedImportMissed = !ReadMeshCache(cachePath, sourceHash, sourceSize, importFlags + 1, rejectedMesh);
+
+	//y and nx sit in the top half of the first two 8 byte words, so negating both flips the top bit of each
+	//A hash that only multiplies each word in cannot see that, they cancel out
+	std::vector<Vertex> negatedVertices = mesh.vertices;
+	negatedVertices[0].y = -negatedVertices[0].y;
+	negatedVertices[0].nx = -negatedVertices[0].nx;
+	size_t vertexBytes = mesh.vertices.size() * sizeof(Vertex);
+	if (HashBytes(negatedVertices.data(), vertexBytes) == HashBytes(mesh.vertices.data(), vertexBytes)) changedSourceMissed = false;
+
+	std::vector<char> cacheBytes;
+	if (FILE* file = fopen(cachePath.c_str(), "rb"))
+	{
+		char buffer[65536];
+		size_t bytesRead;
+		while ((bytesRead = fread(buffer, 1, sizeof(buffer), file)) > 0) cacheBytes.insert(cacheBytes.end(), buffer, buffer + bytesRead);
+		fclose(file);
+	}
+	if (FILE* file = fopen(cachePath.c_str(), "wb"))
+	{
+		fwrite(cacheBytes.data(), 1, cacheBytes.size() / 2, file);
+		fclose(file);
+	}
+	bool truncatedMissed = !ReadMeshCache(cachePath, sourceHash, sourceSize, importFlags, rejectedMesh);
+	remove(cachePath.c_str());
+
+	printf("round trip: %s, changed source: %s, changed import: %s, cut short: %s\n", matches ? "exact" : "MISMATCH",
+		changedSourceMissed ? "miss" : "HIT", changedImportMissed ? "miss" : "HIT", truncatedMissed ? "miss" : "HIT");
+	return matches && changedSourceMissed && changedImportMissed && truncatedMissed ? 0 : 1;
+}
+
+int RunContinuousCollisionBenchmark(int argc, char** argv)
+{
+	unsigned int numOfParticles = 100000;
+	unsigned int numOfColliders = 1;
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--particles") == 0 && hasValue) numOfParticles = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--colliders") == 0 && hasValue) numOfColliders = strtoul(argv[++i], nullptr, 10);
+	}
+
+	//Long enough for the particles spawned furthest back to reach the glass
+	const float simulatedSeconds = 25.0f;
+	const float stepSizes[] = { 1.0f / 60.0f, 0.25f, 1.0f, 2.0f, 4.0f };
+
+	printf("%u particles, %u colliders, %.0f simulated seconds per run\n", numOfParticles, numOfColliders, simulatedSeconds);
+	printf("%8s %12s %8s %12s %12s %14s\n", "dt", "mode", "steps", "ms", "collisions", "sim s/wall s");
+
+	for (size_t run = 0; run < sizeof(stepSizes) / sizeof(stepSizes[0]); run++)
+	{
+		for (int continuous = 1; continuous >= 0; continuous--)
+		{
+			//Same seed both times so the two modes see exactly the same particles and colliders
+			srand(1);
+			ParticleSimulation simulation;
+			simulation.setContinuousCollision(continuous != 0);
+			SetUpHeadlessScene(simulation, numOfColliders);
+			simulation.spawn(numOfParticles);
+
+			unsigned int numOfSteps = static_cast<unsigned int>(std::ceil(simulatedSeconds / stepSizes[run]));
+			auto startTime = std::chrono::steady_clock::now();
+			for (unsigned int i = 0; i < numOfSteps; i++)
+			{
+				simulation.step(stepSizes[run]);
+			}
+			double milliseconds = MillisecondsSince(startTime);
+
+			printf("%8.3f %12s %8u %12.1f %12u %14.1f\n", stepSizes[run], continuous ? "continuous" : "end of step", numOfSteps, milliseconds, simulation.getCollisionCount(), numOfSteps * stepSizes[run] / (milliseconds / 1000.0));
+		}
+	}
+
+	return 0;
+}
+
+int RunTimestepBenchmark(int argc, char** argv)
+{
+	unsigned int numOfParticles = 100000;
+	unsigned int numOfColliders = 1;
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--particles") == 0 && hasValue) numOfParticles = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--colliders") == 0 && hasValue) numOfColliders = strtoul(argv[++i], nullptr, 10);
+	}
+
+	//Real seconds of frames fed in per run, the frames are made up so no time is spent rendering
+	const double realSeconds = 20.0;
+	const double frameRates[] = { 30.0, 60.0, 144.0, 1000.0 };
+
+	printf("%u particles, %u colliders, %.0f real seconds of frames per run\n", numOfParticles, numOfColliders, realSeconds);
+	printf("%8s %10s %8s %8s %10s %12s %10s %14s\n", "fps", "stepping", "frames", "steps", "sim s", "collisions", "ms", "sim s/wall s");
+
+	for (size_t run = 0; run < sizeof(frameRates) / sizeof(frameRates[0]); run++)
+	{
+		for (int fixed = 1; fixed >= 0; fixed--)
+		{
+			//Same seed every run so they all simulate exactly the same particles
+			srand(1);
+			ParticleSimulation simulation;
+			SetUpHeadlessScene(simulation, numOfColliders);
+			simulation.spawn(numOfParticles);
+
+			//No step cap here, the frames are free so the simulation can always keep up
+			FixedTimestep timestep(1.0 / 60.0, ~0u);
+			unsigned int numOfFrames = static_cast<unsigned int>(realSeconds * frameRates[run]);
+			unsigned int numOfSteps = 0;
+			double simulatedSeconds = 0.0;
+
+			auto startTime = std::chrono::steady_clock::now();
+			for (unsigned int frame = 0; frame < numOfFrames; frame++)
+			{
+				//The old loop stepped by a 60th of a second every frame however long the frame really took
+				unsigned int frameSteps = fixed ? timestep.advance(1.0 / frameRates[run]) : 1;
+				for (unsigned int step = 0; step < frameSteps; step++)
+				{
+					simulation.step(timestep.getStepSeconds());
+					simulatedSeconds += timestep.getStepSeconds();
+				}
+				numOfSteps += frameSteps;
+			}
+			double milliseconds = MillisecondsSince(startTime);
+
+			printf("%8.0f %10s %8u %8u %10.2f %12u %10.1f %14.1f\n", frameRates[run], fixed ? "fixed" : "per frame", numOfFrames, numOfSteps, simulatedSeconds, simulation.getCollisionCount(), milliseconds, simulatedSeconds / (milliseconds / 1000.0));
+		}
+	}
+
+	return 0;
+}
+
+//Stands in for drawing a frame, reads every instance like an upload would then waits out the rest of the frame
+static float PretendToRender(const ParticleSnapshot& snapshot, double renderMilliseconds)
+{
+	float total = 0.0f;
+	for (size_t i = 0; i < snapshot.instances.size(); i++)
+	{
+		total += snapshot.instances[i];
+	}
+	std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(renderMilliseconds));
+	return total;
+}
+
+int RunPipelineBenchmark(int argc, char** argv)
+{
+	unsigned int numOfParticles = 100000;
+	double runSeconds = 2.0;
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--particles") == 0 && hasValue) numOfParticles = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--seconds") == 0 && hasValue) runSeconds = strtod(argv[++i], nullptr);
+	}
+
+	const double renderCosts[] = { 0.0, 8.0, 33.0, 100.0 };
+	const float stepSeconds = 1.0f / 60.0f;
+
+	printf("%u particles, %.1f s per run, simulation unpaced\n", numOfParticles, runSeconds);
+	printf("%10s %10s %12s %12s %14s %10s\n", "loop", "render ms", "frames/sec", "steps/sec", "sim s/wall s", "skipped");
+
+	float checksum = 0.0f;
+	for (size_t run = 0; run < sizeof(renderCosts) / sizeof(renderCosts[0]); run++)
+	{
+		for (int threaded = 0; threaded <= 1; threaded++)
+		{
+			srand(1);
+			ParticleSimulation simulation;
+			SetUpHeadlessScene(simulation, 1);
+			simulation.spawn(numOfParticles);
+
+			unsigned int numOfFrames = 0;
+			unsigned long long numOfSteps = 0;
+			unsigned long long numOfSkipped = 0;
+			auto startTime = std::chrono::steady_clock::now();
+
+			if (threaded)
+			{
+				SimulationThread simulationThread(simulation, stepSeconds);
+				simulationThread.setRealTime(false);
+				simulationThread.start();
+				while (MillisecondsSince(startTime) < runSeconds * 1000.0)
+				{
+					simulationThread.acquireLatest();
+					checksum += PretendToRender(simulationThread.getLatest(), renderCosts[run]);
+					numOfFrames++;
+				}
+				simulationThread.stop();
+				numOfSteps = simulationThread.getStepCount();
+				numOfSkipped = simulationThread.getSkippedCount();
+			}
+			else
+			{
+				//One step then one frame, the way the render loop works with --serial
+				ParticleSnapshot snapshot;
+				while (MillisecondsSince(startTime) < runSeconds * 1000.0)
+				{
+					simulation.step(stepSeconds);
+					simulation.captureSnapshot(snapshot);
+					numOfSteps++;
+					checksum += PretendToRender(snapshot, renderCosts[run]);
+					numOfFrames++;
+				}
+			}
+
+			double seconds = MillisecondsSince(startTime) / 1000.0;
+			printf("%10s %10.0f %12.1f %12.1f %14.1f %10llu\n", threaded ? "threaded" : "serial", renderCosts[run], numOfFrames / seconds, numOfSteps / seconds, numOfSteps * stepSeconds / seconds, numOfSkipped);
+		}
+	}
+
+	//Printed so the pretend render cannot be optimised away
+	printf("checksum %.1f\n", checksum);
+	return 0;
+}
+
+//One row of the scaling benchmark, the same fields go in the CSV, the JSON and the baseline
+struct ScalingResult
+{
+	unsigned int particles;
+	unsigned int colliders;
+	unsigned int steps;
+	double startupMilliseconds;
+	double stepMilliseconds;
+	double stepMillisecondsP95;
+	unsigned long long startupBytes;
+	unsigned long long stepBytes;
+	unsigned long long stepAllocations;
+	//Peak heap during this row alone, the OS only keeps one resident peak for the whole process so that is reported once at the end instead
+	unsigned long long peakLiveBytes;
+};
+
+static const char* scalingCsvHeader = "particles,colliders,steps,startup_ms,step_ms,step_ms_p95,startup_bytes,step_bytes,step_allocations,peak_live_bytes";
+
+static void WriteScalingCsvRow(FILE* file, const ScalingResult& r)
+{
+	fprintf(file, "%u,%u,%u,%.4f,%.5f,%.5f,%llu,%llu,%llu,%llu\n", r.particles, r.colliders, r.steps, r.startupMilliseconds, r.stepMilliseconds, r.stepMillisecondsP95,
+		r.startupBytes, r.stepBytes, r.stepAllocations, r.peakLiveBytes);
+}
+
+static bool ReadScalingCsv(const char* filePath, std::vector<ScalingResult>& results)
+{
+	FILE* file = fopen(filePath, "r");
+	if (!file) return false;
+
+	char line[512];
+	while (fgets(line, sizeof(line), file))
+	{
+		//The header and anything else that does not parse is skipped, older baselines with a peak_rss_bytes column on the end still read
+		ScalingResult r;
+		if (sscanf(line, "%u,%u,%u,%lf,%lf,%lf,%llu,%llu,%llu,%llu", &r.particles, &r.colliders, &r.steps, &r.startupMilliseconds, &r.stepMilliseconds, &r.stepMillisecondsP95,
+			&r.startupBytes, &r.stepBytes, &r.stepAllocations, &r.peakLiveBytes) == 10)
+		{
+			results.push_back(r);
+		}
+	}
+	fclose(file);
+	return true;
+}
+
+//Prints anything in current that got worse than the matching baseline row, returns how many regressions there were
+static unsigned int CompareScalingResults(const std::vector<ScalingResult>& current, const std::vector<ScalingResult>& baseline, double tolerance)
+{
+	//Times below this are too short to compare reliably, so only a bigger change than this counts
+	const double noiseMilliseconds = 0.05;
+	unsigned int numOfRegressions = 0;
+
+	for (size_t c = 0; c < current.size(); c++)
+	{
+		const ScalingResult& now = current[c];
+		for (size_t b = 0; b < baseline.size(); b++)
+		{
+			const ScalingResult& then = baseline[b];
+			if (then.particles != now.particles || then.colliders != now.colliders) continue;
+
+			if (now.stepMilliseconds > then.stepMilliseconds * (1.0 + tolerance) + noiseMilliseconds)
+			{
+				printf("REGRESSION %u particles %u colliders: step %.4f ms, baseline %.4f ms\n", now.particles, now.colliders, now.stepMilliseconds, then.stepMilliseconds);
+				numOfRegressions++;
+			}
+			if (now.startupMilliseconds > then.startupMilliseconds * (1.0 + tolerance) + noiseMilliseconds)
+			{
+				printf("REGRESSION %u particles %u colliders: startup %.3f ms, baseline %.3f ms\n", now.particles, now.colliders, now.startupMilliseconds, then.startupMilliseconds);
+				numOfRegressions++;
+			}
+			//Steps are meant to stop allocating once they are warmed up, so any growth in allocations counts, whatever the tolerance
+			if (now.stepAllocations > then.stepAllocations)
+			{
+				printf("REGRESSION %u particles %u colliders: %llu allocations while stepping, baseline %llu\n", now.particles, now.colliders, now.stepAllocations, then.stepAllocations);
+				numOfRegressions++;
+			}
+			if (now.peakLiveBytes > then.peakLiveBytes * (1.0 + tolerance))
+			{
+				printf("REGRESSION %u particles %u colliders: peak heap %llu bytes, baseline %llu\n", now.particles, now.colliders, now.peakLiveBytes, then.peakLiveBytes);
+				numOfRegressions++;
+			}
+		}
+	}
+	return numOfRegressions;
+}
+
+int RunScalingBenchmark(int argc, char** argv)
+{
+	unsigned int maxParticles = 100000;
+	unsigned int numOfSteps = 100;
+	unsigned int numOfThreads = 1;
+	double tolerance = 0.25;
+	std::vector<unsigned int> colliderCounts;
+	const char* csvPath = nullptr;
+	const char* jsonPath = nullptr;
+	const char* baselinePath = nullptr;
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--max-particles") == 0 && hasValue) maxParticles = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--steps") == 0 && hasValue) numOfSteps = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--threads") == 0 && hasValue) numOfThreads = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--tolerance") == 0 && hasValue) tolerance = strtod(argv[++i], nullptr);
+		else if (strcmp(argv[i], "--csv") == 0 && hasValue) csvPath = argv[++i];
+		else if (strcmp(argv[i], "--json") == 0 && hasValue) jsonPath = argv[++i];
+		else if (strcmp(argv[i], "--baseline") == 0 && hasValue) baselinePath = argv[++i];
+		else if (strcmp(argv[i], "--colliders") == 0 && hasValue)
+		{
+			//Comma separated list, e.g. 1,64
+			for (char* count = argv[++i]; *count != '\0'; )
+			{
+				char* next = nullptr;
+				colliderCounts.push_back(strtoul(count, &next, 10));
+				count = (*next == ',') ? next + 1 : next;
+				if (next == count) break;
+			}
+		}
+	}
+	if (colliderCounts.empty())
+	{
+		colliderCounts.push_back(1);
+		colliderCounts.push_back(64);
+	}
+	if (numOfSteps == 0) numOfSteps = 1;
+
+	//The model counts the WS3 and WS4 experiments were run at, then every power of ten above up to maxParticles
+	std::vector<unsigned int> particleCounts;
+	for (unsigned long long count = 1; count <= maxParticles; count *= 10)
+	{
+		particleCounts.push_back(static_cast<unsigned int>(count));
+	}
+
+	JobSystem jobSystem(numOfThreads);
+	std::vector<ScalingResult> results;
+
+	printf("%u steps per run, %u threads\n", numOfSteps, jobSystem.getThreadCount());
+	PrintAllocationCountingNote();
+	printf("%10s %10s %11s %10s %10s %14s %12s %12s %14s\n", "particles", "colliders", "startup ms", "step ms", "p95 ms", "startup bytes", "step bytes", "step allocs", "peak heap");
+
+	for (size_t c = 0; c < colliderCounts.size(); c++)
+	{
+		for (size_t p = 0; p < particleCounts.size(); p++)
+		{
+			ScalingResult r = {};
+			r.particles = particleCounts[p];
+			r.colliders = colliderCounts[c];
+			r.steps = numOfSteps;
+			ResetPeakLiveBytes();
+
+			//Startup is everything from an empty simulation to particles ready to step
+			uint64_t bytesBefore = GetAllocatedBytes();
+			auto startTime = std::chrono::steady_clock::now();
+			srand(1);
+			ParticleSimulation simulation;
+			simulation.setJobSystem(&jobSystem);
+			SetUpHeadlessScene(simulation, r.colliders);
+			simulation.spawn(r.particles);
+			r.startupMilliseconds = MillisecondsSince(startTime);
+			r.startupBytes = GetAllocatedBytes() - bytesBefore;
+
+			std::vector<double> stepMilliseconds(numOfSteps);
+			bytesBefore = GetAllocatedBytes();
+			uint64_t allocationsBefore = GetAllocationCount();
+			for (unsigned int i = 0; i < numOfSteps; i++)
+			{
+				startTime = std::chrono::steady_clock::now();
+				simulation.step(1.0f / 60.0f);
+				stepMilliseconds[i] = MillisecondsSince(startTime);
+			}
+			r.stepBytes = GetAllocatedBytes() - bytesBefore;
+			r.stepAllocations = GetAllocationCount() - allocationsBefore;
+
+			double totalMilliseconds = 0.0;
+			for (size_t i = 0; i < stepMilliseconds.size(); i++)
+			{
+				totalMilliseconds += stepMilliseconds[i];
+			}
+			r.stepMilliseconds = totalMilliseconds / numOfSteps;
+			std::sort(stepMilliseconds.begin(), stepMilliseconds.end());
+			r.stepMillisecondsP95 = stepMilliseconds[std::min<size_t>(numOfSteps - 1, numOfSteps * 95 / 100)];
+			r.peakLiveBytes = GetPeakLiveBytes();
+
+			printf("%10u %10u %11.3f %10.4f %10.4f %14llu %12llu %12llu %14llu\n", r.particles, r.colliders, r.startupMilliseconds, r.stepMilliseconds, r.stepMillisecondsP95,
+				r.startupBytes, r.stepBytes, r.stepAllocations, r.peakLiveBytes);
+			results.push_back(r);
+		}
+	}
+	unsigned long long peakResidentBytes = GetPeakResidentBytes();
+	printf("peak resident over every run: %llu bytes\n", peakResidentBytes);
+
+	if (csvPath)
+	{
+		FILE* file = fopen(csvPath, "w");
+		if (!file)
+		{
+			printf("Could not write %s\n", csvPath);
+			return 1;
+		}
+		fprintf(file, "%s\n", scalingCsvHeader);
+		for (size_t r = 0; r < results.size(); r++)
+		{
+			WriteScalingCsvRow(file, results[r]);
+		}
+		fclose(file);
+	}
+
+	if (jsonPath)
+	{
+		FILE* file = fopen(jsonPath, "w");
+		if (!file)
+		{
+			printf("Could not write %s\n", jsonPath);
+			return 1;
+		}
+		fprintf(file, "{\"steps\": %u, \"threads\": %u, \"peak_rss_bytes\": %llu, \"results\": [\n", numOfSteps, jobSystem.getThreadCount(), peakResidentBytes);
+		for (size_t i = 0; i < results.size(); i++)
+		{
+			const ScalingResult& r = results[i];
+			fprintf(file, "  {\"particles\": %u, \"colliders\": %u, \"startup_ms\": %.4f, \"step_ms\": %.5f, \"step_ms_p95\": %.5f, \"startup_bytes\": %llu, \"step_bytes\": %llu, "
+				"\"step_allocations\": %llu, \"peak_live_bytes\": %llu}%s\n", r.particles, r.colliders, r.startupMilliseconds, r.stepMilliseconds, r.stepMillisecondsP95,
+				r.startupBytes, r.stepBytes, r.stepAllocations, r.peakLiveBytes, i + 1 < results.size() ? "," : "");
+		}
+		fprintf(file, "]}\n");
+		fclose(file);
+	}
+
+	if (baselinePath)
+	{
+		std::vector<ScalingResult> baseline;
+		if (!ReadScalingCsv(baselinePath, baseline))
+		{
+			printf("Could not read baseline %s\n", baselinePath);
+			return 1;
+		}
+		unsigned int numOfRegressions = CompareScalingResults(results, baseline, tolerance);
+		printf("%u regressions against %s (tolerance %.0f%%)\n", numOfRegressions, baselinePath, tolerance * 100.0);
+		if (numOfRegressions > 0) return 1;
+	}
+
+	return 0;
+}
+
+//Stands in for an import, builds a mesh of random vertices and works out its bounds
+static bool BuildSyntheticMesh(MeshData& mesh, size_t numOfVertices, unsigned int meshIndex)
+{
+	mesh.vertices.resize(numOfVertices);
+	mesh.indices.resize(numOfVertices);
+	uint64_t key = MakeRandomKey(1, meshIndex);
+	for (size_t i = 0; i < numOfVertices; i++)
+	{
+		Vertex& vertex = mesh.vertices[i];
+		uint32_t counter = static_cast<uint32_t>(i * 5);
+		vertex.x = RandomRange(key, counter, -1.0f, 1.0f);
+		vertex.y = RandomRange(key, counter + 1, -1.0f, 1.0f);
+		vertex.z = RandomRange(key, counter + 2, -1.0f, 1.0f);
+		vertex.nx = 0.0f;
+		vertex.ny = 1.0f;
+		vertex.nz = 0.0f;
+		vertex.u = RandomRange(key, counter + 3, 0.0f, 1.0f);
+		vertex.v = RandomRange(key, counter + 4, 0.0f, 1.0f);
+		mesh.indices[i] = static_cast<unsigned int>(i);
+	}
+	mesh.localBounds = CalculateLocalBounds(mesh.vertices);
+	return true;
+}
+
+//Stands in for a buffer upload, copies the mesh into memory the mesh does not own
+static void UploadSyntheticMesh(const MeshData& mesh, std::vector<unsigned char>& gpuBuffer)
+{
+	size_t vertexBytes = mesh.vertices.size() * sizeof(Vertex);
+	size_t indexBytes = mesh.indices.size() * sizeof(unsigned int);
+	gpuBuffer.resize(vertexBytes + indexBytes);
+	memcpy(gpuBuffer.data(), mesh.vertices.data(), vertexBytes);
+	memcpy(gpuBuffer.data() + vertexBytes, mesh.indices.data(), indexBytes);
+}
+
+int RunAssetLoadingBenchmark(int argc, char** argv)
+{
+	unsigned int numOfAssets = 64;
+	size_t numOfVertices = 50000;
+	double uploadBudgetMilliseconds = 2.0;
+	unsigned int numOfThreads = 0;
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--assets") == 0 && hasValue) numOfAssets = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--vertices") == 0 && hasValue) numOfVertices = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--upload-budget") == 0 && hasValue) uploadBudgetMilliseconds = strtod(argv[++i], nullptr);
+		else if (strcmp(argv[i], "--threads") == 0 && hasValue) numOfThreads = strtoul(argv[++i], nullptr, 10);
+	}
+	if (numOfAssets == 0) numOfAssets = 1;
+	const std::chrono::microseconds frameTime(16667);
+
+	//What main used to do, every asset loaded and uploaded before the first frame
+	std::vector<MeshData> meshes(numOfAssets);
+	std::vector<std::vector<unsigned char>> gpuBuffers(numOfAssets);
+	auto startTime = std::chrono::steady_clock::now();
+	for (unsigned int a = 0; a < numOfAssets; a++)
+	{
+		BuildSyntheticMesh(meshes[a], numOfVertices, a);
+		UploadSyntheticMesh(meshes[a], gpuBuffers[a]);
+	}
+	double blockingMilliseconds = MillisecondsSince(startTime);
+
+	meshes.assign(numOfAssets, MeshData());
+	gpuBuffers.assign(numOfAssets, std::vector<unsigned char>());
+	startTime = std::chrono::steady_clock::now();
+	AssetQueue assets(numOfThreads);
+	for (unsigned int a = 0; a < numOfAssets; a++)
+	{
+		MeshData& mesh = meshes[a];
+		std::vector<unsigned char>& gpuBuffer = gpuBuffers[a];
+		assets.request("mesh " + std::to_string(a), [&mesh, numOfVertices, a](std::string&) { return BuildSyntheticMesh(mesh, numOfVertices, a); },
+			[&mesh, &gpuBuffer] { UploadSyntheticMesh(mesh, gpuBuffer); });
+	}
+
+	//Frames carry on at 60 Hz while the workers load, each one uploads what it can within the budget
+	double firstFrameMilliseconds = 0.0;
+	double longestUploadMilliseconds = 0.0;
+	unsigned int numOfFrames = 0;
+	while (!assets.isFinished())
+	{
+		auto frameStart = std::chrono::steady_clock::now();
+		assets.processUploads(uploadBudgetMilliseconds);
+		longestUploadMilliseconds = std::max(longestUploadMilliseconds, MillisecondsSince(frameStart));
+		if (numOfFrames == 0) firstFrameMilliseconds = MillisecondsSince(startTime);
+		numOfFrames++;
+		std::this_thread::sleep_until(frameStart + frameTime);
+	}
+	double asyncMilliseconds = MillisecondsSince(startTime);
+
+	std::vector<double> latencies;
+	for (AssetHandle handle = 0; handle < assets.getAssetCount(); handle++)
+	{
+		if (assets.getState(handle) != ASSET_READY) return 1;
+		latencies.push_back(assets.getTiming(handle).latencyMilliseconds);
+	}
+	std::sort(latencies.begin(), latencies.end());
+
+	printf("%u assets of %zu vertices, %u load threads, %.1f ms upload budget\n", numOfAssets, numOfVertices, assets.getThreadCount(), uploadBudgetMilliseconds);
+	printf("%10s %16s %16s %8s\n", "mode", "first frame ms", "all loaded ms", "frames");
+	printf("%10s %16.2f %16.2f %8s\n", "blocking", blockingMilliseconds, blockingMilliseconds, "-");
+	printf("%10s %16.2f %16.2f %8u\n", "async", firstFrameMilliseconds, asyncMilliseconds, numOfFrames);
+	printf("longest upload in a frame: %.2f ms\n", longestUploadMilliseconds);
+	printf("per asset latency ms: min %.2f, median %.2f, p95 %.2f, max %.2f\n", latencies.front(), latencies[latencies.size() / 2],
+		latencies[latencies.size() * 95 / 100], latencies.back());
+
+	//The async copies have to match what was loaded the blocking way
+	for (unsigned int a = 0; a < numOfAssets; a++)
+	{
+		MeshData expectedMesh;
+		std::vector<unsigned char> expectedBuffer;
+		BuildSyntheticMesh(expectedMesh, numOfVertices, a);
+		UploadSyntheticMesh(expectedMesh, expectedBuffer);
+		if (expectedBuffer != gpuBuffers[a])
+		{
+			printf("Asset %u did not load the same asynchronously\n", a);
+			return 1;
+		}
+	}
+	return 0;
+}
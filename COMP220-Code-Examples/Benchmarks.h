@@ -0,0 +1,65 @@
+#pragma once
+
+//Times the uniform grid broadphase against testing every particle with every collider, and every particle with every other particle
+//Fails if the grid finds different overlaps to the brute force test, sweeps 1k to 1M particles, --colliders <count> sets how many colliders each run uses
+int RunBroadphaseBenchmark(int argc, char** argv);
+
+//Runs the same simulation on 1, 2, 4... threads up to the core count and reports the speedup over one thread
+//Takes --particles, --steps and --colliders like the headless run
+int RunThreadScalingBenchmark(int argc, char** argv);
+
+//Times the AABB overlap kernel at each instruction set level this CPU supports against the scalar loop
+//--particles sets the batch size, --repeats how many times each level runs over it
+int RunAabbKernelBenchmark(int argc, char** argv);
+
+//Grows one simulation by --grow-by particles at a time up to --max-particles, 10M by default, stepping it after each growth
+//Reports how long each growth and step took and the memory per particle, and returns 1 if any existing particle moved in memory
+int RunStorageBenchmark(int argc, char** argv);
+
+//Emits --emit-rate particles per second in front of the glass for --seconds of simulation time, also takes --threads
+//Reports the live particles, the slots the store holds and the time per step each second, the slots should level off once deletions keep up
+int RunEmitterBenchmark(int argc, char** argv);
+
+//Steps two copies of the same --particles particles until they have all hit the glass and been deleted, one compacting its store and one not
+//Reports the time per step of each every second, the compacted one should get cheaper as particles expire, takes --seconds and --threads
+int RunCompactionBenchmark(int argc, char** argv);
+
+//Times the random bulk fill at each instruction set level against rand(), then spawns --particles particles (4M by default)
+//on 1 thread up to more threads than there are cores, and returns 1 unless every spawn is bit for bit the same, takes --seed
+int RunSpawnBenchmark(int argc, char** argv);
+
+//Times the Verlet integrator with gravity, drag, wind and bounds all on, at each instruction set level on one thread and then on --threads threads
+//Reports particles integrated per second per core next to the old move by velocity loop, and returns 1 if a SIMD level does not match scalar
+//Takes --particles and --steps
+int RunIntegratorBenchmark(int argc, char** argv);
+
+//Writes a --vertices vertex mesh (1M by default) to the binary mesh cache and times hashing, writing and mapping it back
+//Returns 1 unless the mesh comes back exactly and a changed source hash, import or cut short file is turned away
+int RunMeshCacheBenchmark(int argc, char** argv);
+
+//Loads --assets synthetic meshes (64 by default) of --vertices vertices each, first one after another before the first frame
+//and then through an AssetQueue while 60 Hz frames run, uploading at most --upload-budget ms a frame
+//Reports the time to the first frame both ways, how many frames the async load took and the spread of per asset latency
+int RunAssetLoadingBenchmark(int argc, char** argv);
+
+//Runs the same scene with growing step sizes, once sweeping the particles and once only checking where each step ends
+//Shows how many collisions the end of step check misses once particles move further than a collider is thick
+//Takes --particles and --colliders like the headless run
+int RunContinuousCollisionBenchmark(int argc, char** argv);
+
+//Feeds the simulation frames at several frame rates through FixedTimestep and through the old one step per frame
+//Fixed steps should give the same collisions and simulated time at every frame rate, one step per frame should not
+//Also reports sim s/wall s, how many simulated seconds each second of stepping buys, takes --particles and --colliders
+int RunTimestepBenchmark(int argc, char** argv);
+
+//Runs the simulation as fast as it can against a pretend renderer that sleeps for a set time each frame
+//Once in one loop like --serial, once with the simulation on a SimulationThread, and reports each sides throughput
+//Takes --particles and --seconds, how long each run lasts in real time
+int RunPipelineBenchmark(int argc, char** argv);
+
+//Sweeps 1 to 100k particles (--max-particles raises the top) against each collider count in --colliders <a,b,...>
+//Records startup time, mean and 95th percentile time per step, bytes and allocations during startup and stepping, and peak heap per run
+//Peak resident memory is only kept by the OS for the whole process, so it is reported once for the sweep rather than per run
+//--csv <file> and --json <file> write the results, --baseline <csv> compares against an earlier --csv and returns 1 if anything regressed
+//Also takes --steps, --threads and --tolerance, the fraction a time can grow by before it counts as a regression
+int RunScalingBenchmark(int argc, char** argv);
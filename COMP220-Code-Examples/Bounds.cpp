@@ -0,0 +1,88 @@
+#include "Bounds.h"
+
+AABB CalculateLocalBounds(const std::vector<Vertex>& meshVertices)
+{
+	AABB localBounds = { glm::vec3(0.0f), glm::vec3(0.0f) };
+	if (meshVertices.empty()) return localBounds;
+
+	//Starts both bounds on the first vertex so the loop below only ever has to widen them
+	localBounds.minimum = glm::vec3(meshVertices[0].x, meshVertices[0].y, meshVertices[0].z);
+	localBounds.maximum = localBounds.minimum;
+
+	for (size_t i = 1; i < meshVertices.size(); i++)
+	{
+		glm::vec3 vertexPosition = glm::vec3(meshVertices[i].x, meshVertices[i].y, meshVertices[i].z);
+		localBounds.minimum = glm::min(localBounds.minimum, vertexPosition);
+		localBounds.maximum = glm::max(localBounds.maximum, vertexPosition);
+	}
+
+	return localBounds;
+}
+
+AABB TransformBounds(const AABB& localBounds, const glm::mat4& model)
+{
+	//Starts from the translation, then adds on the smallest and largest contribution of every matrix element
+	AABB worldBounds;
+	worldBounds.minimum = glm::vec3(model[3]);
+	worldBounds.maximum = glm::vec3(model[3]);
+
+	for (int row = 0; row < 3; row++)
+	{
+		for (int column = 0; column < 3; column++)
+		{
+			//glm matrices are column major, so model[column][row]
+			float a = model[column][row] * localBounds.minimum[column];
+			float b = model[column][row] * localBounds.maximum[column];
+			worldBounds.minimum[row] += glm::min(a, b);
+			worldBounds.maximum[row] += glm::max(a, b);
+		}
+	}
+
+	return worldBounds;
+}
+
+bool Overlaps(const AABB& a, const AABB& b)
+{
+	return
+		a.maximum.x >= b.minimum.x && a.minimum.x <= b.maximum.x &&
+		a.maximum.y >= b.minimum.y && a.minimum.y <= b.maximum.y &&
+		a.maximum.z >= b.minimum.z && a.minimum.z <= b.maximum.z;
+}
+
+bool SweepAabb(const AABB& moving, glm::vec3 displacement, const AABB& target, float& timeOfImpact)
+{
+	float enterTime = 0.0f;
+	float exitTime = 1.0f;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (displacement[axis] == 0.0f)
+		{
+			//Not moving on this axis, so it has to overlap on it for the whole move or never touch
+			if (moving.maximum[axis] < target.minimum[axis] || moving.minimum[axis] > target.maximum[axis]) return false;
+			continue;
+		}
+
+		//Times the leading face reaches the near side of the target and the trailing face leaves the far side
+		float inverseDisplacement = 1.0f / displacement[axis];
+		float axisEnter, axisExit;
+		if (displacement[axis] > 0.0f)
+		{
+			axisEnter = (target.minimum[axis] - moving.maximum[axis]) * inverseDisplacement;
+			axisExit = (target.maximum[axis] - moving.minimum[axis]) * inverseDisplacement;
+		}
+		else
+		{
+			axisEnter = (target.maximum[axis] - moving.minimum[axis]) * inverseDisplacement;
+			axisExit = (target.minimum[axis] - moving.maximum[axis]) * inverseDisplacement;
+		}
+
+		//The boxes only touch while they overlap on every axis at once
+		enterTime = glm::max(enterTime, axisEnter);
+		exitTime = glm::min(exitTime, axisExit);
+		if (enterTime > exitTime) return false;
+	}
+
+	timeOfImpact = enterTime;
+	return true;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Vertex.h"
+
+//Axis aligned bounding box
+struct AABB
+{
+	glm::vec3 minimum;
+	glm::vec3 maximum;
+};
+
+//Works out the bounds of a mesh in its own local space, only needs doing once when the mesh is loaded
+AABB CalculateLocalBounds(const std::vector<Vertex>& meshVertices);
+
+//Places local bounds in the world through any affine matrix, including rotations, without touching the mesh vertices
+//Uses Arvo's method from Graphics Gems, "Transforming Axis-Aligned Bounding Boxes"
+AABB TransformBounds(const AABB& localBounds, const glm::mat4& model);
+
+//True if the two boxes touch or overlap
+bool Overlaps(const AABB& a, const AABB& b);
+
+//Slides moving along displacement and finds the first time, from 0 to 1, it touches target
+//Treats each axis as a slab the box has to be inside, so it is exact for boxes that do not rotate
+//Returns false if they never touch during the move, a box already overlapping target hits at time 0
+bool SweepAabb(const AABB& moving, glm::vec3 displacement, const AABB& target, float& timeOfImpact);
@@ -0,0 +1,58 @@
+#include "FileHash.h"
+#include "MappedFile.h"
+
+#include <cstring>
+
+namespace
+{
+	const uint64_t hashMultiplier1 = 0x9E3779B97F4A7C15ull;
+	const uint64_t hashMultiplier2 = 0xC2B2AE3D27D4EB4Full;
+
+	uint64_t RotateLeft(uint64_t value, int bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	//A multiply only carries bits upwards, so the top bit of a word would only ever reach the top bit of the hash
+	//Shifting the high half back down between two multiplies lets every input bit reach every output bit
+	uint64_t MixWord(uint64_t word)
+	{
+		word *= hashMultiplier1;
+		word ^= word >> 32;
+		return word * hashMultiplier2;
+	}
+}
+
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed)
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	uint64_t hash = MixWord(seed ^ 14695981039346656037ull) ^ size;
+
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+	{
+		uint64_t word;
+		memcpy(&word, bytes + i, sizeof(word));
+		hash = RotateLeft(hash ^ MixWord(word), 27) * hashMultiplier1;
+	}
+	//The last few bytes go in as one zero padded word
+	if (i < size)
+	{
+		uint64_t word = 0;
+		memcpy(&word, bytes + i, size - i);
+		hash = RotateLeft(hash ^ MixWord(word), 27) * hashMultiplier1;
+	}
+	//Final avalanche so the last word reaches the low bits as well
+	hash ^= hash >> 33;
+	hash *= hashMultiplier2;
+	hash ^= hash >> 29;
+	return hash;
+}
+
+uint64_t HashFile(const std::string& filePath, uint64_t* fileSize)
+{
+	MappedFile sourceFile;
+	if (!sourceFile.open(filePath)) return 0;
+	if (fileSize) *fileSize = sourceFile.getSize();
+	return HashBytes(sourceFile.getData(), sourceFile.getSize());
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//64 bit hash taken a word at a time, for telling whether a cache was made from the same input, not for security
+//Each word is mixed on its own before it is folded in, so every bit of the input reaches every bit of the hash
+//seed lets several pieces of data be chained into one hash
+uint64_t HashBytes(const void* data, size_t size, uint64_t seed = 0);
+
+//Hash of every byte of a file, 0 if it could not be read, fileSize is filled in as well when it is given
+uint64_t HashFile(const std::string& filePath, uint64_t* fileSize = nullptr);
@@ -0,0 +1,29 @@
+#include "FixedTimestep.h"
+
+FixedTimestep::FixedTimestep(double stepSeconds, unsigned int maxStepsPerFrame)
+	: m_StepSeconds(stepSeconds), m_MaxStepsPerFrame(maxStepsPerFrame), m_Accumulator(0.0), m_StepCount(0), m_DroppedSeconds(0.0)
+{
+}
+
+unsigned int FixedTimestep::advance(double frameSeconds)
+{
+	if (frameSeconds > 0.0) m_Accumulator += frameSeconds;
+
+	unsigned int numOfSteps = 0;
+	while (m_Accumulator >= m_StepSeconds && numOfSteps < m_MaxStepsPerFrame)
+	{
+		m_Accumulator -= m_StepSeconds;
+		numOfSteps++;
+	}
+
+	//Too far behind to catch up, drops the backlog rather than spending even longer on the next frame
+	if (m_Accumulator >= m_StepSeconds)
+	{
+		double keptSeconds = m_Accumulator - static_cast<long long>(m_Accumulator / m_StepSeconds) * m_StepSeconds;
+		m_DroppedSeconds += m_Accumulator - keptSeconds;
+		m_Accumulator = keptSeconds;
+	}
+
+	m_StepCount += numOfSteps;
+	return numOfSteps;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+//Turns however long each rendered frame took into a whole number of fixed size simulation steps
+//Time left over is carried into the next frame, so the simulation runs at the same speed whatever the frame rate
+class FixedTimestep
+{
+public:
+	//stepSeconds is the deltaTime every step is run with, maxStepsPerFrame stops a slow frame asking for ever more steps
+	explicit FixedTimestep(double stepSeconds = 1.0 / 60.0, unsigned int maxStepsPerFrame = 8);
+
+	//Adds frameSeconds of real time and returns how many steps to run this frame, can be 0 on fast frames
+	unsigned int advance(double frameSeconds);
+	//How far the render is between the last two steps, from 0 to 1, used to interpolate the particle positions
+	float getInterpolation() const { return static_cast<float>(m_Accumulator / m_StepSeconds); }
+
+	float getStepSeconds() const { return static_cast<float>(m_StepSeconds); }
+	void setStepSeconds(double stepSeconds) { m_StepSeconds = stepSeconds; }
+	void setMaxStepsPerFrame(unsigned int maxStepsPerFrame) { m_MaxStepsPerFrame = maxStepsPerFrame; }
+
+	//Simulation seconds stepped so far
+	double getSimulatedSeconds() const { return m_StepCount * m_StepSeconds; }
+	unsigned long long getStepCount() const { return m_StepCount; }
+	//Real seconds thrown away because a frame needed more than maxStepsPerFrame steps, the simulation ran slower than real time by this much
+	double getDroppedSeconds() const { return m_DroppedSeconds; }
+
+private:
+	double m_StepSeconds;
+	unsigned int m_MaxStepsPerFrame;
+	double m_Accumulator;
+	unsigned long long m_StepCount;
+	double m_DroppedSeconds;
+};
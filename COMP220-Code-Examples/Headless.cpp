@@ -0,0 +1,174 @@
+#include "Headless.h"
+#include "Benchmarks.h"
+#include "Profiler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+//Half the width of the crate the GUI build loads from Crate.fbx, which is authored in centimetres
+const float crateHalfExtent = 100.0f;
+
+//Builds the eight corners of the crate so the headless build does not need Assimp to get its bounds
+static std::vector<Vertex> CreateCrateVertices()
+{
+	std::vector<Vertex> crateVertices;
+	for (int corner = 0; corner < 8; corner++)
+	{
+		Vertex vertex = {};
+		vertex.x = (corner & 1) ? crateHalfExtent : -crateHalfExtent;
+		vertex.y = (corner & 2) ? crateHalfExtent : -crateHalfExtent;
+		vertex.z = (corner & 4) ? crateHalfExtent : -crateHalfExtent;
+		crateVertices.push_back(vertex);
+	}
+	return crateVertices;
+}
+
+void SetUpHeadlessScene(ParticleSimulation& simulation, unsigned int numOfColliders)
+{
+	std::vector<Vertex> crateVertices = CreateCrateVertices();
+	simulation.setParticleMesh(crateVertices);
+	simulation.setGlass(crateVertices, glm::vec3(0.0f, 0.0f, 0.5f), glm::vec3(0.01f, 0.01f, 0.001f));
+
+	//Any colliders past the glass are small panes scattered through the space the particles travel through
+	for (unsigned int c = 1; c < numOfColliders; c++)
+	{
+		glm::vec3 centre = glm::vec3(static_cast<float>(rand()) / RAND_MAX * 2.0f - 1.0f, static_cast<float>(rand()) / RAND_MAX * 2.0f - 1.0f, static_cast<float>(rand()) / RAND_MAX * 2.5f - 2.0f);
+		glm::vec3 halfSize = glm::vec3(0.05f, 0.05f, 0.0005f);
+		simulation.addCollider({ centre - halfSize, centre + halfSize });
+	}
+}
+
+//Reads "x,y,z" into value, leaves it alone if the text is not three numbers
+static void ReadVector(const char* text, glm::vec3& value)
+{
+	glm::vec3 readValue;
+	if (sscanf(text, "%f,%f,%f", &readValue.x, &readValue.y, &readValue.z) == 3) value = readValue;
+}
+
+bool IsHeadlessRequested(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--headless") == 0) return true;
+	}
+	return false;
+}
+
+int RunHeadless(int argc, char** argv)
+{
+	//--bench <name> runs one of the standalone benchmarks instead of the simulation
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (strcmp(argv[i], "--bench") == 0)
+		{
+			if (strcmp(argv[i + 1], "broadphase") == 0) return RunBroadphaseBenchmark(argc, argv);
+			if (strcmp(argv[i + 1], "threads") == 0) return RunThreadScalingBenchmark(argc, argv);
+			if (strcmp(argv[i + 1], "aabb") == 0) return RunAabbKernelBenchmark(argc, argv);
+			if (strcmp(argv[i + 1], "ccd") == 0) return RunContinuousCollisionBenchmark(argc, argv);
+			if (strcmp(argv[i + 1], "timestep") == 0) return RunTimestepBenchmark(argc, argv);
+			if (strcmp(argv[i + 1], "pipeline") == 0) return RunPipelineBenchmark(argc, argv);
+			if (strcmp(argv[i + 1], "scaling") == 0) return RunScalingBenchmark(argc, argv);
+			if (strcmp(argv[i + 1], "storage") == 0) return RunStorageBenchmark(argc, argv);
+			if (strcmp(argv[i + 1], "emitter") == 0) return RunEmitterBenchmark(argc, argv);
+			if (strcmp(argv[i + 1], "compaction") == 0) return RunCompactionBenchmark(argc, argv);
+			if (strcmp(argv[i + 1], "spawn") == 0) return RunSpawnBenchmark(argc, argv);
+			if (strcmp(argv[i + 1], "integrate") == 0) return RunIntegratorBenchmark(argc, argv);
+			if (strcmp(argv[i + 1], "meshcache") == 0) return RunMeshCacheBenchmark(argc, argv);
+			if (strcmp(argv[i + 1], "assets") == 0) return RunAssetLoadingBenchmark(argc, argv);
+			printf("Unknown benchmark %s\n", argv[i + 1]);
+			return 1;
+		}
+	}
+
+	unsigned int numOfParticles = 1000;
+	unsigned int numOfColliders = 1;
+	unsigned int numOfSteps = 1000;
+	unsigned int numOfThreads = 1;
+	float deltaTime = 1.0f / 60.0f;
+	bool continuousCollision = true;
+	float emitRate = 0.0f;
+	//Same particles every run unless --seed <n> asks for different ones, printed with the results either way
+	uint64_t seed = defaultRandomSeed;
+	//--gravity <x,y,z>, --wind <x,y,z> and --drag <per second> turn on the integrators forces, --bounds <size> keeps particles inside a cube that wide
+	IntegratorSettings integratorSettings;
+	float boundsSize = 0.0f;
+	const char* tracePath = nullptr;
+
+	//Reads the options, anything it does not recognise (like --headless itself) is skipped
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--particles") == 0 && hasValue) numOfParticles = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--steps") == 0 && hasValue) numOfSteps = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--dt") == 0 && hasValue) deltaTime = strtof(argv[++i], nullptr);
+		else if (strcmp(argv[i], "--colliders") == 0 && hasValue) numOfColliders = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--threads") == 0 && hasValue) numOfThreads = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--discrete") == 0) continuousCollision = false;
+		else if (strcmp(argv[i], "--emit-rate") == 0 && hasValue) emitRate = strtof(argv[++i], nullptr);
+		else if (strcmp(argv[i], "--seed") == 0 && hasValue) seed = strtoull(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--gravity") == 0 && hasValue) ReadVector(argv[++i], integratorSettings.gravity);
+		else if (strcmp(argv[i], "--wind") == 0 && hasValue) ReadVector(argv[++i], integratorSettings.wind);
+		else if (strcmp(argv[i], "--drag") == 0 && hasValue) integratorSettings.drag = strtof(argv[++i], nullptr);
+		else if (strcmp(argv[i], "--bounds") == 0 && hasValue) boundsSize = strtof(argv[++i], nullptr);
+		else if (strcmp(argv[i], "--profile") == 0 && hasValue) tracePath = argv[++i];
+	}
+
+	//The particles come from the seed, rand() still places the extra colliders so it is seeded with it too
+	srand(static_cast<unsigned int>(seed));
+
+	JobSystem jobSystem(numOfThreads);
+	ParticleSimulation simulation;
+	simulation.setJobSystem(&jobSystem);
+	simulation.setContinuousCollision(continuousCollision);
+	simulation.setSeed(seed);
+	if (boundsSize > 0.0f)
+	{
+		integratorSettings.constrainToBounds = true;
+		integratorSettings.bounds = { glm::vec3(-boundsSize * 0.5f), glm::vec3(boundsSize * 0.5f) };
+	}
+	simulation.setIntegratorSettings(integratorSettings);
+	SetUpHeadlessScene(simulation, numOfColliders);
+	simulation.spawn(numOfParticles);
+	//--emit-rate <per second> keeps spawning particles on top of the first --particles
+	if (emitRate > 0.0f) simulation.addEmitter(CreateSpawnEmitter(emitRate));
+
+	//--profile <file> records every zone of every step, writes them as a Chrome trace and prints a summary at the end
+	if (tracePath)
+	{
+		GetProfiler().setThreadName("Main");
+		GetProfiler().setEnabled(true);
+	}
+
+	auto startTime = std::chrono::steady_clock::now();
+	for (unsigned int i = 0; i < numOfSteps; i++)
+	{
+		simulation.step(deltaTime);
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - startTime;
+
+	double stepsPerSecond = elapsed.count() > 0.0 ? numOfSteps / elapsed.count() : 0.0;
+	printf("particles: %u (%u live in %u slots)\n", numOfParticles, simulation.getLiveParticleCount(), simulation.getParticleCount());
+	printf("seed: %llu\n", static_cast<unsigned long long>(seed));
+	printf("colliders: %zu\n", simulation.getColliders().size());
+	printf("threads: %u\n", jobSystem.getThreadCount());
+	printf("steps: %u (dt %.4f s)\n", numOfSteps, deltaTime);
+	printf("collision test: %s\n", continuousCollision ? "continuous" : "end of step");
+	printf("collisions: %u\n", simulation.getCollisionCount());
+	printf("deletions: %u (%zu pending)\n", simulation.getDeletionCount(), simulation.getPendingDeletionCount());
+	printf("elapsed: %.3f s\n", elapsed.count());
+	printf("steps/sec: %.1f\n", stepsPerSecond);
+	printf("sim s/wall s: %.1f\n", stepsPerSecond * deltaTime);
+
+	if (tracePath)
+	{
+		GetProfiler().setEnabled(false);
+		GetProfiler().printSummary(stdout);
+		if (GetProfiler().writeChromeTrace(tracePath)) printf("trace written to %s\n", tracePath);
+		else printf("could not write trace to %s\n", tracePath);
+	}
+
+	return 0;
+}
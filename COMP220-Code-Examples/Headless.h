@@ -0,0 +1,16 @@
+#pragma once
+
+#include "ParticleSimulation.h"
+
+//Runs the particle simulation without SDL or OpenGL and prints how many steps it managed per second
+//Accepts --particles <count>, --steps <count>, --dt <seconds>, --colliders <count>, --threads <count>, --discrete, --emit-rate <per second>,
+//--seed <n>, --gravity <x,y,z>, --wind <x,y,z>, --drag <per second>, --bounds <size> and --profile <trace file>
+//Returns the process exit code
+//--bench <name> runs a standalone benchmark instead, see Benchmarks.h
+int RunHeadless(int argc, char** argv);
+
+//Returns true if --headless was passed on the command line
+bool IsHeadlessRequested(int argc, char** argv);
+
+//Gives the simulation the crate, the glass and numOfColliders - 1 extra panes, uses rand() so call srand first, the particles themselves come from the simulations seed
+void SetUpHeadlessScene(ParticleSimulation& simulation, unsigned int numOfColliders);
@@ -0,0 +1,7 @@
+#include "Headless.h"
+
+//Entry point for the headless build, which does not link SDL, GLEW or Assimp
+int main(int argc, char** argv)
+{
+	return RunHeadless(argc, argv);
+}
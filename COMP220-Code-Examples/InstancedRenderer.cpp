@@ -0,0 +1,88 @@
+#include "InstancedRenderer.h"
+
+InstancedRenderer::InstancedRenderer()
+	: m_VAO(0), m_InstanceVBO(0), m_InstanceCapacity(0), m_InstanceCount(0), m_DrawCalls(0)
+{
+}
+
+InstancedRenderer::~InstancedRenderer()
+{
+}
+
+void InstancedRenderer::init(GLuint meshVAO)
+{
+	m_VAO = meshVAO;
+	glGenBuffers(1, &m_InstanceVBO);
+
+	glBindVertexArray(m_VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, m_InstanceVBO);
+	//One vec4 per instance, position in xyz and uniform scale in w
+	glVertexAttribPointer(instanceAttributeLocation, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(GL_FLOAT), (void*)0);
+	glEnableVertexAttribArray(instanceAttributeLocation);
+	//Advance this attribute once per instance rather than once per vertex
+	glVertexAttribDivisor(instanceAttributeLocation, 1);
+	glBindVertexArray(0);
+}
+
+void InstancedRenderer::upload(const ParticleStore& particles, float interpolation)
+{
+	m_DrawCalls = 0;
+	m_InstanceData.clear();
+	m_InstanceData.reserve(particles.size() * 4);
+
+	//Deleted particles are skipped so they are never sent to the GPU
+	for (size_t i = 0; i < particles.size(); i++)
+	{
+		if (particles.state[i] == PARTICLE_DELETED) continue;
+		m_InstanceData.push_back(particles.previousPositionX[i] + (particles.positionX[i] - particles.previousPositionX[i]) * interpolation);
+		m_InstanceData.push_back(particles.previousPositionY[i] + (particles.positionY[i] - particles.previousPositionY[i]) * interpolation);
+		m_InstanceData.push_back(particles.previousPositionZ[i] + (particles.positionZ[i] - particles.previousPositionZ[i]) * interpolation);
+		m_InstanceData.push_back(particles.scale[i]);
+	}
+	sendInstances();
+}
+
+void InstancedRenderer::upload(const ParticleSnapshot& snapshot, float interpolation)
+{
+	m_DrawCalls = 0;
+	m_InstanceData.resize(snapshot.instances.size());
+
+	//Every fourth value is the scale, which never changes, so blending it as well does no harm
+	for (size_t i = 0; i < m_InstanceData.size(); i++)
+	{
+		m_InstanceData[i] = snapshot.previousInstances[i] + (snapshot.instances[i] - snapshot.previousInstances[i]) * interpolation;
+	}
+	sendInstances();
+}
+
+void InstancedRenderer::sendInstances()
+{
+	m_InstanceCount = static_cast<GLsizei>(m_InstanceData.size() / 4);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_InstanceVBO);
+	if (m_InstanceCount > m_InstanceCapacity)
+	{
+		m_InstanceCapacity = m_InstanceCount;
+	}
+	//Orphans last frames buffer so the driver does not have to wait for the GPU to finish with it
+	glBufferData(GL_ARRAY_BUFFER, m_InstanceCapacity * 4 * sizeof(float), NULL, GL_STREAM_DRAW);
+	if (m_InstanceCount > 0)
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, 0, m_InstanceData.size() * sizeof(float), &m_InstanceData[0]);
+	}
+}
+
+void InstancedRenderer::draw(GLsizei indexCount)
+{
+	if (m_InstanceCount == 0) return;
+
+	glBindVertexArray(m_VAO);
+	glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (void*)0, m_InstanceCount);
+	m_DrawCalls++;
+}
+
+void InstancedRenderer::destroy()
+{
+	glDeleteBuffers(1, &m_InstanceVBO);
+	m_InstanceVBO = 0;
+}
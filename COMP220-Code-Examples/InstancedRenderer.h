@@ -0,0 +1,47 @@
+#pragma once
+
+#include <gl\glew.h>
+#include <SDL_opengl.h>
+#include <vector>
+
+#include "ParticleStore.h"
+#include "ParticleSnapshot.h"
+
+//Attribute location BasicVert.glsl reads the per-instance position and scale from
+const GLuint instanceAttributeLocation = 3;
+
+//Draws every live particle with one glDrawElementsInstanced call instead of one draw per particle
+class InstancedRenderer
+{
+public:
+	InstancedRenderer();
+	~InstancedRenderer();
+
+	//Creates the instance buffer and hooks it into the mesh VAO as a per-instance attribute
+	void init(GLuint meshVAO);
+	//Copies the position and scale of every particle that has not been deleted into the instance buffer, call once per frame
+	//Interpolation blends each position from where it was before the last step (0) to where it is now (1)
+	void upload(const ParticleStore& particles, float interpolation = 1.0f);
+	//Same again from a snapshot published by the simulation thread, which has already left out the deleted particles
+	void upload(const ParticleSnapshot& snapshot, float interpolation);
+	//Draws the uploaded particles using the index buffer bound to the mesh VAO
+	void draw(GLsizei indexCount);
+	void destroy();
+
+	GLsizei getInstanceCount() const { return m_InstanceCount; }
+	//Draw calls issued since the last upload, so once per frame this is the draw calls per frame
+	unsigned int getDrawCalls() const { return m_DrawCalls; }
+
+private:
+	//Sends m_InstanceData to the GPU
+	void sendInstances();
+
+	GLuint m_VAO;
+	GLuint m_InstanceVBO;
+	//Capacity of the GPU buffer in instances, only grows
+	GLsizei m_InstanceCapacity;
+	GLsizei m_InstanceCount;
+	unsigned int m_DrawCalls;
+	//x, y, z and scale for each live particle
+	std::vector<float> m_InstanceData;
+};
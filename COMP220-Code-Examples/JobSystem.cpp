@@ -0,0 +1,130 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+JobSystem::JobSystem(unsigned int threadCount)
+	: m_ThreadCount(threadCount), m_Body(nullptr), m_RangesRemaining(0), m_Generation(0), m_Quit(false)
+{
+	if (m_ThreadCount == 0) m_ThreadCount = std::thread::hardware_concurrency();
+	if (m_ThreadCount == 0) m_ThreadCount = 1;
+
+	for (unsigned int i = 0; i < m_ThreadCount; i++)
+	{
+		m_Queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+	}
+	//Thread 0 is whoever calls parallelFor, so one less worker is needed
+	for (unsigned int i = 1; i < m_ThreadCount; i++)
+	{
+		m_Workers.push_back(std::thread(&JobSystem::workerLoop, this, i));
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_WakeMutex);
+		m_Quit = true;
+	}
+	m_WakeCondition.notify_all();
+	for (size_t i = 0; i < m_Workers.size(); i++)
+	{
+		m_Workers[i].join();
+	}
+}
+
+void JobSystem::parallelFor(size_t count, size_t grainSize, const RangeFunction& body)
+{
+	if (count == 0) return;
+	if (grainSize == 0) grainSize = 1;
+
+	//Not worth waking anyone up for
+	if (m_ThreadCount == 1 || count <= grainSize)
+	{
+		body(0, count, 0);
+		return;
+	}
+
+	size_t numOfRanges = (count + grainSize - 1) / grainSize;
+	m_Body = &body;
+	m_RangesRemaining = numOfRanges;
+
+	//Each thread starts with its own contiguous block of ranges, stealing evens things out if some blocks are slower
+	for (size_t r = 0; r < numOfRanges; r++)
+	{
+		unsigned int owner = static_cast<unsigned int>(r * m_ThreadCount / numOfRanges);
+		Range range = { r * grainSize, std::min(count, (r + 1) * grainSize) };
+		std::lock_guard<std::mutex> lock(m_Queues[owner]->mutex);
+		m_Queues[owner]->ranges.push_back(range);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_WakeMutex);
+		m_Generation++;
+	}
+	m_WakeCondition.notify_all();
+
+	//The calling thread works too rather than just waiting
+	while (runOneRange(0)) {}
+
+	std::unique_lock<std::mutex> lock(m_DoneMutex);
+	m_DoneCondition.wait(lock, [this]() { return m_RangesRemaining == 0; });
+}
+
+void JobSystem::workerLoop(unsigned int threadIndex)
+{
+	unsigned long long seenGeneration = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_WakeMutex);
+			m_WakeCondition.wait(lock, [&]() { return m_Quit || m_Generation != seenGeneration; });
+			if (m_Quit) return;
+			seenGeneration = m_Generation;
+		}
+
+		while (runOneRange(threadIndex)) {}
+	}
+}
+
+bool JobSystem::runOneRange(unsigned int threadIndex)
+{
+	Range range;
+	bool found = false;
+
+	//Own queue is worked from the back so the ranges it takes stay next to each other in memory
+	{
+		WorkQueue& ownQueue = *m_Queues[threadIndex];
+		std::lock_guard<std::mutex> lock(ownQueue.mutex);
+		if (!ownQueue.ranges.empty())
+		{
+			range = ownQueue.ranges.back();
+			ownQueue.ranges.pop_back();
+			found = true;
+		}
+	}
+
+	//Steals from the front of the other queues, the end their owners are furthest from
+	for (unsigned int offset = 1; !found && offset < m_ThreadCount; offset++)
+	{
+		WorkQueue& victimQueue = *m_Queues[(threadIndex + offset) % m_ThreadCount];
+		std::lock_guard<std::mutex> lock(victimQueue.mutex);
+		if (!victimQueue.ranges.empty())
+		{
+			range = victimQueue.ranges.front();
+			victimQueue.ranges.pop_front();
+			found = true;
+		}
+	}
+
+	if (!found) return false;
+
+	(*m_Body)(range.begin, range.end, threadIndex);
+
+	//Whoever finishes the last range wakes parallelFor back up
+	if (m_RangesRemaining.fetch_sub(1) == 1)
+	{
+		std::lock_guard<std::mutex> lock(m_DoneMutex);
+		m_DoneCondition.notify_all();
+	}
+	return true;
+}
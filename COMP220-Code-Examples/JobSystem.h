@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Small work-stealing thread pool, each thread has its own queue of ranges and steals from the others once it runs dry
+class JobSystem
+{
+public:
+	//Called with a [begin, end) range of the loop and the index of the thread running it, 0 is the thread that called parallelFor
+	typedef std::function<void(size_t begin, size_t end, unsigned int threadIndex)> RangeFunction;
+
+	//threadCount includes the calling thread, 0 uses one thread per hardware core
+	explicit JobSystem(unsigned int threadCount = 0);
+	~JobSystem();
+
+	//Splits [0, count) into ranges of grainSize and runs them across every thread, returns once they have all finished
+	//Not re-entrant, body must not call parallelFor itself
+	void parallelFor(size_t count, size_t grainSize, const RangeFunction& body);
+
+	unsigned int getThreadCount() const { return m_ThreadCount; }
+
+private:
+	struct Range
+	{
+		size_t begin, end;
+	};
+
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<Range> ranges;
+	};
+
+	void workerLoop(unsigned int threadIndex);
+	//Runs one range from this threads own queue, or steals one from another, returns false if every queue was empty
+	bool runOneRange(unsigned int threadIndex);
+
+	unsigned int m_ThreadCount;
+	std::vector<std::thread> m_Workers;
+	std::vector<std::unique_ptr<WorkQueue>> m_Queues;
+
+	const RangeFunction* m_Body;
+	std::atomic<size_t> m_RangesRemaining;
+
+	//Workers sleep on this until parallelFor bumps the generation
+	std::mutex m_WakeMutex;
+	std::condition_variable m_WakeCondition;
+	unsigned long long m_Generation;
+	bool m_Quit;
+
+	//parallelFor sleeps on this until the last range finishes
+	std::mutex m_DoneMutex;
+	std::condition_variable m_DoneCondition;
+};
@@ -2,17 +2,16 @@
 
 #include <iostream>
 
-bool LoadModel(const char* filePath, std::vector<Vertex>& ModelVertices, std::vector<unsigned>& ModelIndices, std::string& texturePath)
+bool LoadModel(const char* filePath, std::vector<Vertex>& ModelVertices, std::vector<unsigned>& ModelIndices, std::string& texturePath, std::string& errorMessage)
 {
 	//Calls the asset importer library
 	Assimp::Importer importer;
 	//Loads the model into an asset importer scene object
-	const aiScene* scene = importer.ReadFile(filePath, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals |
-		aiProcess_GenUVCoords | aiProcess_CalcTangentSpace | aiProcess_FixInfacingNormals);
+	const aiScene* scene = importer.ReadFile(filePath, modelImportFlags);
 	//Checks if model import was sucessful by checking scene is not empty, that it is not incomplete according to assimp and that it has a root node and a mesh
 	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode || !scene->HasMeshes()) {
-		//If scene is messed up display an error and return false to quit out of the function
-		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Model import failed", importer.GetErrorString(), NULL);
+		//If scene is messed up pass the error back and return false to quit out of the function
+		errorMessage = importer.GetErrorString();
 		return false;
 	}
 	//JUST A DEMO, assuming just one texture! You can use other textures, see documentation!
@@ -33,7 +32,11 @@ bool LoadModel(const char* filePath, std::vector<Vertex>& ModelVertices, std::ve
 
 	aiMesh* mesh = scene->mMeshes[0];
 	//Quits out function if no mesh is found
-	if (!mesh) return false;
+	if (!mesh)
+	{
+		errorMessage = "Model has no mesh";
+		return false;
+	}
 
 	ModelVertices.clear();
 	ModelIndices.clear();
@@ -89,5 +92,10 @@ bool LoadModel(const char* filePath, std::vector<Vertex>& ModelVertices, std::ve
 	}
 
 	//Returns true if modelVertices and modelIndices were populated succesfully, otherwise returns false
-	return !(ModelVertices.empty() || ModelIndices.empty());
+	if (ModelVertices.empty() || ModelIndices.empty())
+	{
+		errorMessage = "Model has no vertices or indices";
+		return false;
+	}
+	return true;
 }
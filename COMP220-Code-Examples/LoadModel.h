@@ -19,4 +19,9 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-bool LoadModel(const char* filePath, std::vector<Vertex>& ModelVertices, std::vector<unsigned>& ModelIndices, std::string& texturePath);
\ No newline at end of file
+//Assimp post processing LoadModel runs, cached meshes remember it so changing it throws the cache away
+const unsigned int modelImportFlags = aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenSmoothNormals |
+	aiProcess_GenUVCoords | aiProcess_CalcTangentSpace | aiProcess_FixInfacingNormals;
+
+//Safe to call from any thread, so rather than showing an error it fills in errorMessage and returns false
+bool LoadModel(const char* filePath, std::vector<Vertex>& ModelVertices, std::vector<unsigned>& ModelIndices, std::string& texturePath, std::string& errorMessage);
\ No newline at end of file
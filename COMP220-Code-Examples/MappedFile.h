@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+//Read only view of a whole file through the operating systems memory mapping, pages are only read in when they are touched
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	//Each mapping is owned by exactly one MappedFile
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	//Maps filePath, closing whatever was mapped before, false if it could not be opened or is empty
+	bool open(const std::string& filePath);
+	void close();
+
+	const unsigned char* getData() const { return m_Data; }
+	size_t getSize() const { return m_Size; }
+
+private:
+	const unsigned char* m_Data;
+	size_t m_Size;
+#ifdef _WIN32
+	void* m_File;
+	void* m_Mapping;
+#endif
+};
@@ -0,0 +1,64 @@
+#include "MemoryStats.h"
+
+#include <atomic>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+//Plain globals rather than function statics, operator new can be called before main and during static initialisation
+static std::atomic<uint64_t> allocatedBytes(0);
+static std::atomic<uint64_t> allocationCount(0);
+static std::atomic<uint64_t> liveBytes(0);
+static std::atomic<uint64_t> peakLiveBytes(0);
+
+//Set before main by MemoryStatsNew.cpp when it is linked in
+static bool operatorNewCounted = false;
+
+void RecordAllocation(size_t bytes)
+{
+	allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+	allocationCount.fetch_add(1, std::memory_order_relaxed);
+	uint64_t live = liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+
+	//Only ever raises the peak, retries if another thread raised it at the same time
+	uint64_t peak = peakLiveBytes.load(std::memory_order_relaxed);
+	while (live > peak && !peakLiveBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+	{
+	}
+}
+
+void RecordDeallocation(size_t bytes)
+{
+	liveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+uint64_t GetAllocatedBytes() { return allocatedBytes.load(std::memory_order_relaxed); }
+uint64_t GetAllocationCount() { return allocationCount.load(std::memory_order_relaxed); }
+uint64_t GetLiveBytes() { return liveBytes.load(std::memory_order_relaxed); }
+uint64_t GetPeakLiveBytes() { return peakLiveBytes.load(std::memory_order_relaxed); }
+void ResetPeakLiveBytes() { peakLiveBytes.store(liveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed); }
+bool IsOperatorNewCounted() { return operatorNewCounted; }
+void SetOperatorNewCounted() { operatorNewCounted = true; }
+
+uint64_t GetPeakResidentBytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+	return counters.PeakWorkingSetSize;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+	return usage.ru_maxrss;
+#else
+	//Linux reports it in kilobytes
+	return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
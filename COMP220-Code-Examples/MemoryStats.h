@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+//Counts heap allocations through the aligned particle allocator, and through a replacement global operator new when MemoryStatsNew.cpp is linked in
+//Lets the benchmarks report how many bytes a step allocates without an external profiler
+
+//Bytes and calls allocated since the program started, never goes down
+uint64_t GetAllocatedBytes();
+uint64_t GetAllocationCount();
+//Bytes allocated and not yet freed, and the most that has been live at once since the last ResetPeakLiveBytes
+uint64_t GetLiveBytes();
+uint64_t GetPeakLiveBytes();
+void ResetPeakLiveBytes();
+
+//True when the replacement operator new is linked in, otherwise only the particle allocator is counted
+bool IsOperatorNewCounted();
+void SetOperatorNewCounted();
+
+//Largest resident set the process has had so far, as reported by the OS, 0 if it cannot be read
+uint64_t GetPeakResidentBytes();
+
+//Called by allocators that do not go through operator new so they are counted too
+void RecordAllocation(size_t bytes);
+void RecordDeallocation(size_t bytes);
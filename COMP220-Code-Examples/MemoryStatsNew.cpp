@@ -0,0 +1,71 @@
+#include "MemoryStats.h"
+
+#include <cstdlib>
+#include <new>
+
+//Replaces the global operator new and delete so every allocation is counted
+//Only linked into ParticleSimHeadless, the header and atomics on every allocation are not worth paying in the interactive build
+
+//operator delete is not told the size, so each block starts with it, 16 bytes keeps the rest aligned for anything new returns
+static const size_t allocationHeaderSize = 16;
+
+//Runs during static initialisation so the benchmarks know the counts include operator new
+static const bool registered = (SetOperatorNewCounted(), true);
+
+void* operator new(size_t bytes)
+{
+	void* block = malloc(bytes + allocationHeaderSize);
+	if (!block) throw std::bad_alloc();
+	*static_cast<size_t*>(block) = bytes;
+	RecordAllocation(bytes);
+	return static_cast<char*>(block) + allocationHeaderSize;
+}
+
+void* operator new[](size_t bytes)
+{
+	return operator new(bytes);
+}
+
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept
+{
+	try { return operator new(bytes); }
+	catch (...) { return nullptr; }
+}
+
+void* operator new[](size_t bytes, const std::nothrow_t&) noexcept
+{
+	return operator new(bytes, std::nothrow);
+}
+
+void operator delete(void* memory) noexcept
+{
+	if (!memory) return;
+	void* block = static_cast<char*>(memory) - allocationHeaderSize;
+	RecordDeallocation(*static_cast<size_t*>(block));
+	free(block);
+}
+
+void operator delete[](void* memory) noexcept
+{
+	operator delete(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+	operator delete(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+	operator delete(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+	operator delete(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+	operator delete(memory);
+}
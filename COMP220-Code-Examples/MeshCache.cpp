@@ -0,0 +1,116 @@
+#include "MeshCache.h"
+#include "MappedFile.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	const char meshCacheMagic[4] = { 'M', 'S', 'H', 'C' };
+	const uint64_t blockAlignment = 16;
+
+	uint64_t AlignOffset(uint64_t offset)
+	{
+		return (offset + blockAlignment - 1) & ~(blockAlignment - 1);
+	}
+
+	bool WritePadded(FILE* file, const void* data, size_t size, uint64_t& offset)
+	{
+		static const unsigned char padding[blockAlignment] = {};
+		uint64_t alignedOffset = AlignOffset(offset);
+		size_t paddingSize = static_cast<size_t>(alignedOffset - offset);
+		if (paddingSize > 0 && fwrite(padding, 1, paddingSize, file) != paddingSize) return false;
+		if (size > 0 && fwrite(data, 1, size, file) != size) return false;
+		offset = alignedOffset + size;
+		return true;
+	}
+}
+
+std::string GetMeshCachePath(const std::string& modelPath)
+{
+	return modelPath + ".meshcache";
+}
+
+bool WriteMeshCache(const std::string& cachePath, const MeshData& mesh, uint64_t sourceHash, uint64_t sourceSize, uint32_t importFlags)
+{
+	MeshCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, meshCacheMagic, sizeof(header.magic));
+	header.version = meshCacheVersion;
+	header.sourceHash = sourceHash;
+	header.sourceSize = sourceSize;
+	header.importFlags = importFlags;
+	header.vertexSize = sizeof(Vertex);
+	header.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+	header.indexCount = static_cast<uint32_t>(mesh.indices.size());
+	header.texturePathLength = static_cast<uint32_t>(mesh.texturePath.size());
+	for (int axis = 0; axis < 3; axis++)
+	{
+		header.boundsMinimum[axis] = mesh.localBounds.minimum[axis];
+		header.boundsMaximum[axis] = mesh.localBounds.maximum[axis];
+	}
+
+	size_t vertexBytes = mesh.vertices.size() * sizeof(Vertex);
+	size_t indexBytes = mesh.indices.size() * sizeof(unsigned int);
+	header.vertexOffset = AlignOffset(sizeof(MeshCacheHeader));
+	header.indexOffset = AlignOffset(header.vertexOffset + vertexBytes);
+	header.texturePathOffset = AlignOffset(header.indexOffset + indexBytes);
+
+	//Written to a temporary name and renamed over the top, so a crash part way through never leaves a cache that looks whole
+	std::string temporaryPath = cachePath + ".tmp";
+	FILE* file = fopen(temporaryPath.c_str(), "wb");
+	if (!file) return false;
+
+	uint64_t offset = 0;
+	bool written = WritePadded(file, &header, sizeof(header), offset)
+		&& WritePadded(file, mesh.vertices.data(), vertexBytes, offset)
+		&& WritePadded(file, mesh.indices.data(), indexBytes, offset)
+		&& WritePadded(file, mesh.texturePath.data(), mesh.texturePath.size(), offset);
+	written = (fclose(file) == 0) && written;
+
+	if (written)
+	{
+		remove(cachePath.c_str());
+		written = rename(temporaryPath.c_str(), cachePath.c_str()) == 0;
+	}
+	if (!written) remove(temporaryPath.c_str());
+	return written;
+}
+
+bool ReadMeshCache(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize, uint32_t importFlags, MeshData& mesh)
+{
+	MappedFile cacheFile;
+	if (!cacheFile.open(cachePath) || cacheFile.getSize() < sizeof(MeshCacheHeader)) return false;
+
+	MeshCacheHeader header;
+	memcpy(&header, cacheFile.getData(), sizeof(header));
+	if (memcmp(header.magic, meshCacheMagic, sizeof(header.magic)) != 0 || header.version != meshCacheVersion
+		|| header.sourceHash != sourceHash || header.sourceSize != sourceSize || header.importFlags != importFlags || header.vertexSize != sizeof(Vertex))
+	{
+		return false;
+	}
+
+	//Every block has to sit inside the file, otherwise the cache was cut short
+	uint64_t fileSize = cacheFile.getSize();
+	uint64_t vertexBytes = uint64_t(header.vertexCount) * sizeof(Vertex);
+	uint64_t indexBytes = uint64_t(header.indexCount) * sizeof(unsigned int);
+	if (header.vertexOffset > fileSize || vertexBytes > fileSize - header.vertexOffset
+		|| header.indexOffset > fileSize || indexBytes > fileSize - header.indexOffset
+		|| header.texturePathOffset > fileSize || header.texturePathLength > fileSize - header.texturePathOffset)
+	{
+		return false;
+	}
+
+	const unsigned char* data = cacheFile.getData();
+	mesh.vertices.resize(header.vertexCount);
+	if (vertexBytes > 0) memcpy(mesh.vertices.data(), data + header.vertexOffset, static_cast<size_t>(vertexBytes));
+	mesh.indices.resize(header.indexCount);
+	if (indexBytes > 0) memcpy(mesh.indices.data(), data + header.indexOffset, static_cast<size_t>(indexBytes));
+	mesh.texturePath.assign(reinterpret_cast<const char*>(data + header.texturePathOffset), header.texturePathLength);
+	for (int axis = 0; axis < 3; axis++)
+	{
+		mesh.localBounds.minimum[axis] = header.boundsMinimum[axis];
+		mesh.localBounds.maximum[axis] = header.boundsMaximum[axis];
+	}
+	return true;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "MeshRegistry.h"
+#include "FileHash.h"
+
+//Bumped whenever the layout below changes so old caches are treated as misses
+const uint32_t meshCacheVersion = 2;
+
+//Start of every cache file, the blocks it points at follow it in the same file
+struct MeshCacheHeader
+{
+	char magic[4];
+	uint32_t version;
+	//Hash of the model file the cache was made from, a changed model no longer matches
+	uint64_t sourceHash;
+	//Size in bytes of the same file, checked alongside the hash
+	uint64_t sourceSize;
+	//Import settings used, a different import no longer matches
+	uint32_t importFlags;
+	//Size of Vertex when written, guards against Vertex gaining or losing fields
+	uint32_t vertexSize;
+	uint32_t vertexCount;
+	uint32_t indexCount;
+	uint32_t texturePathLength;
+	float boundsMinimum[3];
+	float boundsMaximum[3];
+	//Offsets from the start of the file, each block starts 16 byte aligned
+	uint64_t vertexOffset;
+	uint64_t indexOffset;
+	uint64_t texturePathOffset;
+};
+
+//Where the cache for a model file lives, next to the model itself
+std::string GetMeshCachePath(const std::string& modelPath);
+
+//Writes the imported mesh out so later loads can skip the importer, false if the file could not be written
+bool WriteMeshCache(const std::string& cachePath, const MeshData& mesh, uint64_t sourceHash, uint64_t sourceSize, uint32_t importFlags);
+
+//Maps the cache and copies its blocks into mesh, false if it is missing, damaged or was made from a different source or import
+bool ReadMeshCache(const std::string& cachePath, uint64_t sourceHash, uint64_t sourceSize, uint32_t importFlags, MeshData& mesh);
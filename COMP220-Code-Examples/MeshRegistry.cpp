@@ -0,0 +1,82 @@
+#include "MeshRegistry.h"
+#include "LoadModel.h"
+#include "MeshCache.h"
+
+#include <chrono>
+
+MeshRegistry::MeshRegistry()
+	: m_ReuseCount(0), m_CacheHitCount(0)
+{
+}
+
+MeshHandle MeshRegistry::load(const std::string& filePath)
+{
+	//Hands back the existing copy if this file has already been imported
+	std::map<std::string, MeshHandle>::iterator existingMesh = m_HandlesByPath.find(filePath);
+	if (existingMesh != m_HandlesByPath.end())
+	{
+		m_ReuseCount++;
+		return existingMesh->second;
+	}
+
+	MeshData newMesh;
+	newMesh.filePath = filePath;
+	newMesh.asset = invalidAssetHandle;
+	std::string error;
+	if (!readOrImport(newMesh, error))
+	{
+		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Model import failed", error.c_str(), NULL);
+		return invalidMeshHandle;
+	}
+
+	MeshHandle handle = static_cast<MeshHandle>(m_Meshes.size());
+	m_Meshes.push_back(newMesh);
+	m_HandlesByPath[filePath] = handle;
+	return handle;
+}
+
+MeshHandle MeshRegistry::loadAsync(const std::string& filePath, AssetQueue& assets, AssetQueue::UploadFunction upload)
+{
+	std::map<std::string, MeshHandle>::iterator existingMesh = m_HandlesByPath.find(filePath);
+	if (existingMesh != m_HandlesByPath.end())
+	{
+		m_ReuseCount++;
+		return existingMesh->second;
+	}
+
+	//The slot is handed out now and filled in by the worker, nothing else touches it until the asset is ready
+	MeshHandle handle = static_cast<MeshHandle>(m_Meshes.size());
+	m_Meshes.push_back(MeshData());
+	MeshData& newMesh = m_Meshes.back();
+	newMesh.filePath = filePath;
+	m_HandlesByPath[filePath] = handle;
+	newMesh.asset = assets.request(filePath, [this, &newMesh](std::string& error) { return readOrImport(newMesh, error); }, upload);
+	return handle;
+}
+
+bool MeshRegistry::readOrImport(MeshData& mesh, std::string& error)
+{
+	auto startTime = std::chrono::steady_clock::now();
+
+	//The cache is only trusted while the model file and import settings are the same as when it was written
+	uint64_t sourceSize = 0;
+	uint64_t sourceHash = HashFile(mesh.filePath, &sourceSize);
+	std::string cachePath = GetMeshCachePath(mesh.filePath);
+	mesh.loadedFromCache = sourceHash != 0 && ReadMeshCache(cachePath, sourceHash, sourceSize, modelImportFlags, mesh);
+	if (mesh.loadedFromCache)
+	{
+		m_CacheHitCount++;
+	}
+	else
+	{
+		if (!LoadModel(mesh.filePath.c_str(), mesh.vertices, mesh.indices, mesh.texturePath, error))
+		{
+			return false;
+		}
+		mesh.localBounds = CalculateLocalBounds(mesh.vertices);
+		//Failing to write the cache only costs the next run an import, so it is not an error
+		if (sourceHash != 0) WriteMeshCache(cachePath, mesh, sourceHash, sourceSize, modelImportFlags);
+	}
+	mesh.loadMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	return true;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Vertex.h"
+#include "Bounds.h"
+#include "AssetQueue.h"
+
+//Lightweight reference to a mesh owned by a MeshRegistry
+typedef unsigned int MeshHandle;
+const MeshHandle invalidMeshHandle = ~0u;
+
+//Geometry shared by everything that uses the same model file
+struct MeshData
+{
+	std::string filePath;
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	std::string texturePath;
+	//Worked out once at load time so nothing has to walk the vertices again
+	AABB localBounds;
+	//How long load took and whether it came from the binary cache rather than the importer
+	double loadMilliseconds;
+	bool loadedFromCache;
+	//The AssetQueue request filling this in for loadAsync, invalidAssetHandle once load has filled it in directly
+	AssetHandle asset;
+};
+
+//Imports each model file once through Assimp and hands out handles to the shared copy
+//Imports are also kept in a binary cache next to the model, so later runs map that instead of running the importer
+class MeshRegistry
+{
+public:
+	MeshRegistry();
+
+	//Returns the handle for filePath, only importing it the first time it is asked for, invalidMeshHandle if the import failed
+	//Shows the importer's error when it fails, so it must be called from the thread that owns the window
+	MeshHandle load(const std::string& filePath);
+	//Same as load but the import runs on one of the queues worker threads, so the mesh must not be used until its asset is ready
+	//Nothing is shown if the import fails, the error is left in the asset for the caller to report
+	//upload runs on the render thread once the import has finished, only the first request for a file gets its upload run
+	MeshHandle loadAsync(const std::string& filePath, AssetQueue& assets, AssetQueue::UploadFunction upload);
+	const MeshData& getMesh(MeshHandle handle) const { return m_Meshes[handle]; }
+
+	size_t getMeshCount() const { return m_Meshes.size(); }
+	//How many times load was answered from an earlier import
+	unsigned int getReuseCount() const { return m_ReuseCount; }
+	//How many meshes were read from the binary cache instead of imported
+	unsigned int getCacheHitCount() const { return m_CacheHitCount.load(std::memory_order_relaxed); }
+
+private:
+	//Reads the cached copy of mesh.filePath or imports it, touches nothing but mesh and the hit count so it can run on any thread
+	bool readOrImport(MeshData& mesh, std::string& error);
+
+	//A deque so loadAsync can add meshes while workers are still filling in earlier ones
+	std::deque<MeshData> m_Meshes;
+	std::map<std::string, MeshHandle> m_HandlesByPath;
+	unsigned int m_ReuseCount;
+	//Counted from the worker threads as well
+	std::atomic<unsigned int> m_CacheHitCount;
+};
@@ -0,0 +1,44 @@
+#include "ParticleEmitter.h"
+#include "Random.h"
+
+#include <algorithm>
+
+//Each batch uses this many streams, one per axis of position and velocity with room to spare
+const uint64_t randomStreamsPerBatch = 8;
+
+//Fills values with the given axis of a batch, skips the random numbers when there is no spread
+static void FillAxis(uint64_t seed, uint64_t stream, uint32_t firstCounter, float minimum, float maximum, float* values, size_t count)
+{
+	if (minimum == maximum) std::fill(values, values + count, minimum);
+	else FillRandomRange(MakeRandomKey(seed, stream), firstCounter, minimum, maximum, values, count);
+}
+
+ParticleEmitter::ParticleEmitter(float rate, const AABB& spawnVolume, glm::vec3 velocity, glm::vec3 velocitySpread)
+	: m_Rate(rate), m_SpawnVolume(spawnVolume), m_Velocity(velocity), m_VelocitySpread(velocitySpread), m_Accumulator(0.0), m_EmittedCount(0)
+{
+}
+
+unsigned int ParticleEmitter::advance(float deltaTime)
+{
+	if (m_Rate <= 0.0f || deltaTime <= 0.0f) return 0;
+
+	m_Accumulator += static_cast<double>(m_Rate) * deltaTime;
+	unsigned int numToSpawn = static_cast<unsigned int>(m_Accumulator);
+	m_Accumulator -= numToSpawn;
+	m_EmittedCount += numToSpawn;
+	return numToSpawn;
+}
+
+void ParticleEmitter::generate(uint64_t seed, uint64_t batch, uint32_t firstCounter, size_t count, const EmitterOutput& output) const
+{
+	uint64_t stream = batch * randomStreamsPerBatch;
+	FillAxis(seed, stream + 0, firstCounter, m_SpawnVolume.minimum.x, m_SpawnVolume.maximum.x, output.positionX, count);
+	FillAxis(seed, stream + 1, firstCounter, m_SpawnVolume.minimum.y, m_SpawnVolume.maximum.y, output.positionY, count);
+	FillAxis(seed, stream + 2, firstCounter, m_SpawnVolume.minimum.z, m_SpawnVolume.maximum.z, output.positionZ, count);
+
+	glm::vec3 slowest = m_Velocity - m_VelocitySpread;
+	glm::vec3 fastest = m_Velocity + m_VelocitySpread;
+	FillAxis(seed, stream + 3, firstCounter, slowest.x, fastest.x, output.velocityX, count);
+	FillAxis(seed, stream + 4, firstCounter, slowest.y, fastest.y, output.velocityY, count);
+	FillAxis(seed, stream + 5, firstCounter, slowest.z, fastest.z, output.velocityZ, count);
+}
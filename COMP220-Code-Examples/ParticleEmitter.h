@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "Bounds.h"
+
+//Where ParticleEmitter::generate writes each new particles position and velocity, one array per axis
+struct EmitterOutput
+{
+	float* positionX;
+	float* positionY;
+	float* positionZ;
+	float* velocityX;
+	float* velocityY;
+	float* velocityZ;
+};
+
+//Spawns particles continuously at a fixed rate, each somewhere random inside a box with a random spread around one velocity
+//Only decides how many particles to make and where, the simulation finds slots for them
+class ParticleEmitter
+{
+public:
+	//rate is particles per second of simulation time, spawnVolume is in world space
+	//Each particles velocity is velocity plus up to velocitySpread either way on each axis, picked uniformly
+	ParticleEmitter(float rate, const AABB& spawnVolume, glm::vec3 velocity, glm::vec3 velocitySpread = glm::vec3(0.0f));
+
+	//Moves the emitter on by deltaTime seconds and returns how many particles it spawns in that time
+	//Fractions of a particle are carried over, so low rates still spawn the right number over time
+	unsigned int advance(float deltaTime);
+
+	//Writes positions and velocities for particles firstCounter to firstCounter + count of a batch
+	//The numbers come from counter based streams keyed on seed and batch, so a batch can be split over threads however it likes
+	//and the same seed and batch always give exactly the same particles
+	void generate(uint64_t seed, uint64_t batch, uint32_t firstCounter, size_t count, const EmitterOutput& output) const;
+
+	void setRate(float rate) { m_Rate = rate; }
+	float getRate() const { return m_Rate; }
+	void setSpawnVolume(const AABB& spawnVolume) { m_SpawnVolume = spawnVolume; }
+	const AABB& getSpawnVolume() const { return m_SpawnVolume; }
+	void setVelocity(glm::vec3 velocity, glm::vec3 velocitySpread) { m_Velocity = velocity; m_VelocitySpread = velocitySpread; }
+
+	//Particles spawned so far
+	unsigned long long getEmittedCount() const { return m_EmittedCount; }
+
+private:
+	float m_Rate;
+	AABB m_SpawnVolume;
+	glm::vec3 m_Velocity;
+	glm::vec3 m_VelocitySpread;
+	//Part of a particle owed from earlier steps, always below 1
+	double m_Accumulator;
+	unsigned long long m_EmittedCount;
+};
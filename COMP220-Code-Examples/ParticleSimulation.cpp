@@ -0,0 +1,478 @@
+#include "ParticleSimulation.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+//Sorts candidate pairs so collisions are handled in particle order whichever way they were found
+static bool CompareParticleThenOther(const CollisionPair& a, const CollisionPair& b)
+{
+	return a.particle != b.particle ? a.particle < b.particle : a.other < b.other;
+}
+
+static bool CompareHitParticle(const ParticleHit& a, const ParticleHit& b)
+{
+	return a.particle < b.particle;
+}
+
+ParticleSimulation::ParticleSimulation()
+	: m_GlassModel(1.0f), m_JobSystem(nullptr), m_ContinuousCollision(true), m_CollisionCount(0), m_DeletionDelay(defaultDeletionDelay), m_DeletionCount(0),
+	m_CompactionThreshold(defaultCompactionThreshold), m_CompactionCount(0),
+	m_Seed(defaultRandomSeed), m_SpawnBatchCount(0)
+{
+	m_ThreadCollisions.resize(1);
+	m_ThreadHitMasks.resize(1);
+	m_ParticleLocalBounds = { glm::vec3(0.0f), glm::vec3(0.0f) };
+}
+
+void ParticleSimulation::setJobSystem(JobSystem* jobSystem)
+{
+	m_JobSystem = jobSystem;
+	m_ThreadCollisions.resize(jobSystem ? jobSystem->getThreadCount() : 1);
+	m_ThreadHitMasks.resize(m_ThreadCollisions.size());
+}
+
+void ParticleSimulation::forEachRange(size_t count, const JobSystem::RangeFunction& body)
+{
+	forEachRange(0, count, body);
+}
+
+void ParticleSimulation::forEachRange(size_t first, size_t last, const JobSystem::RangeFunction& body)
+{
+	//Cuts every range at the chunk boundaries of the particle arrays, so each piece body sees is contiguous in memory
+	JobSystem::RangeFunction chunkedBody = [&](size_t begin, size_t end, unsigned int threadIndex)
+	{
+		begin += first;
+		end += first;
+		while (begin < end)
+		{
+			size_t chunkEnd = std::min(end, ((begin >> particleChunkBits) + 1) << particleChunkBits);
+			body(begin, chunkEnd, threadIndex);
+			begin = chunkEnd;
+		}
+	};
+
+	if (m_JobSystem) m_JobSystem->parallelFor(last - first, particleGrainSize, chunkedBody);
+	else chunkedBody(0, last - first, 0);
+}
+
+void ParticleSimulation::setParticleMesh(const std::vector<Vertex>& particleVertices)
+{
+	m_ParticleLocalBounds = CalculateLocalBounds(particleVertices);
+}
+
+void ParticleSimulation::setGlass(const std::vector<Vertex>& glassVertices, glm::vec3 position, glm::vec3 scale)
+{
+	setGlass(CalculateLocalBounds(glassVertices), position, scale);
+}
+
+void ParticleSimulation::setGlass(const AABB& glassLocalBounds, glm::vec3 position, glm::vec3 scale)
+{
+	//Glass identity matrix moved and scaled into place
+	m_GlassModel = glm::mat4(1.0f);
+	m_GlassModel = glm::translate(m_GlassModel, position);
+	m_GlassModel = glm::scale(m_GlassModel, scale);
+
+	AABB glassBounds = TransformBounds(glassLocalBounds, m_GlassModel);
+	if (m_Colliders.empty()) m_Colliders.push_back(glassBounds);
+	else m_Colliders[0] = glassBounds;
+}
+
+void ParticleSimulation::addCollider(const AABB& worldBounds)
+{
+	//Keeps slot 0 free for the glass if it has not been placed yet
+	if (m_Colliders.empty()) m_Colliders.push_back({ glm::vec3(0.0f), glm::vec3(0.0f) });
+	m_Colliders.push_back(worldBounds);
+}
+
+void ParticleSimulation::spawn(unsigned int numOfParticles)
+{
+	m_Particles.resize(0);
+	m_NewCollisions.clear();
+	m_CollisionCount = 0;
+	m_DeletionTimers.clear();
+	m_NewDeletions.clear();
+	m_DeletionCount = 0;
+	m_FreeSlots.clear();
+	m_CompactionRemap.clear();
+	m_SpawnBatchCount = 0;
+	addParticles(numOfParticles);
+}
+
+void ParticleSimulation::addParticles(unsigned int numOfParticles)
+{
+	size_t first = m_Particles.size();
+	m_Particles.resize(first + numOfParticles);
+
+	//Cells twice the size of a particle mean most particles only sit in one cell
+	glm::vec3 particleSize = (m_ParticleLocalBounds.maximum - m_ParticleLocalBounds.minimum) * particleScale;
+	float largestSide = std::max(particleSize.x, std::max(particleSize.y, particleSize.z));
+	if (largestSide > 0.0f) m_Grid.setCellSize(largestSide * 2.0f);
+
+	//randomly places particle positions between -1 and 1 for the x and y values and between -2 and 0 for the z values
+	const ParticleEmitter spawnEmitter = CreateSpawnEmitter(0.0f);
+	uint64_t batch = m_SpawnBatchCount++;
+
+	//Each particles numbers only depend on the seed, the batch and where it is in the batch, so the threads can split it up any way
+	ParticleStore& p = m_Particles;
+	forEachRange(first, p.size(), [&](size_t begin, size_t end, unsigned int)
+	{
+		size_t count = end - begin;
+		EmitterOutput output = { &p.positionX[begin], &p.positionY[begin], &p.positionZ[begin], &p.velocityX[begin], &p.velocityY[begin], &p.velocityZ[begin] };
+		spawnEmitter.generate(m_Seed, batch, static_cast<uint32_t>(begin - first), count, output);
+
+		//The store set state to moving when it grew, so only these are left
+		std::copy(&p.positionX[begin], &p.positionX[begin] + count, &p.previousPositionX[begin]);
+		std::copy(&p.positionY[begin], &p.positionY[begin] + count, &p.previousPositionY[begin]);
+		std::copy(&p.positionZ[begin], &p.positionZ[begin] + count, &p.previousPositionZ[begin]);
+		std::fill(&p.scale[begin], &p.scale[begin] + count, particleScale);
+
+		calculateParticleBounds(begin, end);
+	});
+}
+
+ParticleEmitter CreateSpawnEmitter(float rate)
+{
+	AABB spawnVolume = { glm::vec3(-1.0f, -1.0f, -2.0f), glm::vec3(1.0f, 1.0f, 0.0f) };
+	return ParticleEmitter(rate, spawnVolume, particleLocalVelocity * particleScale);
+}
+
+size_t ParticleSimulation::addEmitter(const ParticleEmitter& emitter)
+{
+	m_Emitters.push_back(emitter);
+	return m_Emitters.size() - 1;
+}
+
+void ParticleSimulation::initialiseParticle(size_t i, glm::vec3 position, glm::vec3 velocity)
+{
+	m_Particles.positionX[i] = position.x;
+	m_Particles.positionY[i] = position.y;
+	m_Particles.positionZ[i] = position.z;
+	m_Particles.previousPositionX[i] = position.x;
+	m_Particles.previousPositionY[i] = position.y;
+	m_Particles.previousPositionZ[i] = position.z;
+
+	m_Particles.velocityX[i] = velocity.x;
+	m_Particles.velocityY[i] = velocity.y;
+	m_Particles.velocityZ[i] = velocity.z;
+
+	m_Particles.scale[i] = particleScale;
+	m_Particles.state[i] = PARTICLE_MOVING;
+}
+
+void ParticleSimulation::emitParticles(float deltaTime)
+{
+	PROFILE_ZONE("Emission");
+	for (size_t e = 0; e < m_Emitters.size(); e++)
+	{
+		ParticleEmitter& emitter = m_Emitters[e];
+		unsigned int numToSpawn = emitter.advance(deltaTime);
+
+		//Grows the store once for everything the free slots cannot hold, rather than a particle at a time
+		size_t numOfReused = std::min<size_t>(numToSpawn, m_FreeSlots.size());
+		size_t first = m_Particles.size();
+		if (numToSpawn > numOfReused) m_Particles.resize(first + numToSpawn - numOfReused);
+
+		//Makes the whole batch in one go into scratch space, the slots it goes into are scattered so it is copied in below
+		m_EmitScratch.resize(numToSpawn * 6);
+		float* scratch = m_EmitScratch.empty() ? nullptr : &m_EmitScratch[0];
+		EmitterOutput output = { scratch, scratch + numToSpawn, scratch + numToSpawn * 2, scratch + numToSpawn * 3, scratch + numToSpawn * 4, scratch + numToSpawn * 5 };
+		emitter.generate(m_Seed, m_SpawnBatchCount++, 0, numToSpawn, output);
+
+		for (unsigned int n = 0; n < numToSpawn; n++)
+		{
+			//Takes the most recently freed slot first, it is the one most likely to still be in cache
+			size_t i;
+			if (n < numOfReused)
+			{
+				i = m_FreeSlots.back();
+				m_FreeSlots.pop_back();
+			}
+			else
+			{
+				i = first + n - numOfReused;
+			}
+
+			glm::vec3 position = glm::vec3(output.positionX[n], output.positionY[n], output.positionZ[n]);
+			initialiseParticle(i, position, glm::vec3(output.velocityX[n], output.velocityY[n], output.velocityZ[n]));
+		}
+	}
+	//The update pass that follows works out the bounds of every new particle
+}
+
+void ParticleSimulation::compact()
+{
+	PROFILE_ZONE("Compaction");
+	if (m_Particles.compact(m_CompactionRemap) == 0) return;
+
+	//Only particles that have collided but not been deleted yet have timers, so every pending id still points at a live particle
+	m_DeletionTimers.remapIds(m_CompactionRemap);
+	m_FreeSlots.clear();
+	m_NewCollisions.clear();
+	m_NewDeletions.clear();
+	m_CompactionCount++;
+}
+
+void ParticleSimulation::step(float deltaTime)
+{
+	PROFILE_ZONE("Step");
+
+	//Every deleted particle is in the free list, so its size is how much of the store is dead
+	if (!m_FreeSlots.empty() && m_FreeSlots.size() >= m_CompactionThreshold * m_Particles.size()) compact();
+	m_NewCollisions.clear();
+
+	if (!m_Emitters.empty()) emitParticles(deltaTime);
+
+	ParticleStore& p = m_Particles;
+
+	//Every particle only touches its own slots so the ranges can run on any thread
+	ProfileZone updateZone("Update");
+	forEachRange(p.size(), [&](size_t begin, size_t end, unsigned int)
+	{
+		//Gravity, drag and wind on every moving particle, several particles at a time
+		IntegrateVerlet(m_IntegratorSettings, deltaTime, p, begin, end - begin);
+
+		//Recalculates the bounds to cover the move the particles just made, done as its own pass so it stays branch free
+		PROFILE_ZONE("Bounds");
+		calculateParticleBounds(begin, end);
+	});
+	updateZone.end();
+
+	findCollisions(deltaTime);
+
+	//Deletes every particle whose delay ran out during this step
+	PROFILE_ZONE("Deletion");
+	m_NewDeletions.clear();
+	m_DeletionTimers.advance(deltaTime, m_NewDeletions);
+	for (size_t i = 0; i < m_NewDeletions.size(); i++)
+	{
+		p.state[m_NewDeletions[i]] = PARTICLE_DELETED;
+	}
+	//Deleted particles keep their slot until an emitter needs it
+	m_FreeSlots.insert(m_FreeSlots.end(), m_NewDeletions.begin(), m_NewDeletions.end());
+	m_DeletionCount += static_cast<unsigned int>(m_NewDeletions.size());
+}
+
+void ParticleSimulation::findCollisions(float deltaTime)
+{
+	PROFILE_ZONE("Collision");
+	ParticleStore& p = m_Particles;
+	unsigned int numOfParticles = getParticleCount();
+
+	if (m_Colliders.size() <= bruteForceColliderLimit)
+	{
+		for (size_t t = 0; t < m_ThreadCollisions.size(); t++)
+		{
+			m_ThreadCollisions[t].clear();
+		}
+
+		//Only reads particle state here, anything that hits is collected per thread and handled below
+		forEachRange(numOfParticles, [&](size_t begin, size_t end, unsigned int threadIndex)
+		{
+			std::vector<ParticleHit>& collisions = m_ThreadCollisions[threadIndex];
+			std::vector<uint32_t>& hitMask = m_ThreadHitMasks[threadIndex];
+
+			//Works through the range a block at a time so the hit mask stays small
+			for (size_t blockBegin = begin; blockBegin < end; blockBegin += particleGrainSize)
+			{
+				size_t blockCount = std::min(particleGrainSize, end - blockBegin);
+				hitMask.assign(GetHitMaskWords(blockCount), 0);
+
+				//AABB collision check for each particle compared to each collider, several particles at once
+				//Tests the bounds of the whole move, so anything set here might have touched a collider at some point in the step
+				for (size_t c = 0; c < m_Colliders.size(); c++)
+				{
+					OverlapAabbBatch(p, blockBegin, blockCount, m_Colliders[c], &hitMask[0]);
+				}
+
+				for (size_t word = 0; word < hitMask.size(); word++)
+				{
+					uint32_t bits = hitMask[word];
+					while (bits != 0)
+					{
+						//Picks off the lowest set bit each time round
+						unsigned int bit = 0;
+						while (((bits >> bit) & 1u) == 0) bit++;
+						bits &= bits - 1;
+
+						unsigned int i = static_cast<unsigned int>(blockBegin + word * 32 + bit);
+						//Particles that have already hit something have stopped so cannot hit anything new
+						if (p.state[i] != PARTICLE_MOVING) continue;
+
+						//Sweeps the particle against every collider and keeps the first one it reached
+						ParticleHit hit = { i, 2.0f };
+						for (size_t c = 0; c < m_Colliders.size(); c++)
+						{
+							float timeOfImpact;
+							if (findTimeOfImpact(i, m_Colliders[c], timeOfImpact)) hit.timeOfImpact = std::min(hit.timeOfImpact, timeOfImpact);
+						}
+						if (hit.timeOfImpact <= 1.0f) collisions.push_back(hit);
+					}
+				}
+			}
+		});
+
+		//Which thread ran which range changes from run to run, sorting makes the order the same as a single thread
+		m_MergedCollisions.clear();
+		for (size_t t = 0; t < m_ThreadCollisions.size(); t++)
+		{
+			m_MergedCollisions.insert(m_MergedCollisions.end(), m_ThreadCollisions[t].begin(), m_ThreadCollisions[t].end());
+		}
+		std::sort(m_MergedCollisions.begin(), m_MergedCollisions.end(), CompareHitParticle);
+		for (size_t c = 0; c < m_MergedCollisions.size(); c++)
+		{
+			collide(m_MergedCollisions[c].particle, m_MergedCollisions[c].timeOfImpact, deltaTime);
+		}
+		return;
+	}
+
+	//Broadphase, only pairs of particles and colliders sharing a grid cell come out of here
+	m_Grid.build(p, true);
+	m_CandidatePairs.clear();
+	m_Grid.findColliderPairs(p, m_Colliders, m_CandidatePairs);
+	std::sort(m_CandidatePairs.begin(), m_CandidatePairs.end(), CompareParticleThenOther);
+
+	//Narrowphase, the same sweep as above on just the candidates, each particles pairs sit next to each other after the sort
+	size_t pair = 0;
+	while (pair < m_CandidatePairs.size())
+	{
+		unsigned int i = m_CandidatePairs[pair].particle;
+		float firstImpact = 2.0f;
+		for (; pair < m_CandidatePairs.size() && m_CandidatePairs[pair].particle == i; pair++)
+		{
+			float timeOfImpact;
+			if (findTimeOfImpact(i, m_Colliders[m_CandidatePairs[pair].other], timeOfImpact)) firstImpact = std::min(firstImpact, timeOfImpact);
+		}
+
+		if (p.state[i] == PARTICLE_MOVING && firstImpact <= 1.0f) collide(i, firstImpact, deltaTime);
+	}
+}
+
+bool ParticleSimulation::findTimeOfImpact(unsigned int i, const AABB& collider, float& timeOfImpact) const
+{
+	const ParticleStore& p = m_Particles;
+
+	//Without the sweep it is just an overlap check at the end of the step
+	if (!m_ContinuousCollision)
+	{
+		timeOfImpact = 1.0f;
+		return
+			p.maximumX[i] >= collider.minimum.x && p.minimumX[i] <= collider.maximum.x &&
+			p.maximumY[i] >= collider.minimum.y && p.minimumY[i] <= collider.maximum.y &&
+			p.maximumZ[i] >= collider.minimum.z && p.minimumZ[i] <= collider.maximum.z;
+	}
+
+	//Bounds the particle had at the start of the step, slid along the distance it moved
+	glm::vec3 previousPosition = glm::vec3(p.previousPositionX[i], p.previousPositionY[i], p.previousPositionZ[i]);
+	glm::vec3 position = glm::vec3(p.positionX[i], p.positionY[i], p.positionZ[i]);
+	AABB startBounds = { previousPosition + m_ParticleLocalBounds.minimum * p.scale[i], previousPosition + m_ParticleLocalBounds.maximum * p.scale[i] };
+	return SweepAabb(startBounds, position - previousPosition, collider, timeOfImpact);
+}
+
+void ParticleSimulation::collide(unsigned int i, float timeOfImpact, float deltaTime)
+{
+	ParticleStore& p = m_Particles;
+
+	//Moves the particle back to where it touched so it rests against the collider instead of inside or past it
+	if (timeOfImpact < 1.0f)
+	{
+		p.positionX[i] = p.previousPositionX[i] + (p.positionX[i] - p.previousPositionX[i]) * timeOfImpact;
+		p.positionY[i] = p.previousPositionY[i] + (p.positionY[i] - p.previousPositionY[i]) * timeOfImpact;
+		p.positionZ[i] = p.previousPositionZ[i] + (p.positionZ[i] - p.previousPositionZ[i]) * timeOfImpact;
+		calculateParticleBounds(i);
+	}
+
+	//Marks the first collision so the particle stops moving
+	p.state[i] = PARTICLE_COLLIDED;
+	m_NewCollisions.push_back(i);
+	m_CollisionCount++;
+
+	//Stops drawing the particle a set time after it hits the glass
+	//The timers advance over this whole step next, so the part of the step before the impact is added on
+	m_DeletionTimers.schedule(i, m_DeletionDelay + timeOfImpact * deltaTime);
+}
+
+glm::vec3 ParticleSimulation::getParticlePosition(unsigned int i, float interpolation) const
+{
+	const ParticleStore& p = m_Particles;
+	glm::vec3 previousPosition = glm::vec3(p.previousPositionX[i], p.previousPositionY[i], p.previousPositionZ[i]);
+	glm::vec3 position = glm::vec3(p.positionX[i], p.positionY[i], p.positionZ[i]);
+	return glm::mix(previousPosition, position, interpolation);
+}
+
+glm::mat4 ParticleSimulation::getParticleModel(unsigned int i, float interpolation) const
+{
+	glm::mat4 boxModel = glm::mat4(1.0f);
+	boxModel = glm::translate(boxModel, getParticlePosition(i, interpolation));
+	boxModel = glm::scale(boxModel, glm::vec3(m_Particles.scale[i]));
+	return boxModel;
+}
+
+void ParticleSimulation::captureSnapshot(ParticleSnapshot& snapshot) const
+{
+	const ParticleStore& p = m_Particles;
+	snapshot.previousInstances.clear();
+	snapshot.instances.clear();
+
+	for (size_t i = 0; i < p.size(); i++)
+	{
+		//Deleted particles are left out so the renderer never has to check
+		if (p.state[i] == PARTICLE_DELETED) continue;
+
+		snapshot.previousInstances.push_back(p.previousPositionX[i]);
+		snapshot.previousInstances.push_back(p.previousPositionY[i]);
+		snapshot.previousInstances.push_back(p.previousPositionZ[i]);
+		snapshot.previousInstances.push_back(p.scale[i]);
+		snapshot.instances.push_back(p.positionX[i]);
+		snapshot.instances.push_back(p.positionY[i]);
+		snapshot.instances.push_back(p.positionZ[i]);
+		snapshot.instances.push_back(p.scale[i]);
+	}
+
+	snapshot.collisionCount = m_CollisionCount;
+	snapshot.deletionCount = m_DeletionCount;
+}
+
+void ParticleSimulation::calculateParticleBounds(unsigned int i)
+{
+	calculateParticleBounds(i, i + 1);
+}
+
+void ParticleSimulation::calculateParticleBounds(size_t begin, size_t end)
+{
+	//Particles only have a position and a uniform scale, so the cached mesh bounds just need scaling and moving
+	ParticleStore& p = m_Particles;
+	const glm::vec3 localMinimum = m_ParticleLocalBounds.minimum;
+	const glm::vec3 localMaximum = m_ParticleLocalBounds.maximum;
+
+	//Without the sweep the start of the step is ignored by measuring from the end position twice
+	//Callers never pass a range that crosses a chunk, so the arrays can be walked with plain pointers
+	size_t count = end - begin;
+	const float* __restrict startX = m_ContinuousCollision ? &p.previousPositionX[begin] : &p.positionX[begin];
+	const float* __restrict startY = m_ContinuousCollision ? &p.previousPositionY[begin] : &p.positionY[begin];
+	const float* __restrict startZ = m_ContinuousCollision ? &p.previousPositionZ[begin] : &p.positionZ[begin];
+	const float* __restrict positionX = &p.positionX[begin];
+	const float* __restrict positionY = &p.positionY[begin];
+	const float* __restrict positionZ = &p.positionZ[begin];
+	const float* __restrict scale = &p.scale[begin];
+	float* __restrict minimumX = &p.minimumX[begin];
+	float* __restrict minimumY = &p.minimumY[begin];
+	float* __restrict minimumZ = &p.minimumZ[begin];
+	float* __restrict maximumX = &p.maximumX[begin];
+	float* __restrict maximumY = &p.maximumY[begin];
+	float* __restrict maximumZ = &p.maximumZ[begin];
+
+	//Covers both where the particle started and ended the step so the broadphase sees the whole move
+	for (size_t i = 0; i < count; i++)
+	{
+		//Copied into locals first, std::min and std::max on the array elements return references which stops the loop vectorising
+		float startPositionX = startX[i], startPositionY = startY[i], startPositionZ = startZ[i];
+		float endPositionX = positionX[i], endPositionY = positionY[i], endPositionZ = positionZ[i];
+		minimumX[i] = std::min(startPositionX, endPositionX) + localMinimum.x * scale[i];
+		minimumY[i] = std::min(startPositionY, endPositionY) + localMinimum.y * scale[i];
+		minimumZ[i] = std::min(startPositionZ, endPositionZ) + localMinimum.z * scale[i];
+		maximumX[i] = std::max(startPositionX, endPositionX) + localMaximum.x * scale[i];
+		maximumY[i] = std::max(startPositionY, endPositionY) + localMaximum.y * scale[i];
+		maximumZ[i] = std::max(startPositionZ, endPositionZ) + localMaximum.z * scale[i];
+	}
+}
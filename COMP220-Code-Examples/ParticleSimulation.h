@@ -0,0 +1,185 @@
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Vertex.h"
+#include "ParticleStore.h"
+#include "Bounds.h"
+#include "TimerWheel.h"
+#include "UniformGrid.h"
+#include "JobSystem.h"
+#include "AabbKernel.h"
+#include "ParticleSnapshot.h"
+#include "ParticleEmitter.h"
+#include "VerletIntegrator.h"
+
+//A moving particle found touching a collider, and how far through the step it first touched, from 0 to 1
+struct ParticleHit
+{
+	uint32_t particle;
+	float timeOfImpact;
+};
+
+//Owns every particle and the glass pane so the physics can be stepped without SDL or OpenGL
+class ParticleSimulation
+{
+public:
+	ParticleSimulation();
+
+	//Mesh every particle is built from, only its local bounds are kept
+	void setParticleMesh(const std::vector<Vertex>& particleVertices);
+	void setParticleBounds(const AABB& localBounds) { m_ParticleLocalBounds = localBounds; }
+	//Places the glass in the world and works out its bounds from its vertices
+	void setGlass(const std::vector<Vertex>& glassVertices, glm::vec3 position, glm::vec3 scale);
+	void setGlass(const AABB& glassLocalBounds, glm::vec3 position, glm::vec3 scale);
+	//Adds another world space box particles stop against, the glass is always collider 0
+	void addCollider(const AABB& worldBounds);
+	const std::vector<AABB>& getColliders() const { return m_Colliders; }
+
+	//Every random number the simulation uses comes from this seed, the same seed always spawns exactly the same particles
+	void setSeed(uint64_t seed) { m_Seed = seed; }
+	uint64_t getSeed() const { return m_Seed; }
+
+	//Randomly places numOfParticles particles in front of the glass, spread over the job systems threads
+	void spawn(unsigned int numOfParticles);
+	//Randomly places numOfParticles more particles the same way, leaving the ones already spawned where they are
+	void addParticles(unsigned int numOfParticles);
+	//Adds an emitter that keeps spawning particles every step from then on, returns its index for getEmitter
+	size_t addEmitter(const ParticleEmitter& emitter);
+	ParticleEmitter& getEmitter(size_t index) { return m_Emitters[index]; }
+	size_t getEmitterCount() const { return m_Emitters.size(); }
+	//Spawns whatever the emitters owe, then moves every particle that has not hit the glass, checks it for collisions and deletes any whose delay has run out, deltaTime is in seconds
+	void step(float deltaTime);
+
+	//Removes every deleted particle from the store, sliding the rest down in the same order so the loops only see live particles
+	//Particle indices change, getCompactionRemap says where each one went, and the new collision and deletion lists are cleared
+	void compact();
+	//step compacts the store before it does anything else once at least this fraction of it is deleted particles, above 1 it never does
+	void setCompactionThreshold(float compactionThreshold) { m_CompactionThreshold = compactionThreshold; }
+	//Index each particle had before the last compaction mapped to the one it has now, removedParticle if it was deleted
+	//Anything holding on to particle indices checks getCompactionCount after each step and passes them through this when it changes
+	const std::vector<uint32_t>& getCompactionRemap() const { return m_CompactionRemap; }
+	unsigned int getCompactionCount() const { return m_CompactionCount; }
+
+	//Spreads the update and collision loops over the job systems threads, nullptr runs them on the calling thread
+	void setJobSystem(JobSystem* jobSystem);
+
+	//Gravity, drag, wind and bounds the particles move under, by default they fly straight at the glass
+	void setIntegratorSettings(const IntegratorSettings& integratorSettings) { m_IntegratorSettings = integratorSettings; }
+	const IntegratorSettings& getIntegratorSettings() const { return m_IntegratorSettings; }
+
+	//Seconds of simulation time a particle stays visible after hitting the glass
+	void setDeletionDelay(float deletionDelay) { m_DeletionDelay = deletionDelay; }
+
+	//On by default, sweeps each particle along its whole step so fast particles cannot pass through thin colliders
+	//Off only checks where the particle ends up, which misses the glass once a step moves further than it is thick
+	void setContinuousCollision(bool continuousCollision) { m_ContinuousCollision = continuousCollision; }
+	bool getContinuousCollision() const { return m_ContinuousCollision; }
+
+	//Every slot in the store, including deleted particles waiting for an emitter to reuse their slot
+	unsigned int getParticleCount() const { return static_cast<unsigned int>(m_Particles.size()); }
+	//Particles that have not been deleted
+	unsigned int getLiveParticleCount() const { return static_cast<unsigned int>(m_Particles.size() - m_FreeSlots.size()); }
+	const ParticleStore& getParticles() const { return m_Particles; }
+	//Where particle i is drawn, interpolation blends from its position before the last step (0) to its current one (1)
+	glm::vec3 getParticlePosition(unsigned int i, float interpolation = 1.0f) const;
+	//Builds the model matrix the renderer needs from the particles position and scale
+	glm::mat4 getParticleModel(unsigned int i, float interpolation = 1.0f) const;
+	//Copies the positions and scales of every particle still drawn, plus the collision and deletion counts, into snapshot
+	//Reuses the snapshots arrays so it stops allocating once they are big enough
+	void captureSnapshot(ParticleSnapshot& snapshot) const;
+	const glm::mat4& getGlassModel() const { return m_GlassModel; }
+	bool hasCollided(unsigned int i) const { return m_Particles.state[i] != PARTICLE_MOVING; }
+	bool isDeleted(unsigned int i) const { return m_Particles.state[i] == PARTICLE_DELETED; }
+
+	//Particles that hit the glass during the last call to step
+	const std::vector<unsigned int>& getNewCollisions() const { return m_NewCollisions; }
+	//Particles whose deletion delay ran out during the last call to step
+	const std::vector<uint32_t>& getNewDeletions() const { return m_NewDeletions; }
+	unsigned int getCollisionCount() const { return m_CollisionCount; }
+	unsigned int getDeletionCount() const { return m_DeletionCount; }
+	size_t getPendingDeletionCount() const { return m_DeletionTimers.getPendingCount(); }
+
+private:
+	//Sets up particle i as a new moving particle, does not touch its bounds
+	void initialiseParticle(size_t i, glm::vec3 position, glm::vec3 velocity);
+	//Runs every emitter over deltaTime and puts the particles they spawn into free slots, growing the store once those run out
+	void emitParticles(float deltaTime);
+	void calculateParticleBounds(unsigned int i);
+	void calculateParticleBounds(size_t begin, size_t end);
+	//Runs body over [0, count) in parallel if there is a job system, otherwise on this thread
+	//No range body is given crosses a particle chunk boundary
+	void forEachRange(size_t count, const JobSystem::RangeFunction& body);
+	//Same over [first, last), body is given particle indices
+	void forEachRange(size_t first, size_t last, const JobSystem::RangeFunction& body);
+	//Checks the moving particles against every collider, through the grid once there are enough colliders for it to pay off
+	void findCollisions(float deltaTime);
+	//Finds when during the last step particle i first touched collider, false if it never did
+	bool findTimeOfImpact(unsigned int i, const AABB& collider, float& timeOfImpact) const;
+	//Stops particle i where it touched a collider, timeOfImpact is the fraction of the step it got through first
+	void collide(unsigned int i, float timeOfImpact, float deltaTime);
+
+	AABB m_ParticleLocalBounds;
+
+	glm::mat4 m_GlassModel;
+	std::vector<AABB> m_Colliders;
+
+	UniformGrid m_Grid;
+	std::vector<CollisionPair> m_CandidatePairs;
+
+	JobSystem* m_JobSystem;
+	//Each thread writes the particles it finds colliding into its own list, merged in particle order afterwards
+	std::vector<std::vector<ParticleHit>> m_ThreadCollisions;
+	std::vector<ParticleHit> m_MergedCollisions;
+	//Hit bits from the SIMD overlap kernel, one buffer per thread
+	std::vector<std::vector<uint32_t>> m_ThreadHitMasks;
+
+	ParticleStore m_Particles;
+	IntegratorSettings m_IntegratorSettings;
+	bool m_ContinuousCollision;
+
+	std::vector<unsigned int> m_NewCollisions;
+	unsigned int m_CollisionCount;
+
+	//Counts down each collided particle in simulation time, replaces the old thread per collision
+	TimerWheel m_DeletionTimers;
+	float m_DeletionDelay;
+	std::vector<uint32_t> m_NewDeletions;
+	unsigned int m_DeletionCount;
+
+	std::vector<ParticleEmitter> m_Emitters;
+	//Positions then velocities of the particles an emitter is spawning this step, one block of floats per axis
+	std::vector<float> m_EmitScratch;
+	//Slots of deleted particles, emitters fill these before growing the store so it only gets as big as the most particles alive at once
+	std::vector<uint32_t> m_FreeSlots;
+
+	float m_CompactionThreshold;
+	std::vector<uint32_t> m_CompactionRemap;
+	unsigned int m_CompactionCount;
+
+	uint64_t m_Seed;
+	//Every spawn and emission gets its own batch of random streams, counted from the last call to spawn
+	uint64_t m_SpawnBatchCount;
+};
+
+//Uniform scale applied to the particle mesh when it is spawned
+const float particleScale = 0.0001f;
+//Particles per range handed to a job system thread
+const size_t particleGrainSize = 4096;
+static_assert(particleChunkSize % particleGrainSize == 0, "Job ranges must not straddle two particle chunks");
+//Up to this many colliders every moving particle is tested against each one directly, above it the grid is used
+const size_t bruteForceColliderLimit = 32;
+//Seed used until setSeed is called, so runs are repeatable unless asked otherwise
+const uint64_t defaultRandomSeed = 1;
+//Default fraction of the store that has to be deleted particles before step compacts it
+const float defaultCompactionThreshold = 0.25f;
+//Default seconds a particle stays visible after it hits the glass
+const float defaultDeletionDelay = 2.0f;
+//Speed particles travel in their own local space, 20 units per frame at 60 frames per second
+const glm::vec3 particleLocalVelocity = glm::vec3(0.0f, 0.0f, 1200.0f);
+
+//Emitter that spawns particles in the same box in front of the glass, moving at the same speed, as spawn does
+ParticleEmitter CreateSpawnEmitter(float rate);
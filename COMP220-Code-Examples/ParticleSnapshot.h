@@ -0,0 +1,19 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+//Copy of everything the renderer needs from one simulation step, so it can draw while the next step runs
+struct ParticleSnapshot
+{
+	//x, y, z and scale of every particle that has not been deleted, before and after the step
+	std::vector<float> previousInstances;
+	std::vector<float> instances;
+
+	unsigned long long stepCount = 0;
+	double simulatedSeconds = 0.0;
+	unsigned int collisionCount = 0;
+	unsigned int deletionCount = 0;
+	//When the step finished, the renderer uses it to work out how far to interpolate
+	std::chrono::steady_clock::time_point publishTime;
+};
@@ -0,0 +1,88 @@
+#include "ParticleStore.h"
+
+//Moves each kept element of array from i down to remap[i], which is never above i so nothing is overwritten before it is read
+template<typename T>
+static void CompactArray(ChunkedArray<T>& array, const std::vector<uint32_t>& remap, size_t first)
+{
+	for (size_t i = first; i < remap.size(); i++)
+	{
+		if (remap[i] != removedParticle) array[remap[i]] = array[i];
+	}
+}
+
+ParticleStore::ParticleStore()
+	: m_Count(0)
+{
+}
+
+void ParticleStore::resize(size_t count)
+{
+	positionX.resize(count, 0.0f);
+	positionY.resize(count, 0.0f);
+	positionZ.resize(count, 0.0f);
+
+	previousPositionX.resize(count, 0.0f);
+	previousPositionY.resize(count, 0.0f);
+	previousPositionZ.resize(count, 0.0f);
+
+	velocityX.resize(count, 0.0f);
+	velocityY.resize(count, 0.0f);
+	velocityZ.resize(count, 0.0f);
+
+	scale.resize(count, 0.0f);
+
+	minimumX.resize(count, 0.0f);
+	minimumY.resize(count, 0.0f);
+	minimumZ.resize(count, 0.0f);
+	maximumX.resize(count, 0.0f);
+	maximumY.resize(count, 0.0f);
+	maximumZ.resize(count, 0.0f);
+
+	state.resize(count, PARTICLE_MOVING);
+
+	m_Count = count;
+}
+
+size_t ParticleStore::compact(std::vector<uint32_t>& remap)
+{
+	remap.resize(m_Count);
+
+	//Everything before the first deleted particle stays where it is, so those are never copied
+	size_t first = 0;
+	while (first < m_Count && state[first] != PARTICLE_DELETED)
+	{
+		remap[first] = static_cast<uint32_t>(first);
+		first++;
+	}
+
+	size_t liveCount = first;
+	for (size_t i = first; i < m_Count; i++)
+	{
+		remap[i] = state[i] == PARTICLE_DELETED ? removedParticle : static_cast<uint32_t>(liveCount++);
+	}
+	if (liveCount == m_Count) return 0;
+
+	//One field at a time, so each pass only streams through one array
+	CompactArray(positionX, remap, first);
+	CompactArray(positionY, remap, first);
+	CompactArray(positionZ, remap, first);
+	CompactArray(previousPositionX, remap, first);
+	CompactArray(previousPositionY, remap, first);
+	CompactArray(previousPositionZ, remap, first);
+	CompactArray(velocityX, remap, first);
+	CompactArray(velocityY, remap, first);
+	CompactArray(velocityZ, remap, first);
+	CompactArray(scale, remap, first);
+	CompactArray(minimumX, remap, first);
+	CompactArray(minimumY, remap, first);
+	CompactArray(minimumZ, remap, first);
+	CompactArray(maximumX, remap, first);
+	CompactArray(maximumY, remap, first);
+	CompactArray(maximumZ, remap, first);
+	CompactArray(state, remap, first);
+
+	//Frees any chunks left empty at the end
+	size_t removedCount = m_Count - liveCount;
+	resize(liveCount);
+	return removedCount;
+}
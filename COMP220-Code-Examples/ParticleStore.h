@@ -0,0 +1,161 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "MemoryStats.h"
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+//Alignment of every particle array, one cache line so SIMD loads never straddle two lines
+const size_t particleArrayAlignment = 64;
+
+//Allocator that lines the start of a std::vector up with particleArrayAlignment
+template<typename T>
+class AlignedAllocator
+{
+public:
+	typedef T value_type;
+
+	AlignedAllocator() {}
+	template<typename U> AlignedAllocator(const AlignedAllocator<U>&) {}
+
+	T* allocate(size_t count)
+	{
+		void* memory = nullptr;
+#ifdef _WIN32
+		memory = _aligned_malloc(count * sizeof(T), particleArrayAlignment);
+#else
+		if (posix_memalign(&memory, particleArrayAlignment, count * sizeof(T)) != 0) memory = nullptr;
+#endif
+		if (!memory) throw std::bad_alloc();
+		RecordAllocation(count * sizeof(T));
+		return static_cast<T*>(memory);
+	}
+
+	void deallocate(T* memory, size_t count)
+	{
+		RecordDeallocation(count * sizeof(T));
+#ifdef _WIN32
+		_aligned_free(memory);
+#else
+		free(memory);
+#endif
+	}
+
+	template<typename U> bool operator==(const AlignedAllocator<U>&) const { return true; }
+	template<typename U> bool operator!=(const AlignedAllocator<U>&) const { return false; }
+};
+
+template<typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+//Particles per chunk of every particle array, a power of two so finding a particles chunk is a shift
+const size_t particleChunkBits = 16;
+const size_t particleChunkSize = size_t(1) << particleChunkBits;
+
+//Array split into separately allocated chunks of particleChunkSize elements
+//Growing it only allocates the new chunks, so the particles already in it are never copied and never move in memory
+//Elements are contiguous within a chunk, so a loop can use pointers as long as its range does not cross a multiple of particleChunkSize
+template<typename T>
+class ChunkedArray
+{
+public:
+	ChunkedArray() : m_Size(0) {}
+	~ChunkedArray() { releaseChunks(0); }
+
+	//Each chunk is owned by exactly one array
+	ChunkedArray(const ChunkedArray&) = delete;
+	ChunkedArray& operator=(const ChunkedArray&) = delete;
+
+	T& operator[](size_t i) { return m_Chunks[i >> particleChunkBits][i & (particleChunkSize - 1)]; }
+	const T& operator[](size_t i) const { return m_Chunks[i >> particleChunkBits][i & (particleChunkSize - 1)]; }
+
+	//Allocates or frees whole chunks to fit count elements, elements past the old size are set to value
+	void resize(size_t count, T value = T())
+	{
+		size_t chunksNeeded = (count + particleChunkSize - 1) >> particleChunkBits;
+		while (m_Chunks.size() < chunksNeeded)
+		{
+			m_Chunks.push_back(AlignedAllocator<T>().allocate(particleChunkSize));
+		}
+		releaseChunks(chunksNeeded);
+
+		//A chunk at a time so it is a plain fill rather than a chunk lookup per element
+		for (size_t i = m_Size; i < count;)
+		{
+			size_t chunkEnd = std::min(count, ((i >> particleChunkBits) + 1) << particleChunkBits);
+			std::fill(&(*this)[i], &(*this)[chunkEnd - 1] + 1, value);
+			i = chunkEnd;
+		}
+		m_Size = count;
+	}
+
+	size_t size() const { return m_Size; }
+	size_t getChunkCount() const { return m_Chunks.size(); }
+
+private:
+	//Frees every chunk from firstChunk onwards
+	void releaseChunks(size_t firstChunk)
+	{
+		while (m_Chunks.size() > firstChunk)
+		{
+			AlignedAllocator<T>().deallocate(m_Chunks.back(), particleChunkSize);
+			m_Chunks.pop_back();
+		}
+	}
+
+	//Only the chunk pointers live in a std::vector, a few KB even for tens of millions of particles
+	std::vector<T*> m_Chunks;
+	size_t m_Size;
+};
+
+//What a particle is currently doing, only ever moves forwards through the list
+enum ParticleState : uint8_t
+{
+	PARTICLE_MOVING = 0,	//Still travelling towards the glass
+	PARTICLE_COLLIDED = 1,	//Hit the glass and stopped, still drawn
+	PARTICLE_DELETED = 2	//Finished its deletion delay, no longer drawn
+};
+
+//Marks a particle that was deleted in the remap table ParticleStore::compact fills in
+const uint32_t removedParticle = 0xFFFFFFFFu;
+
+//Structure of arrays holding every particle, each field is its own chunked array so a loop only pulls in the fields it uses
+//Heap allocated a chunk at a time, so it can grow to tens of millions of particles without one huge reallocation
+class ParticleStore
+{
+public:
+	ParticleStore();
+
+	//Grows or shrinks every array to count particles, new particles are zeroed, existing particles stay where they are
+	void resize(size_t count);
+	size_t size() const { return m_Count; }
+	//Removes every deleted particle and slides the rest down over the gaps, keeping them in the same order
+	//remap[old index] is the particles new index, or removedParticle if it was deleted, returns how many were removed
+	size_t compact(std::vector<uint32_t>& remap);
+
+	//World space position
+	ChunkedArray<float> positionX, positionY, positionZ;
+	//Position at the start of the last step, the swept collision test runs from here to position
+	ChunkedArray<float> previousPositionX, previousPositionY, previousPositionZ;
+	//World space velocity in units per second
+	ChunkedArray<float> velocityX, velocityY, velocityZ;
+	//Uniform scale applied to the particle mesh
+	ChunkedArray<float> scale;
+	//World space bounds, kept up to date by the simulation every step
+	//While a particle is moving they cover everywhere it went during the last step, not just where it ended up
+	ChunkedArray<float> minimumX, minimumY, minimumZ;
+	ChunkedArray<float> maximumX, maximumY, maximumZ;
+	//ParticleState of each particle
+	ChunkedArray<uint8_t> state;
+
+private:
+	size_t m_Count;
+};
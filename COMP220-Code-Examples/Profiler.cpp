@@ -0,0 +1,126 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+
+static uint64_t SteadyNanoseconds()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+Profiler& GetProfiler()
+{
+	static Profiler profiler;
+	return profiler;
+}
+
+Profiler::Profiler()
+	: m_Enabled(false), m_StartTime(SteadyNanoseconds())
+{
+}
+
+uint64_t Profiler::now() const
+{
+	return SteadyNanoseconds() - m_StartTime;
+}
+
+Profiler::ThreadEvents& Profiler::getThreadEvents()
+{
+	//Looked up once per thread, after that every record goes straight to the cached list
+	thread_local ThreadEvents* threadEvents = nullptr;
+	if (threadEvents) return *threadEvents;
+
+	std::lock_guard<std::mutex> lock(m_ThreadsMutex);
+	m_Threads.push_back(std::unique_ptr<ThreadEvents>(new ThreadEvents()));
+	threadEvents = m_Threads.back().get();
+	threadEvents->threadIndex = static_cast<unsigned int>(m_Threads.size());
+	threadEvents->droppedCount = 0;
+	threadEvents->events.reserve(4096);
+	return *threadEvents;
+}
+
+void Profiler::record(const char* zoneName, uint64_t startNanoseconds, uint64_t endNanoseconds)
+{
+	ThreadEvents& threadEvents = getThreadEvents();
+	if (threadEvents.events.size() >= maxZoneEventsPerThread)
+	{
+		threadEvents.droppedCount++;
+		return;
+	}
+	ZoneEvent zoneEvent = { zoneName, startNanoseconds, endNanoseconds - startNanoseconds };
+	threadEvents.events.push_back(zoneEvent);
+}
+
+void Profiler::setThreadName(const std::string& threadName)
+{
+	getThreadEvents().threadName = threadName;
+}
+
+bool Profiler::writeChromeTrace(const std::string& filePath) const
+{
+	FILE* file = fopen(filePath.c_str(), "w");
+	if (!file) return false;
+
+	std::lock_guard<std::mutex> lock(m_ThreadsMutex);
+	fprintf(file, "{\"traceEvents\":[\n");
+	bool first = true;
+	for (size_t t = 0; t < m_Threads.size(); t++)
+	{
+		const ThreadEvents& threadEvents = *m_Threads[t];
+		if (!threadEvents.threadName.empty())
+		{
+			fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}", first ? "" : ",\n", threadEvents.threadIndex, threadEvents.threadName.c_str());
+			first = false;
+		}
+
+		//Complete events, timestamps and durations are in microseconds
+		for (size_t e = 0; e < threadEvents.events.size(); e++)
+		{
+			const ZoneEvent& zoneEvent = threadEvents.events[e];
+			fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", first ? "" : ",\n",
+				zoneEvent.zoneName, threadEvents.threadIndex, zoneEvent.start / 1000.0, zoneEvent.duration / 1000.0);
+			first = false;
+		}
+	}
+	fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	fclose(file);
+	return true;
+}
+
+void Profiler::printSummary(FILE* output) const
+{
+	//Groups by the zone text rather than the pointer, the same literal can end up at different addresses in different files
+	std::map<std::string, std::vector<uint64_t>> zoneDurations;
+	uint64_t droppedCount = 0;
+	{
+		std::lock_guard<std::mutex> lock(m_ThreadsMutex);
+		for (size_t t = 0; t < m_Threads.size(); t++)
+		{
+			for (size_t e = 0; e < m_Threads[t]->events.size(); e++)
+			{
+				zoneDurations[m_Threads[t]->events[e].zoneName].push_back(m_Threads[t]->events[e].duration);
+			}
+			droppedCount += m_Threads[t]->droppedCount;
+		}
+	}
+
+	fprintf(output, "%-14s %10s %12s %10s %10s %10s %10s %10s\n", "zone", "count", "total ms", "mean ms", "p50 ms", "p90 ms", "p99 ms", "max ms");
+	for (auto zone = zoneDurations.begin(); zone != zoneDurations.end(); ++zone)
+	{
+		std::vector<uint64_t>& durations = zone->second;
+		std::sort(durations.begin(), durations.end());
+
+		double total = 0.0;
+		for (size_t d = 0; d < durations.size(); d++)
+		{
+			total += durations[d];
+		}
+		//Nearest rank percentile
+		auto percentile = [&](double fraction) { return durations[std::min(durations.size() - 1, static_cast<size_t>(fraction * durations.size()))] / 1000000.0; };
+
+		fprintf(output, "%-14s %10zu %12.2f %10.4f %10.4f %10.4f %10.4f %10.4f\n", zone->first.c_str(), durations.size(), total / 1000000.0,
+			total / durations.size() / 1000000.0, percentile(0.5), percentile(0.9), percentile(0.99), durations.back() / 1000000.0);
+	}
+	if (droppedCount > 0) fprintf(output, "%llu zones were not kept, past %zu per thread\n", static_cast<unsigned long long>(droppedCount), maxZoneEventsPerThread);
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//Records how long named zones of code take on every thread, for a Chrome trace and a per zone summary
+//Compiled in all the time, while it is disabled a zone costs one check of a flag
+class Profiler
+{
+public:
+	Profiler();
+
+	void setEnabled(bool enabled) { m_Enabled = enabled; }
+	bool isEnabled() const { return m_Enabled; }
+
+	//Nanoseconds since the profiler was created
+	uint64_t now() const;
+	//Adds a finished zone for the calling thread, zoneName must outlive the profiler, so use string literals
+	void record(const char* zoneName, uint64_t startNanoseconds, uint64_t endNanoseconds);
+	//Names the calling thread in the trace
+	void setThreadName(const std::string& threadName);
+
+	//Writes every recorded zone as Chrome trace event JSON, load it in chrome://tracing or ui.perfetto.dev
+	//Only call once the threads being profiled have stopped recording
+	bool writeChromeTrace(const std::string& filePath) const;
+	//Prints the count, mean and 50th, 90th and 99th percentile time of each zone
+	void printSummary(FILE* output) const;
+
+private:
+	struct ZoneEvent
+	{
+		const char* zoneName;
+		uint64_t start;
+		uint64_t duration;
+	};
+
+	//Each thread only ever appends to its own list, so recording never takes a lock
+	struct ThreadEvents
+	{
+		unsigned int threadIndex;
+		std::string threadName;
+		std::vector<ZoneEvent> events;
+		uint64_t droppedCount;
+	};
+
+	ThreadEvents& getThreadEvents();
+
+	bool m_Enabled;
+	uint64_t m_StartTime;
+
+	//Only locked the first time each thread records something
+	mutable std::mutex m_ThreadsMutex;
+	std::vector<std::unique_ptr<ThreadEvents>> m_Threads;
+};
+
+//Most zones each thread keeps for the trace, about 24 MB, zones past this are counted but not kept
+const size_t maxZoneEventsPerThread = 1 << 20;
+
+//The profiler every PROFILE_ZONE records into
+Profiler& GetProfiler();
+
+//Times from its construction to the end of its scope and records it as zoneName
+class ProfileZone
+{
+public:
+	explicit ProfileZone(const char* zoneName)
+		: m_ZoneName(zoneName), m_Start(0)
+	{
+		if (GetProfiler().isEnabled()) m_Start = GetProfiler().now() + 1;
+	}
+
+	~ProfileZone()
+	{
+		end();
+	}
+
+	//Ends the zone early, for long stretches of code that are not their own scope
+	void end()
+	{
+		//m_Start is offset by one so 0 can mean the profiler was off when the zone started, or it has already ended
+		if (m_Start != 0) GetProfiler().record(m_ZoneName, m_Start - 1, GetProfiler().now());
+		m_Start = 0;
+	}
+
+private:
+	const char* m_ZoneName;
+	uint64_t m_Start;
+};
+
+#define PROFILE_ZONE_JOIN(a, b) a##b
+#define PROFILE_ZONE_NAME(line) PROFILE_ZONE_JOIN(profileZone, line)
+//Times the rest of the enclosing scope, e.g. PROFILE_ZONE("Collision");
+#define PROFILE_ZONE(zoneName) ProfileZone PROFILE_ZONE_NAME(__LINE__)(zoneName)
@@ -0,0 +1,151 @@
+#include "Random.h"
+
+#include "SimdPlatform.h"
+
+//Turns the top 24 bits of a number into a float in [0, 1)
+const float randomFloatScale = 1.0f / 16777216.0f;
+
+//SplitMix64 finaliser, only used to spread the seed and stream id over the whole key
+static uint64_t MixKey(uint64_t x)
+{
+	x += 0x9E3779B97F4A7C15ull;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+	return x ^ (x >> 31);
+}
+
+//Chris Wellons' lowbias32 integer hash, only 32 bit multiplies and fixed shifts so it maps straight onto SIMD
+static uint32_t Hash32(uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x7FEB352Du;
+	x ^= x >> 15;
+	x *= 0x846CA68Bu;
+	x ^= x >> 16;
+	return x;
+}
+
+uint64_t MakeRandomKey(uint64_t seed, uint64_t streamId)
+{
+	return MixKey(seed ^ MixKey(streamId));
+}
+
+uint32_t RandomUint32(uint64_t key, uint32_t counter)
+{
+	//Two rounds with a different half of the key going in before each, so streams are not just shifted copies of each other
+	uint32_t keyLow = static_cast<uint32_t>(key);
+	uint32_t keyHigh = static_cast<uint32_t>(key >> 32);
+	return Hash32(Hash32(counter ^ keyLow) + keyHigh);
+}
+
+float RandomFloat(uint64_t key, uint32_t counter)
+{
+	return static_cast<float>(RandomUint32(key, counter) >> 8) * randomFloatScale;
+}
+
+float RandomRange(uint64_t key, uint32_t counter, float minimum, float maximum)
+{
+	//Scales by the range before the bits are multiplied in, the same order the SIMD loops use so they round the same way
+	return minimum + static_cast<float>(RandomUint32(key, counter) >> 8) * ((maximum - minimum) * randomFloatScale);
+}
+
+static void FillScalar(uint64_t key, uint32_t firstCounter, float minimum, float maximum, float* values, size_t first, size_t last)
+{
+	for (size_t i = first; i < last; i++)
+	{
+		values[i] = RandomRange(key, firstCounter + static_cast<uint32_t>(i), minimum, maximum);
+	}
+}
+
+#if defined(SIMD_HAS_SSE)
+//SSE2 has no 32 bit multiply that keeps the low halves, so the odd and even lanes are multiplied as 64 bit and put back together
+static inline __m128i MultiplyLowSse(__m128i a, __m128i b)
+{
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+static inline __m128i Hash32Sse(__m128i x)
+{
+	x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+	x = MultiplyLowSse(x, _mm_set1_epi32(0x7FEB352D));
+	x = _mm_xor_si128(x, _mm_srli_epi32(x, 15));
+	x = MultiplyLowSse(x, _mm_set1_epi32(static_cast<int>(0x846CA68Bu)));
+	x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+	return x;
+}
+
+//Returns how many values it filled, the rest are left for the scalar loop
+static size_t FillSse(uint64_t key, uint32_t firstCounter, float minimum, float maximum, float* values, size_t count)
+{
+	const __m128i keyLow = _mm_set1_epi32(static_cast<int>(static_cast<uint32_t>(key)));
+	const __m128i keyHigh = _mm_set1_epi32(static_cast<int>(static_cast<uint32_t>(key >> 32)));
+	const __m128 scale = _mm_set1_ps((maximum - minimum) * randomFloatScale);
+	const __m128 offset = _mm_set1_ps(minimum);
+	__m128i counter = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(firstCounter)), _mm_setr_epi32(0, 1, 2, 3));
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i bits = Hash32Sse(_mm_add_epi32(Hash32Sse(_mm_xor_si128(counter, keyLow)), keyHigh));
+		//The top 24 bits fit in a signed int, so the signed conversion gives the same float as the scalar code
+		__m128 unit = _mm_cvtepi32_ps(_mm_srli_epi32(bits, 8));
+		_mm_storeu_ps(values + i, _mm_add_ps(offset, _mm_mul_ps(unit, scale)));
+		counter = _mm_add_epi32(counter, _mm_set1_epi32(4));
+	}
+	return i;
+}
+#endif
+
+#if defined(SIMD_HAS_AVX2)
+SIMD_AVX2_FUNCTION
+static inline __m256i Hash32Avx2(__m256i x)
+{
+	x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+	x = _mm256_mullo_epi32(x, _mm256_set1_epi32(0x7FEB352D));
+	x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+	x = _mm256_mullo_epi32(x, _mm256_set1_epi32(static_cast<int>(0x846CA68Bu)));
+	x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+	return x;
+}
+
+SIMD_AVX2_FUNCTION
+static size_t FillAvx2(uint64_t key, uint32_t firstCounter, float minimum, float maximum, float* values, size_t count)
+{
+	const __m256i keyLow = _mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(key)));
+	const __m256i keyHigh = _mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(key >> 32)));
+	const __m256 scale = _mm256_set1_ps((maximum - minimum) * randomFloatScale);
+	const __m256 offset = _mm256_set1_ps(minimum);
+	__m256i counter = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(firstCounter)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i bits = Hash32Avx2(_mm256_add_epi32(Hash32Avx2(_mm256_xor_si256(counter, keyLow)), keyHigh));
+		__m256 unit = _mm256_cvtepi32_ps(_mm256_srli_epi32(bits, 8));
+		_mm256_storeu_ps(values + i, _mm256_add_ps(offset, _mm256_mul_ps(unit, scale)));
+		counter = _mm256_add_epi32(counter, _mm256_set1_epi32(8));
+	}
+	return i;
+}
+#endif
+
+void FillRandomRange(uint64_t key, uint32_t firstCounter, float minimum, float maximum, float* values, size_t count)
+{
+	FillRandomRange(key, firstCounter, minimum, maximum, values, count, GetBestAabbKernel());
+}
+
+void FillRandomRange(uint64_t key, uint32_t firstCounter, float minimum, float maximum, float* values, size_t count, AabbKernelLevel level)
+{
+	if (!IsAabbKernelSupported(level)) level = GetBestAabbKernel();
+
+	size_t handled = 0;
+#if defined(SIMD_HAS_AVX2)
+	if (level == AABB_KERNEL_AVX2) handled = FillAvx2(key, firstCounter, minimum, maximum, values, count);
+#endif
+#if defined(SIMD_HAS_SSE)
+	if (level == AABB_KERNEL_SSE) handled = FillSse(key, firstCounter, minimum, maximum, values, count);
+#endif
+	FillScalar(key, firstCounter, minimum, maximum, values, handled, count);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "AabbKernel.h"
+
+//Counter based random numbers, number n of a stream is worked out straight from the streams key and n
+//Nothing is carried from one number to the next, so any thread can make any particles numbers in any order and always get the same ones
+
+//Key for one stream of numbers, every stream id under a seed gives an unrelated stream
+uint64_t MakeRandomKey(uint64_t seed, uint64_t streamId);
+
+//Number counter of the stream, the same key and counter always give the same number
+uint32_t RandomUint32(uint64_t key, uint32_t counter);
+//Same number turned into a float in [0, 1), 24 bits of it are used so every value is exactly representable
+float RandomFloat(uint64_t key, uint32_t counter);
+float RandomRange(uint64_t key, uint32_t counter, float minimum, float maximum);
+
+//Fills values[0, count) with RandomRange for counters firstCounter onwards, several at once with SSE or AVX2
+//Gives exactly the same values as calling RandomRange one at a time whichever level runs
+void FillRandomRange(uint64_t key, uint32_t firstCounter, float minimum, float maximum, float* values, size_t count);
+//Same as above but forces a level, using the same CPUID check as the AABB kernel, used to compare them
+void FillRandomRange(uint64_t key, uint32_t firstCounter, float minimum, float maximum, float* values, size_t count, AabbKernelLevel level);
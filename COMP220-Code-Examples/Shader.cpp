@@ -1,13 +1,143 @@
 #include "Shader.h"
+#include "FileHash.h"
 
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 
-GLuint LoadShaders(const char* vertex_file_path, const char* fragment_file_path)
+namespace
 {
+	//Bumped whenever the layout below changes so old caches are treated as misses
+	const uint32_t programCacheVersion = 1;
+	const char programCacheMagic[4] = { 'P', 'R', 'G', 'C' };
 
-	// Create the shaders as a GL integer
-	GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER /*creates a shader using vertex buffer this creates a set of co-ords that defines our pixels*/);
-	GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER /*creates a shader using fragment buffer this colours a cluster/fragment of pixels*/);
+	//Start of every program cache file, the binary glGetProgramBinary gave back follows it
+	struct ProgramCacheHeader
+	{
+		char magic[4];
+		uint32_t version;
+		//Hash of both sources and the driver, a binary only loads on the driver that made it
+		uint64_t sourceHash;
+		uint32_t binaryFormat;
+		uint32_t binaryLength;
+		//How long compiling and linking took when this was written
+		double compileMilliseconds;
+	};
+
+	bool shaderCacheEnabled = true;
+	ShaderCacheStats shaderCacheStats = {};
+
+	double MillisecondsSince(std::chrono::steady_clock::time_point startTime)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	}
+
+	//Needs GL 4.1 or the extension, and the driver has to offer at least one binary format
+	bool IsProgramBinarySupported()
+	{
+		if (!GLEW_VERSION_4_1 && !GLEW_ARB_get_program_binary) return false;
+		GLint numOfFormats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numOfFormats);
+		return numOfFormats > 0;
+	}
+
+	uint64_t HashProgramSources(const std::string& vertexCode, const std::string& fragmentCode)
+	{
+		uint64_t hash = HashBytes(vertexCode.data(), vertexCode.size());
+		hash = HashBytes(fragmentCode.data(), fragmentCode.size(), hash);
+		//A driver update can change the binary format without changing its number
+		const GLenum driverStrings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+		for (GLenum name : driverStrings)
+		{
+			const char* value = reinterpret_cast<const char*>(glGetString(name));
+			if (value) hash = HashBytes(value, strlen(value), hash);
+		}
+		return hash;
+	}
+
+	//Kept beside the vertex shader, named after both files since several programs share one vertex shader
+	std::string GetProgramCachePath(const char* vertexFilePath, const char* fragmentFilePath)
+	{
+		std::string fragmentName = fragmentFilePath;
+		size_t lastSlash = fragmentName.find_last_of("/\\");
+		if (lastSlash != std::string::npos) fragmentName = fragmentName.substr(lastSlash + 1);
+		return std::string(vertexFilePath) + "+" + fragmentName + ".programcache";
+	}
+
+	//Returns the linked program, or 0 if there is no matching cache or the driver will not take the binary
+	GLuint LoadCachedProgram(const std::string& cachePath, uint64_t sourceHash, double& compileMilliseconds)
+	{
+		FILE* file = fopen(cachePath.c_str(), "rb");
+		if (!file) return 0;
+
+		ProgramCacheHeader header;
+		std::vector<char> binary;
+		bool valid = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, programCacheMagic, sizeof(header.magic)) == 0
+			&& header.version == programCacheVersion && header.sourceHash == sourceHash && header.binaryLength > 0;
+		if (valid)
+		{
+			binary.resize(header.binaryLength);
+			valid = fread(binary.data(), 1, binary.size(), file) == binary.size();
+		}
+		fclose(file);
+		if (!valid) return 0;
+
+		GLuint ProgramID = glCreateProgram();
+		glProgramBinary(ProgramID, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+		GLint Result = GL_FALSE;
+		glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
+		if (Result != GL_TRUE)
+		{
+			glDeleteProgram(ProgramID);
+			return 0;
+		}
+		compileMilliseconds = header.compileMilliseconds;
+		return ProgramID;
+	}
+
+	//Failing to write only costs the next run a compile, so nothing is reported
+	void SaveProgramBinary(const std::string& cachePath, GLuint ProgramID, uint64_t sourceHash, double compileMilliseconds)
+	{
+		GLint binaryLength = 0;
+		glGetProgramiv(ProgramID, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+		if (binaryLength <= 0) return;
 
+		ProgramCacheHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, programCacheMagic, sizeof(header.magic));
+		header.version = programCacheVersion;
+		header.sourceHash = sourceHash;
+		header.compileMilliseconds = compileMilliseconds;
+
+		std::vector<char> binary(binaryLength);
+		GLenum binaryFormat = 0;
+		GLsizei writtenLength = 0;
+		glGetProgramBinary(ProgramID, binaryLength, &writtenLength, &binaryFormat, binary.data());
+		if (writtenLength <= 0) return;
+		header.binaryFormat = binaryFormat;
+		header.binaryLength = static_cast<uint32_t>(writtenLength);
+
+		FILE* file = fopen(cachePath.c_str(), "wb");
+		if (!file) return;
+		bool written = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(binary.data(), 1, writtenLength, file) == static_cast<size_t>(writtenLength);
+		fclose(file);
+		if (!written) remove(cachePath.c_str());
+	}
+}
+
+void SetShaderCacheEnabled(bool enabled)
+{
+	shaderCacheEnabled = enabled;
+}
+
+const ShaderCacheStats& GetShaderCacheStats()
+{
+	return shaderCacheStats;
+}
+
+GLuint LoadShaders(const char* vertex_file_path, const char* fragment_file_path)
+{
 	// Read the Vertex Shader code from the file
 	std::string VertexShaderCode;
 	std::ifstream VertexShaderStream(vertex_file_path, std::ios::in);
@@ -33,6 +163,30 @@ GLuint LoadShaders(const char* vertex_file_path, const char* fragment_file_path)
 		FragmentShaderStream.close();
 	}
 
+	//Tries the binary from last time before compiling anything
+	auto startTime = std::chrono::steady_clock::now();
+	bool useCache = shaderCacheEnabled && IsProgramBinarySupported();
+	uint64_t sourceHash = 0;
+	std::string cachePath;
+	if (useCache)
+	{
+		sourceHash = HashProgramSources(VertexShaderCode, FragmentShaderCode);
+		cachePath = GetProgramCachePath(vertex_file_path, fragment_file_path);
+		double cachedCompileMilliseconds = 0.0;
+		GLuint CachedProgramID = LoadCachedProgram(cachePath, sourceHash, cachedCompileMilliseconds);
+		if (CachedProgramID)
+		{
+			shaderCacheStats.hitCount++;
+			shaderCacheStats.savedMilliseconds += cachedCompileMilliseconds - MillisecondsSince(startTime);
+			printf("Loaded program %s from cache\n", cachePath.c_str());
+			return CachedProgramID;
+		}
+	}
+
+	// Create the shaders as a GL integer
+	GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER /*creates a shader using vertex buffer this creates a set of co-ords that defines our pixels*/);
+	GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER /*creates a shader using fragment buffer this colours a cluster/fragment of pixels*/);
+
 	//Setting a gl int as false represents 0
 	GLint Result = GL_FALSE;
 	int InfoLogLength;
@@ -72,6 +226,8 @@ GLuint LoadShaders(const char* vertex_file_path, const char* fragment_file_path)
 	GLuint ProgramID = glCreateProgram();
 	glAttachShader(ProgramID, VertexShaderID);
 	glAttachShader(ProgramID, FragmentShaderID);
+	//Lets the driver know the binary will be asked for, some only keep it around when told
+	if (useCache) glProgramParameteri(ProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glLinkProgram(ProgramID);
 
 	// Check the program
@@ -89,5 +245,11 @@ GLuint LoadShaders(const char* vertex_file_path, const char* fragment_file_path)
 	glDeleteShader(VertexShaderID);
 	glDeleteShader(FragmentShaderID);
 
+	double compileMilliseconds = MillisecondsSince(startTime);
+	shaderCacheStats.missCount++;
+	shaderCacheStats.compileMilliseconds += compileMilliseconds;
+	//Only programs that linked are worth keeping
+	if (useCache && Result == GL_TRUE) SaveProgramBinary(cachePath, ProgramID, sourceHash, compileMilliseconds);
+
 	return ProgramID;
-}
\ No newline at end of file
+}
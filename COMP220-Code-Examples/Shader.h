@@ -7,4 +7,21 @@
 #include <sstream>
 #include <vector>
 
-GLuint LoadShaders(const char* vertex_file_path, const char* fragment_file_path);
\ No newline at end of file
+//Totals for every LoadShaders call so far
+struct ShaderCacheStats
+{
+	unsigned int hitCount;
+	unsigned int missCount;
+	//Time spent compiling and linking programs that were not in the cache
+	double compileMilliseconds;
+	//What compiling the cached programs took when they were written, less what loading them took this time
+	double savedMilliseconds;
+};
+
+//Compiles and links the two shaders, or loads the linked program from a binary cache written the last time the same sources were compiled
+//The cache is keyed on both sources and the driver, anything different or a binary the driver turns down falls back to compiling
+GLuint LoadShaders(const char* vertex_file_path, const char* fragment_file_path);
+
+//On by default, the cache is skipped anyway if the driver cannot save program binaries
+void SetShaderCacheEnabled(bool enabled);
+const ShaderCacheStats& GetShaderCacheStats();
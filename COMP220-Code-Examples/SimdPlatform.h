@@ -0,0 +1,22 @@
+#pragma once
+
+//Which SIMD instruction sets this build can use, shared by every file with hand written SSE or AVX2 loops
+//SSE2 is always there on x86-64, AVX2 might be so code using it has to check GetBestAabbKernel first
+
+//glm already works out the compiler and the target architecture
+#include <glm/simd/platform.h>
+
+#if (GLM_ARCH & GLM_ARCH_X86_BIT) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <immintrin.h>
+#define SIMD_HAS_SSE 1
+#if (GLM_COMPILER & GLM_COMPILER_VC)
+#include <intrin.h>
+#define SIMD_HAS_AVX2 1
+#define SIMD_AVX2_FUNCTION
+#elif (GLM_COMPILER & (GLM_COMPILER_GCC | GLM_COMPILER_CLANG))
+#include <cpuid.h>
+#define SIMD_HAS_AVX2 1
+//Lets one function use AVX2 without building the whole file for it, so older CPUs can still run the rest
+#define SIMD_AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+#endif
@@ -0,0 +1,89 @@
+#include "SimulationThread.h"
+#include "FixedTimestep.h"
+#include "Profiler.h"
+
+#include <chrono>
+
+SimulationThread::SimulationThread(ParticleSimulation& simulation, double stepSeconds, unsigned int maxStepsPerFrame)
+	: m_Simulation(simulation), m_StepSeconds(stepSeconds), m_MaxStepsPerFrame(maxStepsPerFrame), m_RealTime(true), m_Running(false), m_StepCount(0), m_SkippedCount(0), m_BusyMicroseconds(0)
+{
+}
+
+SimulationThread::~SimulationThread()
+{
+	stop();
+}
+
+void SimulationThread::start()
+{
+	if (m_Running) return;
+
+	//Publishes the starting positions so the renderer has something to draw before the first step
+	ParticleSnapshot& snapshot = m_Snapshots.getWriteBuffer();
+	m_Simulation.captureSnapshot(snapshot);
+	snapshot.stepCount = 0;
+	snapshot.simulatedSeconds = 0.0;
+	snapshot.publishTime = std::chrono::steady_clock::now();
+	m_Snapshots.publish();
+
+	m_Running = true;
+	m_Thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop()
+{
+	m_Running = false;
+	if (m_Thread.joinable()) m_Thread.join();
+}
+
+void SimulationThread::run()
+{
+	GetProfiler().setThreadName("Simulation");
+	FixedTimestep timestep(m_StepSeconds, m_MaxStepsPerFrame);
+	auto lastTime = std::chrono::steady_clock::now();
+
+	while (m_Running)
+	{
+		if (!m_RealTime)
+		{
+			stepAndPublish();
+			continue;
+		}
+
+		//The same accumulator the serial loop uses, just fed from this threads own clock
+		auto now = std::chrono::steady_clock::now();
+		unsigned int numOfSteps = timestep.advance(std::chrono::duration<double>(now - lastTime).count());
+		lastTime = now;
+		for (unsigned int step = 0; step < numOfSteps; step++)
+		{
+			stepAndPublish();
+		}
+
+		//Sleeps until the next step is due instead of spinning a core
+		if (numOfSteps == 0)
+		{
+			double secondsUntilStep = (1.0 - timestep.getInterpolation()) * m_StepSeconds;
+			std::this_thread::sleep_for(std::chrono::duration<double>(secondsUntilStep));
+		}
+	}
+}
+
+void SimulationThread::stepAndPublish()
+{
+	auto startTime = std::chrono::steady_clock::now();
+
+	m_Simulation.step(static_cast<float>(m_StepSeconds));
+	unsigned long long stepCount = m_StepCount.load(std::memory_order_relaxed) + 1;
+
+	ParticleSnapshot& snapshot = m_Snapshots.getWriteBuffer();
+	ProfileZone snapshotZone("Snapshot");
+	m_Simulation.captureSnapshot(snapshot);
+	snapshotZone.end();
+	snapshot.stepCount = stepCount;
+	snapshot.simulatedSeconds = stepCount * m_StepSeconds;
+	snapshot.publishTime = std::chrono::steady_clock::now();
+	if (m_Snapshots.publish()) m_SkippedCount.fetch_add(1, std::memory_order_relaxed);
+
+	m_StepCount.store(stepCount, std::memory_order_relaxed);
+	m_BusyMicroseconds.fetch_add(std::chrono::duration_cast<std::chrono::microseconds>(snapshot.publishTime - startTime).count(), std::memory_order_relaxed);
+}
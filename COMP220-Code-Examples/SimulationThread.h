@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+#include "ParticleSimulation.h"
+#include "ParticleSnapshot.h"
+#include "TripleBuffer.h"
+
+//Steps a ParticleSimulation on its own thread and publishes a snapshot after every step through a triple buffer
+//The render thread picks up the newest snapshot whenever it starts a frame, so neither side ever waits for the other
+//Nothing else may touch the simulation between start and stop
+class SimulationThread
+{
+public:
+	//maxStepsPerFrame caps how many steps one wake up can catch up on, the same as FixedTimestep
+	SimulationThread(ParticleSimulation& simulation, double stepSeconds = 1.0 / 60.0, unsigned int maxStepsPerFrame = 8);
+	~SimulationThread();
+
+	//On by default, paces the steps to real time, off runs them back to back to measure throughput
+	void setRealTime(bool realTime) { m_RealTime = realTime; }
+
+	void start();
+	//Finishes the step in progress and joins the thread, the simulation can be used directly again afterwards
+	void stop();
+
+	//Render side, swaps in the newest snapshot if one has been published since the last call
+	bool acquireLatest() { return m_Snapshots.acquire(); }
+	const ParticleSnapshot& getLatest() const { return m_Snapshots.getReadBuffer(); }
+
+	float getStepSeconds() const { return static_cast<float>(m_StepSeconds); }
+	unsigned long long getStepCount() const { return m_StepCount.load(std::memory_order_relaxed); }
+	//Snapshots replaced before the render thread ever saw them
+	unsigned long long getSkippedCount() const { return m_SkippedCount.load(std::memory_order_relaxed); }
+	//Seconds the thread spent stepping and publishing, the rest of the time it was asleep waiting for the next step
+	double getBusySeconds() const { return m_BusyMicroseconds.load(std::memory_order_relaxed) / 1000000.0; }
+
+private:
+	void run();
+	//Runs one step and publishes what it did
+	void stepAndPublish();
+
+	ParticleSimulation& m_Simulation;
+	double m_StepSeconds;
+	unsigned int m_MaxStepsPerFrame;
+	bool m_RealTime;
+
+	std::thread m_Thread;
+	std::atomic<bool> m_Running;
+	TripleBuffer<ParticleSnapshot> m_Snapshots;
+
+	std::atomic<unsigned long long> m_StepCount;
+	std::atomic<unsigned long long> m_SkippedCount;
+	std::atomic<unsigned long long> m_BusyMicroseconds;
+};
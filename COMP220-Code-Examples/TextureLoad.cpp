@@ -0,0 +1,52 @@
+#include "TextureLoad.h"
+
+namespace
+{
+	//NOTE: FOLLOWING CODE BLOCK DERIVED FROM: http://www.opengl-tutorial.org/beginners-tutorials/tutorial-5-a-textured-cube/#using-the-texture-in-opengl
+	void UploadTexture(TextureData& texture)
+	{
+		glGenTextures(1, &texture.textureID);
+
+		// "Bind" the newly created texture : all future texture functions will modify this texture
+		glBindTexture(GL_TEXTURE_2D, texture.textureID);
+
+		int Mode = GL_RGB;
+
+		if (texture.image->format->BytesPerPixel == 4) {
+			Mode = GL_RGBA;
+		}
+		glTexImage2D(GL_TEXTURE_2D, 0, Mode, texture.image->w, texture.image->h, 0, Mode, GL_UNSIGNED_BYTE, texture.image->pixels);
+
+		// Nice trilinear filtering.
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT); //repeats if we go beyond TEXTURE UV maxima
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+		//The GL copy is all that is drawn from, so the decoded pixels can go straight away
+		SDL_FreeSurface(texture.image);
+		texture.image = nullptr;
+	}
+}
+
+AssetHandle LoadTextureAsync(AssetQueue& assets, TextureData& texture)
+{
+	texture.image = nullptr;
+	texture.textureID = 0;
+	return assets.request(texture.filePath,
+		[&texture](std::string& error) {
+			texture.image = IMG_Load(texture.filePath.c_str());
+			if (!texture.image) error = IMG_GetError();
+			return texture.image != nullptr;
+		},
+		[&texture] { UploadTexture(texture); });
+}
+
+void DestroyTexture(TextureData& texture)
+{
+	if (texture.textureID) glDeleteTextures(1, &texture.textureID);
+	if (texture.image) SDL_FreeSurface(texture.image);
+	texture.textureID = 0;
+	texture.image = nullptr;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <gl\glew.h>
+#include <SDL_opengl.h>
+#include <SDL_image.h>
+#include <string>
+
+#include "AssetQueue.h"
+
+//A texture loaded through an AssetQueue, textureID stays 0 until the upload has run
+struct TextureData
+{
+	std::string filePath;
+	//Decoded pixels, only held between the worker decoding them and the upload
+	SDL_Surface* image;
+	GLuint textureID;
+};
+
+//Decodes texture.filePath with IMG_Load on a worker thread, then creates the mipmapped GL texture on the render thread
+//texture has to stay where it is until the asset is ready or has failed
+AssetHandle LoadTextureAsync(AssetQueue& assets, TextureData& texture);
+
+void DestroyTexture(TextureData& texture);
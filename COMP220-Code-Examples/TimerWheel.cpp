@@ -0,0 +1,135 @@
+#include "TimerWheel.h"
+
+#include <cmath>
+
+TimerWheel::TimerWheel(double tickSeconds)
+	: m_TickSeconds(tickSeconds), m_Time(0.0), m_CurrentTick(0), m_PendingCount(0)
+{
+}
+
+void TimerWheel::schedule(uint32_t id, double delaySeconds)
+{
+	//Rounds up so a timer never fires early, and always waits at least one tick
+	uint64_t delayTicks = static_cast<uint64_t>(std::ceil(delaySeconds / m_TickSeconds));
+	if (delayTicks == 0) delayTicks = 1;
+
+	TimerEntry entry = { id, m_CurrentTick + delayTicks };
+	insert(entry);
+	m_PendingCount++;
+}
+
+void TimerWheel::advance(double deltaTime, std::vector<uint32_t>& expired)
+{
+	m_Time += deltaTime;
+	uint64_t targetTick = static_cast<uint64_t>(m_Time / m_TickSeconds);
+
+	//Nothing can fire, so time can jump straight to the target
+	if (m_PendingCount == 0)
+	{
+		m_CurrentTick = targetTick;
+		return;
+	}
+
+	while (m_CurrentTick < targetTick)
+	{
+		tick(expired);
+	}
+}
+
+void TimerWheel::clear()
+{
+	for (int level = 0; level < levelCount; level++)
+	{
+		for (int slot = 0; slot < slotsPerLevel; slot++)
+		{
+			m_Slots[level][slot].clear();
+		}
+	}
+	m_Overflow.clear();
+	m_Time = 0.0;
+	m_CurrentTick = 0;
+	m_PendingCount = 0;
+}
+
+void TimerWheel::remapIds(const std::vector<uint32_t>& remap)
+{
+	if (m_PendingCount == 0) return;
+
+	for (int level = 0; level < levelCount; level++)
+	{
+		for (int slot = 0; slot < slotsPerLevel; slot++)
+		{
+			std::vector<TimerEntry>& entries = m_Slots[level][slot];
+			for (size_t i = 0; i < entries.size(); i++)
+			{
+				entries[i].id = remap[entries[i].id];
+			}
+		}
+	}
+	for (size_t i = 0; i < m_Overflow.size(); i++)
+	{
+		m_Overflow[i].id = remap[m_Overflow[i].id];
+	}
+}
+
+void TimerWheel::insert(const TimerEntry& entry)
+{
+	uint64_t ticksLeft = entry.expiryTick > m_CurrentTick ? entry.expiryTick - m_CurrentTick : 0;
+
+	//Level n holds anything due within 64^(n+1) ticks, indexed by the matching 6 bits of its expiry tick
+	for (int level = 0; level < levelCount; level++)
+	{
+		if (ticksLeft < (1ull << (slotBits * (level + 1))))
+		{
+			int slot = static_cast<int>((entry.expiryTick >> (slotBits * level)) & (slotsPerLevel - 1));
+			m_Slots[level][slot].push_back(entry);
+			return;
+		}
+	}
+
+	m_Overflow.push_back(entry);
+}
+
+void TimerWheel::cascade(int level, int slot)
+{
+	//Swaps the slot out first because insert may add back into the same level
+	std::vector<TimerEntry> entries;
+	entries.swap(m_Slots[level][slot]);
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		insert(entries[i]);
+	}
+}
+
+void TimerWheel::tick(std::vector<uint32_t>& expired)
+{
+	m_CurrentTick++;
+
+	//Each time a lower level wraps around, the next slot of the level above is brought down
+	for (int level = 1; level < levelCount; level++)
+	{
+		uint64_t levelMask = (1ull << (slotBits * level)) - 1;
+		if ((m_CurrentTick & levelMask) != 0) break;
+		cascade(level, static_cast<int>((m_CurrentTick >> (slotBits * level)) & (slotsPerLevel - 1)));
+	}
+
+	//When the top level wraps the overflow timers get another chance to fit
+	if ((m_CurrentTick & ((1ull << (slotBits * levelCount)) - 1)) == 0 && !m_Overflow.empty())
+	{
+		std::vector<TimerEntry> entries;
+		entries.swap(m_Overflow);
+		for (size_t i = 0; i < entries.size(); i++)
+		{
+			insert(entries[i]);
+		}
+	}
+
+	//Everything left in the current bottom slot is due now
+	std::vector<TimerEntry>& dueSlot = m_Slots[0][m_CurrentTick & (slotsPerLevel - 1)];
+	for (size_t i = 0; i < dueSlot.size(); i++)
+	{
+		expired.push_back(dueSlot[i].id);
+	}
+	m_PendingCount -= dueSlot.size();
+	dueSlot.clear();
+}
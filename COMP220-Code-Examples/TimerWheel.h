@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//Hierarchical timing wheel driven by simulation time, used to expire particles without a thread per timer
+//Each level has 64 slots and covers 64 times the range of the level below, so scheduling and expiring are O(1)
+//and millions of pending timers only cost one small entry each
+class TimerWheel
+{
+public:
+	//tickSeconds is the resolution timers are rounded up to
+	explicit TimerWheel(double tickSeconds = 0.001);
+
+	//Fires id once delaySeconds of simulation time have passed
+	void schedule(uint32_t id, double delaySeconds);
+	//Moves simulation time on by deltaTime seconds and appends every id whose timer ran out to expired
+	void advance(double deltaTime, std::vector<uint32_t>& expired);
+	//Drops every pending timer and goes back to time zero
+	void clear();
+	//Replaces the id of every pending timer with remap[id], for when whatever the ids index has been moved
+	void remapIds(const std::vector<uint32_t>& remap);
+
+	size_t getPendingCount() const { return m_PendingCount; }
+
+private:
+	struct TimerEntry
+	{
+		uint32_t id;
+		uint64_t expiryTick;
+	};
+
+	static const int slotBits = 6;
+	static const int slotsPerLevel = 1 << slotBits;
+	static const int levelCount = 4;
+
+	//Puts an entry in the lowest level that can hold it, or straight into expired if it is already due
+	void insert(const TimerEntry& entry);
+	//Moves every entry out of a higher level slot down into the levels below
+	void cascade(int level, int slot);
+	void tick(std::vector<uint32_t>& expired);
+
+	std::vector<TimerEntry> m_Slots[levelCount][slotsPerLevel];
+	//Timers too far in the future for the top level, re-sorted each time the top level wraps
+	std::vector<TimerEntry> m_Overflow;
+
+	double m_TickSeconds;
+	double m_Time;
+	uint64_t m_CurrentTick;
+	size_t m_PendingCount;
+};
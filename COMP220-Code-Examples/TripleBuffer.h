@@ -0,0 +1,50 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+//Hands the newest value from one writer thread to one reader thread without either of them ever waiting
+//The writer fills the back buffer and swaps it with the middle one, the reader swaps the middle one into the front when it is newer
+//Both swaps are a single atomic exchange, so a slow reader just skips values instead of holding the writer up
+template<typename T>
+class TripleBuffer
+{
+public:
+	TripleBuffer()
+		: m_Middle(1), m_Back(0), m_Front(2)
+	{
+	}
+
+	//Writer side, the buffer to fill before calling publish, it still holds whatever was written three publishes ago
+	T& getWriteBuffer() { return m_Buffers[m_Back]; }
+	//Writer side, makes the write buffer the newest value, returns true if the reader never saw the value it replaces
+	bool publish()
+	{
+		uint8_t previous = m_Middle.exchange(static_cast<uint8_t>(m_Back | freshBit), std::memory_order_acq_rel);
+		m_Back = previous & indexMask;
+		return (previous & freshBit) != 0;
+	}
+
+	//Reader side, moves the newest published value into the read buffer, returns false if nothing new has been published
+	bool acquire()
+	{
+		if ((m_Middle.load(std::memory_order_relaxed) & freshBit) == 0) return false;
+		uint8_t previous = m_Middle.exchange(m_Front, std::memory_order_acq_rel);
+		m_Front = previous & indexMask;
+		return true;
+	}
+	//Reader side, the value from the last successful acquire
+	const T& getReadBuffer() const { return m_Buffers[m_Front]; }
+
+private:
+	//The middle index shares its byte with a flag saying it was published since the reader last took it
+	static const uint8_t indexMask = 3;
+	static const uint8_t freshBit = 4;
+
+	T m_Buffers[3];
+	std::atomic<uint8_t> m_Middle;
+	//Only ever touched by the writer
+	uint8_t m_Back;
+	//Only ever touched by the reader
+	uint8_t m_Front;
+};
@@ -0,0 +1,230 @@
+#include "UniformGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+//The hash is 32 bits, so buckets past this could never be reached and the offsets would no longer fit in uint32_t
+static const size_t maxBucketCount = static_cast<size_t>(1) << 31;
+//Cell coordinates are pinned to this either side of 0, so the float to int conversion and the cell counts can never overflow
+static const float maxCellCoordinate = static_cast<float>(1 << 30);
+
+UniformGrid::UniformGrid()
+	: m_CellSize(0.05f), m_BucketMask(0)
+{
+}
+
+inline int UniformGrid::toCellCoordinate(float value) const
+{
+	//Clamped before the conversion, which is undefined out of range, the argument order sends NaN to the bottom edge
+	//Once in range the conversion truncates towards 0, so stepping down below 0 gives floor without calling into libm
+	float cell = std::min(maxCellCoordinate, std::max(-maxCellCoordinate, value / m_CellSize));
+	int truncated = static_cast<int>(cell);
+	return truncated - (cell < static_cast<float>(truncated) ? 1 : 0);
+}
+
+inline UniformGrid::CellCoordinates UniformGrid::getCell(float x, float y, float z) const
+{
+	CellCoordinates cell;
+	cell.x = toCellCoordinate(x);
+	cell.y = toCellCoordinate(y);
+	cell.z = toCellCoordinate(z);
+	return cell;
+}
+
+bool UniformGrid::coversTooManyCells(const CellCoordinates& minimumCell, const CellCoordinates& maximumCell, size_t maxCells)
+{
+	//Coordinates are within 2^30 of 0, so each side fits in int64_t, the product is taken in double as it can pass 2^63
+	int64_t sizeX = static_cast<int64_t>(maximumCell.x) - minimumCell.x + 1;
+	int64_t sizeY = static_cast<int64_t>(maximumCell.y) - minimumCell.y + 1;
+	int64_t sizeZ = static_cast<int64_t>(maximumCell.z) - minimumCell.z + 1;
+	return static_cast<double>(sizeX) * static_cast<double>(sizeY) * static_cast<double>(sizeZ) > static_cast<double>(maxCells);
+}
+
+uint32_t UniformGrid::getBucket(int x, int y, int z) const
+{
+	//Large primes from Teschner et al. "Optimized Spatial Hashing for Collision Detection of Deformable Objects"
+	uint32_t hash = (static_cast<uint32_t>(x) * 73856093u) ^ (static_cast<uint32_t>(y) * 19349663u) ^ (static_cast<uint32_t>(z) * 83492791u);
+	return hash & m_BucketMask;
+}
+
+bool UniformGrid::isReferenceCell(const CellCoordinates& cell, float minimumX, float minimumY, float minimumZ) const
+{
+	//Compared as floats so this hot test needs neither the clamp nor the conversion, a point past the clamp never matches
+	return std::floor(minimumX / m_CellSize) == static_cast<float>(cell.x)
+		&& std::floor(minimumY / m_CellSize) == static_cast<float>(cell.y)
+		&& std::floor(minimumZ / m_CellSize) == static_cast<float>(cell.z);
+}
+
+void UniformGrid::build(const ParticleStore& particles, bool movingOnly)
+{
+	m_EntryBuckets.clear();
+	m_EntryParticles.clear();
+	m_OversizedParticles.clear();
+
+	//Roughly two buckets per particle keeps hash collisions rare
+	size_t bucketCount = 64;
+	while (bucketCount < particles.size() * 2 && bucketCount < maxBucketCount) bucketCount <<= 1;
+	m_BucketMask = static_cast<uint32_t>(bucketCount - 1);
+
+	//Works out every cell each particle covers, usually just one, and which bucket that cell hashes to
+	for (size_t i = 0; i < particles.size(); i++)
+	{
+		if (particles.state[i] == PARTICLE_DELETED) continue;
+		if (movingOnly && particles.state[i] != PARTICLE_MOVING) continue;
+
+		CellCoordinates minimumCell = getCell(particles.minimumX[i], particles.minimumY[i], particles.minimumZ[i]);
+		CellCoordinates maximumCell = getCell(particles.maximumX[i], particles.maximumY[i], particles.maximumZ[i]);
+		if (coversTooManyCells(minimumCell, maximumCell, maxCellsPerParticle))
+		{
+			m_OversizedParticles.push_back(static_cast<uint32_t>(i));
+			continue;
+		}
+		for (int x = minimumCell.x; x <= maximumCell.x; x++)
+		{
+			for (int y = minimumCell.y; y <= maximumCell.y; y++)
+			{
+				for (int z = minimumCell.z; z <= maximumCell.z; z++)
+				{
+					m_EntryParticles.push_back(static_cast<uint32_t>(i));
+					m_EntryBuckets.push_back(getBucket(x, y, z));
+				}
+			}
+		}
+	}
+
+	//Counting sort, count each bucket, prefix sum into start offsets, then scatter
+	m_BucketStart.assign(bucketCount + 1, 0);
+	for (size_t e = 0; e < m_EntryBuckets.size(); e++)
+	{
+		m_BucketStart[m_EntryBuckets[e]]++;
+	}
+	uint32_t runningTotal = 0;
+	for (size_t b = 0; b <= bucketCount; b++)
+	{
+		uint32_t bucketSize = m_BucketStart[b];
+		m_BucketStart[b] = runningTotal;
+		runningTotal += bucketSize;
+	}
+
+	//Entries were generated in particle order and the scatter keeps that order, so inside a bucket a particle
+	//that landed in two cells sharing the bucket shows up twice in a row, which the queries rely on to skip it
+	m_Entries.resize(m_EntryParticles.size());
+	//Fills each bucket from its start offset, leaving m_BucketStart[b] pointing at the end of bucket b
+	for (size_t e = 0; e < m_EntryParticles.size(); e++)
+	{
+		m_Entries[m_BucketStart[m_EntryBuckets[e]]++] = m_EntryParticles[e];
+	}
+	//Shifts the offsets back down so m_BucketStart[b] is the start of bucket b again
+	for (size_t b = bucketCount; b > 0; b--)
+	{
+		m_BucketStart[b] = m_BucketStart[b - 1];
+	}
+	m_BucketStart[0] = 0;
+}
+
+void UniformGrid::findColliderPairs(const ParticleStore& particles, const std::vector<AABB>& colliders, std::vector<CollisionPair>& pairs) const
+{
+	//Oversized particles are in no cell, so they are paired with every collider
+	for (size_t o = 0; o < m_OversizedParticles.size(); o++)
+	{
+		for (size_t c = 0; c < colliders.size(); c++)
+		{
+			CollisionPair pair = { m_OversizedParticles[o], static_cast<uint32_t>(c) };
+			pairs.push_back(pair);
+		}
+	}
+	if (m_Entries.empty()) return;
+
+	for (size_t c = 0; c < colliders.size(); c++)
+	{
+		const AABB& collider = colliders[c];
+		CellCoordinates minimumCell = getCell(collider.minimum.x, collider.minimum.y, collider.minimum.z);
+		CellCoordinates maximumCell = getCell(collider.maximum.x, collider.maximum.y, collider.maximum.z);
+
+		//A collider too big to walk the cells of is paired with every bucketed particle instead
+		if (coversTooManyCells(minimumCell, maximumCell, std::max<size_t>(maxCellsPerParticle, m_Entries.size() * maxColliderCellsPerEntry)))
+		{
+			for (size_t e = 0; e < m_EntryParticles.size(); e++)
+			{
+				if (e > 0 && m_EntryParticles[e - 1] == m_EntryParticles[e]) continue;
+				CollisionPair pair = { m_EntryParticles[e], static_cast<uint32_t>(c) };
+				pairs.push_back(pair);
+			}
+			continue;
+		}
+
+		for (int x = minimumCell.x; x <= maximumCell.x; x++)
+		{
+			for (int y = minimumCell.y; y <= maximumCell.y; y++)
+			{
+				for (int z = minimumCell.z; z <= maximumCell.z; z++)
+				{
+					CellCoordinates cell = { x, y, z };
+					uint32_t bucket = getBucket(x, y, z);
+					for (uint32_t e = m_BucketStart[bucket]; e < m_BucketStart[bucket + 1]; e++)
+					{
+						uint32_t i = m_Entries[e];
+						if (e > m_BucketStart[bucket] && m_Entries[e - 1] == i) continue;
+						//Skips hash collisions from other cells and stops a particle spanning several cells being reported more than once
+						if (!isReferenceCell(cell,
+							std::max(particles.minimumX[i], collider.minimum.x),
+							std::max(particles.minimumY[i], collider.minimum.y),
+							std::max(particles.minimumZ[i], collider.minimum.z))) continue;
+
+						CollisionPair pair = { i, static_cast<uint32_t>(c) };
+						pairs.push_back(pair);
+					}
+				}
+			}
+		}
+	}
+}
+
+void UniformGrid::findParticlePairs(const ParticleStore& particles, std::vector<CollisionPair>& pairs) const
+{
+	//Oversized particles are in no cell, so each is paired with every bucketed particle and every later oversized one
+	for (size_t o = 0; o < m_OversizedParticles.size(); o++)
+	{
+		uint32_t i = m_OversizedParticles[o];
+		for (size_t e = 0; e < m_EntryParticles.size(); e++)
+		{
+			uint32_t j = m_EntryParticles[e];
+			if (e > 0 && m_EntryParticles[e - 1] == j) continue;
+			CollisionPair pair = { std::min(i, j), std::max(i, j) };
+			pairs.push_back(pair);
+		}
+		for (size_t other = o + 1; other < m_OversizedParticles.size(); other++)
+		{
+			CollisionPair pair = { i, m_OversizedParticles[other] };
+			pairs.push_back(pair);
+		}
+	}
+	if (m_Entries.empty()) return;
+
+	size_t bucketCount = static_cast<size_t>(m_BucketMask) + 1;
+	for (uint32_t bucket = 0; bucket < bucketCount; bucket++)
+	{
+		uint32_t bucketEnd = m_BucketStart[bucket + 1];
+		uint32_t bucketStart = m_BucketStart[bucket];
+		for (uint32_t a = bucketStart; a < bucketEnd; a++)
+		{
+			uint32_t i = m_Entries[a];
+			if (a > bucketStart && m_Entries[a - 1] == i) continue;
+			for (uint32_t b = a + 1; b < bucketEnd; b++)
+			{
+				uint32_t j = m_Entries[b];
+				if (m_Entries[b - 1] == j) continue;
+
+				//Only reports the pair from the bucket of the cell where the two boxes start overlapping
+				float referenceX = std::max(particles.minimumX[i], particles.minimumX[j]);
+				float referenceY = std::max(particles.minimumY[i], particles.minimumY[j]);
+				float referenceZ = std::max(particles.minimumZ[i], particles.minimumZ[j]);
+				CellCoordinates referenceCell = getCell(referenceX, referenceY, referenceZ);
+				if (getBucket(referenceCell.x, referenceCell.y, referenceCell.z) != bucket) continue;
+
+				CollisionPair pair = { i, j };
+				pairs.push_back(pair);
+			}
+		}
+	}
+}
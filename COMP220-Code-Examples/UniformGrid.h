@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Bounds.h"
+#include "ParticleStore.h"
+
+//A particle and whatever it might be touching, either a collider index or another particle index
+struct CollisionPair
+{
+	uint32_t particle;
+	uint32_t other;
+};
+
+//Spatial hash broadphase, particles are bucketed by the grid cells their bounds cover
+//Rebuilt from scratch every step with a counting sort, so there is nothing to keep in sync as particles move
+//Boxes covering too many cells, like a ground plane or a particle swept a long way in one step, skip the cells and are paired
+//with everything instead, so one large box costs at most a brute force pass rather than a loop over every cell it covers
+class UniformGrid
+{
+public:
+	//Most cells a particle is bucketed into, a particle normally covers 1 to 8
+	static const int maxCellsPerParticle = 64;
+	//A collider can cover this many cells per bucketed entry, walking a cell is far cheaper than the narrowphase test a pair costs
+	//so only well past that is pairing the collider with every particle cheaper than walking its cells
+	static const int maxColliderCellsPerEntry = 8;
+
+	UniformGrid();
+
+	//cellSize should be a little bigger than a particle so most particles only land in one cell
+	void setCellSize(float cellSize) { m_CellSize = cellSize; }
+	float getCellSize() const { return m_CellSize; }
+
+	//Buckets every particle, or only the ones still moving if movingOnly is set
+	void build(const ParticleStore& particles, bool movingOnly);
+
+	//Appends a pair for every bucketed particle that shares a cell with one of the colliders, each pair is reported once
+	//Pairs are candidates only, the caller still has to run the AABB test on them
+	void findColliderPairs(const ParticleStore& particles, const std::vector<AABB>& colliders, std::vector<CollisionPair>& pairs) const;
+	//Appends a pair for every two bucketed particles that share a cell, each pair is reported once with particle < other
+	void findParticlePairs(const ParticleStore& particles, std::vector<CollisionPair>& pairs) const;
+
+	size_t getEntryCount() const { return m_Entries.size(); }
+	size_t getOversizedCount() const { return m_OversizedParticles.size(); }
+
+private:
+	struct CellCoordinates
+	{
+		int x, y, z;
+	};
+
+	CellCoordinates getCell(float x, float y, float z) const;
+	int toCellCoordinate(float value) const;
+	static bool coversTooManyCells(const CellCoordinates& minimumCell, const CellCoordinates& maximumCell, size_t maxCells);
+	uint32_t getBucket(int x, int y, int z) const;
+	//True if the cell holding the larger of the two minimum corners is this cell, so a pair found in several cells is only reported from one
+	bool isReferenceCell(const CellCoordinates& cell, float minimumX, float minimumY, float minimumZ) const;
+
+	float m_CellSize;
+	//Bucket count is a power of two so the hash can be masked
+	uint32_t m_BucketMask;
+	//m_Entries[m_BucketStart[b] .. m_BucketStart[b + 1]) are the particles in bucket b
+	std::vector<uint32_t> m_BucketStart;
+	std::vector<uint32_t> m_Entries;
+	//Scratch space for the counting sort, kept between builds so they do not reallocate
+	//m_EntryParticles is in particle order, so it also lists every bucketed particle for the queries, with repeats next to each other
+	std::vector<uint32_t> m_EntryBuckets;
+	std::vector<uint32_t> m_EntryParticles;
+	//Particles left out of the cells because they cover too many, in particle order
+	std::vector<uint32_t> m_OversizedParticles;
+};
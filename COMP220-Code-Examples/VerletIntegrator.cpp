@@ -0,0 +1,190 @@
+#include "VerletIntegrator.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "SimdPlatform.h"
+
+IntegratorSettings::IntegratorSettings()
+	: gravity(0.0f), wind(0.0f), drag(0.0f), constrainToBounds(false)
+{
+	bounds = { glm::vec3(-1.0f), glm::vec3(1.0f) };
+}
+
+//Everything the loops need for one axis, worked out once per call
+struct AxisConstants
+{
+	float gravity;
+	float wind;
+	float minimum;
+	float maximum;
+};
+
+//Pointers to one axis of the range being integrated
+struct AxisArrays
+{
+	float* position;
+	float* previousPosition;
+	float* velocity;
+};
+
+static void IntegrateScalar(const AxisConstants axes[3], const AxisArrays arrays[3], float drag, float deltaTime, const uint8_t* state, size_t first, size_t last)
+{
+	for (size_t i = first; i < last; i++)
+	{
+		//Particles that have hit something stay exactly where they are
+		float moveTime = state[i] == PARTICLE_MOVING ? deltaTime : 0.0f;
+		float halfMoveTime = moveTime * 0.5f;
+		for (int a = 0; a < 3; a++)
+		{
+			float position = arrays[a].position[i];
+			float velocity = arrays[a].velocity[i];
+			arrays[a].previousPosition[i] = position;
+
+			float startAcceleration = axes[a].gravity + drag * (axes[a].wind - velocity);
+			position += velocity * moveTime + startAcceleration * (halfMoveTime * moveTime);
+			float predictedVelocity = velocity + startAcceleration * moveTime;
+			float endAcceleration = axes[a].gravity + drag * (axes[a].wind - predictedVelocity);
+			velocity += (startAcceleration + endAcceleration) * halfMoveTime;
+
+			//A particle pushed back inside the bounds loses its velocity along that axis, like the old constrainToBounds clamp
+			float constrained = std::min(std::max(position, axes[a].minimum), axes[a].maximum);
+			arrays[a].position[i] = constrained;
+			arrays[a].velocity[i] = constrained == position ? velocity : 0.0f;
+		}
+	}
+}
+
+#if defined(SIMD_HAS_SSE)
+static inline void IntegrateAxisSse(const AxisConstants& axis, const AxisArrays& arrays, size_t i, __m128 drag, __m128 moveTime, __m128 halfMoveTime)
+{
+	__m128 position = _mm_loadu_ps(arrays.position + i);
+	__m128 velocity = _mm_loadu_ps(arrays.velocity + i);
+	_mm_storeu_ps(arrays.previousPosition + i, position);
+
+	const __m128 gravity = _mm_set1_ps(axis.gravity);
+	const __m128 wind = _mm_set1_ps(axis.wind);
+	__m128 startAcceleration = _mm_add_ps(gravity, _mm_mul_ps(drag, _mm_sub_ps(wind, velocity)));
+	position = _mm_add_ps(position, _mm_add_ps(_mm_mul_ps(velocity, moveTime), _mm_mul_ps(startAcceleration, _mm_mul_ps(halfMoveTime, moveTime))));
+	__m128 predictedVelocity = _mm_add_ps(velocity, _mm_mul_ps(startAcceleration, moveTime));
+	__m128 endAcceleration = _mm_add_ps(gravity, _mm_mul_ps(drag, _mm_sub_ps(wind, predictedVelocity)));
+	velocity = _mm_add_ps(velocity, _mm_mul_ps(_mm_add_ps(startAcceleration, endAcceleration), halfMoveTime));
+
+	__m128 constrained = _mm_min_ps(_mm_max_ps(position, _mm_set1_ps(axis.minimum)), _mm_set1_ps(axis.maximum));
+	_mm_storeu_ps(arrays.position + i, constrained);
+	_mm_storeu_ps(arrays.velocity + i, _mm_and_ps(velocity, _mm_cmpeq_ps(constrained, position)));
+}
+
+//Returns how many particles it handled, the rest are left for the scalar loop
+static size_t IntegrateSse(const AxisConstants axes[3], const AxisArrays arrays[3], float drag, float deltaTime, const uint8_t* state, size_t count)
+{
+	const __m128 dragVector = _mm_set1_ps(drag);
+	const __m128 deltaTimeVector = _mm_set1_ps(deltaTime);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128i zero = _mm_setzero_si128();
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		//Widens 4 state bytes to 4 lanes, all ones where the particle is still moving
+		int stateBytes;
+		memcpy(&stateBytes, state + i, sizeof(stateBytes));
+		__m128i states = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(stateBytes), zero), zero);
+		__m128 moving = _mm_castsi128_ps(_mm_cmpeq_epi32(states, _mm_set1_epi32(PARTICLE_MOVING)));
+		__m128 moveTime = _mm_and_ps(moving, deltaTimeVector);
+		__m128 halfMoveTime = _mm_mul_ps(moveTime, half);
+
+		for (int a = 0; a < 3; a++)
+		{
+			IntegrateAxisSse(axes[a], arrays[a], i, dragVector, moveTime, halfMoveTime);
+		}
+	}
+	return i;
+}
+#endif
+
+#if defined(SIMD_HAS_AVX2)
+SIMD_AVX2_FUNCTION
+static inline void IntegrateAxisAvx2(const AxisConstants& axis, const AxisArrays& arrays, size_t i, __m256 drag, __m256 moveTime, __m256 halfMoveTime)
+{
+	__m256 position = _mm256_loadu_ps(arrays.position + i);
+	__m256 velocity = _mm256_loadu_ps(arrays.velocity + i);
+	_mm256_storeu_ps(arrays.previousPosition + i, position);
+
+	const __m256 gravity = _mm256_set1_ps(axis.gravity);
+	const __m256 wind = _mm256_set1_ps(axis.wind);
+	__m256 startAcceleration = _mm256_add_ps(gravity, _mm256_mul_ps(drag, _mm256_sub_ps(wind, velocity)));
+	position = _mm256_add_ps(position, _mm256_add_ps(_mm256_mul_ps(velocity, moveTime), _mm256_mul_ps(startAcceleration, _mm256_mul_ps(halfMoveTime, moveTime))));
+	__m256 predictedVelocity = _mm256_add_ps(velocity, _mm256_mul_ps(startAcceleration, moveTime));
+	__m256 endAcceleration = _mm256_add_ps(gravity, _mm256_mul_ps(drag, _mm256_sub_ps(wind, predictedVelocity)));
+	velocity = _mm256_add_ps(velocity, _mm256_mul_ps(_mm256_add_ps(startAcceleration, endAcceleration), halfMoveTime));
+
+	__m256 constrained = _mm256_min_ps(_mm256_max_ps(position, _mm256_set1_ps(axis.minimum)), _mm256_set1_ps(axis.maximum));
+	_mm256_storeu_ps(arrays.position + i, constrained);
+	_mm256_storeu_ps(arrays.velocity + i, _mm256_and_ps(velocity, _mm256_cmp_ps(constrained, position, _CMP_EQ_OQ)));
+}
+
+SIMD_AVX2_FUNCTION
+static size_t IntegrateAvx2(const AxisConstants axes[3], const AxisArrays arrays[3], float drag, float deltaTime, const uint8_t* state, size_t count)
+{
+	const __m256 dragVector = _mm256_set1_ps(drag);
+	const __m256 deltaTimeVector = _mm256_set1_ps(deltaTime);
+	const __m256 half = _mm256_set1_ps(0.5f);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		//Widens 8 state bytes to 8 lanes, all ones where the particle is still moving
+		__m256i states = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(state + i)));
+		__m256 moving = _mm256_castsi256_ps(_mm256_cmpeq_epi32(states, _mm256_set1_epi32(PARTICLE_MOVING)));
+		__m256 moveTime = _mm256_and_ps(moving, deltaTimeVector);
+		__m256 halfMoveTime = _mm256_mul_ps(moveTime, half);
+
+		for (int a = 0; a < 3; a++)
+		{
+			IntegrateAxisAvx2(axes[a], arrays[a], i, dragVector, moveTime, halfMoveTime);
+		}
+	}
+	return i;
+}
+#endif
+
+void IntegrateVerlet(const IntegratorSettings& settings, float deltaTime, ParticleStore& particles, size_t begin, size_t count)
+{
+	IntegrateVerlet(settings, deltaTime, particles, begin, count, GetBestAabbKernel());
+}
+
+void IntegrateVerlet(const IntegratorSettings& settings, float deltaTime, ParticleStore& particles, size_t begin, size_t count, AabbKernelLevel level)
+{
+	if (count == 0) return;
+	if (!IsAabbKernelSupported(level)) level = GetBestAabbKernel();
+
+	//Unconstrained particles are clamped to infinity, which never changes them, so the loops do not need a branch for it
+	const float infinity = std::numeric_limits<float>::infinity();
+	glm::vec3 minimum = settings.constrainToBounds ? settings.bounds.minimum : glm::vec3(-infinity);
+	glm::vec3 maximum = settings.constrainToBounds ? settings.bounds.maximum : glm::vec3(infinity);
+
+	const AxisConstants axes[3] =
+	{
+		{ settings.gravity.x, settings.wind.x, minimum.x, maximum.x },
+		{ settings.gravity.y, settings.wind.y, minimum.y, maximum.y },
+		{ settings.gravity.z, settings.wind.z, minimum.z, maximum.z }
+	};
+	const AxisArrays arrays[3] =
+	{
+		{ &particles.positionX[begin], &particles.previousPositionX[begin], &particles.velocityX[begin] },
+		{ &particles.positionY[begin], &particles.previousPositionY[begin], &particles.velocityY[begin] },
+		{ &particles.positionZ[begin], &particles.previousPositionZ[begin], &particles.velocityZ[begin] }
+	};
+	const uint8_t* state = &particles.state[begin];
+
+	size_t handled = 0;
+#if defined(SIMD_HAS_AVX2)
+	if (level == AABB_KERNEL_AVX2) handled = IntegrateAvx2(axes, arrays, settings.drag, deltaTime, state, count);
+#endif
+#if defined(SIMD_HAS_SSE)
+	if (level == AABB_KERNEL_SSE) handled = IntegrateSse(axes, arrays, settings.drag, deltaTime, state, count);
+#endif
+	IntegrateScalar(axes, arrays, settings.drag, deltaTime, state, handled, count);
+}
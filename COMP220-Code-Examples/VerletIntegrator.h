@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include "Bounds.h"
+#include "ParticleStore.h"
+#include "AabbKernel.h"
+
+//Forces and limits every moving particle is integrated with, the defaults leave particles flying in a straight line
+struct IntegratorSettings
+{
+	IntegratorSettings();
+
+	//Acceleration in units per second squared, the same for every particle
+	glm::vec3 gravity;
+	//Velocity of the air, drag pulls each particles velocity towards it
+	glm::vec3 wind;
+	//How quickly drag closes the gap between a particles velocity and the wind, per second, 0 turns it off
+	float drag;
+	//Keeps particles inside bounds, a particle that reaches a side stops moving along that axis
+	bool constrainToBounds;
+	AABB bounds;
+};
+
+//Velocity Verlet step for particles [begin, begin + count) of a store, the 3D structure of arrays version of the old Particle::update
+//Moves each moving particle by its velocity plus half its acceleration, then averages the acceleration at both ends of the step into the velocity
+//Drag depends on velocity, so the end of step acceleration uses the velocity predicted from the start of the step
+//Also copies position into previousPosition for every particle, moving or not
+//The range must not cross a particle chunk, runs 4 or 8 particles at a time with SSE or AVX2 when it can
+void IntegrateVerlet(const IntegratorSettings& settings, float deltaTime, ParticleStore& particles, size_t begin, size_t count);
+//Same as above but forces a level, using the same CPUID check as the AABB kernel, used to compare them
+void IntegrateVerlet(const IntegratorSettings& settings, float deltaTime, ParticleStore& particles, size_t begin, size_t count, AabbKernelLevel level);
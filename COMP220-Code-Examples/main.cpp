@@ -18,27 +18,31 @@
 #include "Vertex.h"
 #include "LoadModel.h"
 #include "BufferObjectsLoad.h"
+#include "ParticleSimulation.h"
+#include "Headless.h"
+#include "MeshRegistry.h"
+#include "AssetQueue.h"
+#include "TextureLoad.h"
+#include "InstancedRenderer.h"
+#include "FixedTimestep.h"
+#include "SimulationThread.h"
+#include "Profiler.h"
 
 #include <string>
 #include <map>
 #include <random>
 #include <vector>
-#include <thread>
+#include <cstring>
 #include <chrono>
 
 SDL_Window* window;
 
 bool running = true;
 
-//Global variables for loading cubes
-std::vector<Vertex> vertices;
-std::vector<unsigned> indices;
-std::string texturePath;
-
-//Global variables for loading glass
-std::vector<Vertex> vertices2;
-std::vector<unsigned> indices2;
-std::string texturePath2;
+//Imports each model file once, the cubes and the glass share the same crate mesh
+MeshRegistry meshRegistry;
+MeshHandle crateMeshHandle;
+MeshHandle glassMeshHandle;
 
 //Camera variables
 glm::vec3 cameraPos = glm::vec3(0.0f, 0.0f, 3.0f);
@@ -49,21 +53,61 @@ const glm::vec4 cameraFace(0, 0, -1, 0);
 glm::vec3 rotation = glm::vec3(0);
 const float walkspeed = 0.2f, rotSpeed = 0.1f;
 
-//Number of boxes to spawn to represent particles
+//Number of boxes to spawn to represent particles, --particles <count> changes it
 unsigned int numOfBoxes = 1000;
 
-//Particle position variables
-glm::vec3 particlePosition;
-
 //Glass position variables
 glm::vec3 glassPosition;
 glm::vec3 glassScale;
 
-GLuint textureID;
-
-std::vector<bool> collidedChecker(numOfBoxes, false);
-std::vector<bool> deleteChecker(numOfBoxes, false);
-int deletionDelay = 2;
+//Owns the particles, the glass and the collision checks
+ParticleSimulation simulation;
+
+//Command line options
+//--no-instancing draws each particle with its own draw call, the way it used to
+bool useInstancing = true;
+//--hidden creates the window hidden so it can run offscreen, e.g. on Mesa llvmpipe
+bool hiddenWindow = false;
+//--frames <count> quits after that many frames, 0 runs until the window is closed
+unsigned int frameLimit = 0;
+//--threads <count> sets how many threads update the particles, 0 uses every core
+unsigned int threadCount = 0;
+//--step-rate <hz> sets how many fixed simulation steps run per second of real time, whatever the frame rate
+double stepRate = 60.0;
+//--max-steps <count> caps the steps one frame, or one wake up of the simulation thread, can run, past that the simulation slows down instead
+unsigned int maxStepsPerFrame = 8;
+//--serial steps the simulation inside the render loop instead of on its own thread
+bool serialLoop = false;
+//--emit-rate <per second> keeps spawning particles in front of the glass, reusing the slots of deleted ones
+float emitRate = 0.0f;
+//--seed <n> spawns exactly the same particles as any other run with that seed, runs without it all use defaultRandomSeed
+unsigned long long seed = defaultRandomSeed;
+//--upload-budget <ms> caps how long each frame spends uploading loaded assets to the GPU
+double uploadBudgetMilliseconds = 2.0;
+//--no-shader-cache compiles every shader from source instead of loading the program binaries saved last time
+bool useShaderCache = true;
+//--profile <file> records how long each part of every frame takes, writes a Chrome trace there and prints a summary at exit
+const char* tracePath = nullptr;
+
+void ReadCommandLine(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--no-instancing") == 0) useInstancing = false;
+		else if (strcmp(argv[i], "--hidden") == 0) hiddenWindow = true;
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) frameLimit = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threadCount = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--step-rate") == 0 && i + 1 < argc) stepRate = strtod(argv[++i], nullptr);
+		else if (strcmp(argv[i], "--max-steps") == 0 && i + 1 < argc) maxStepsPerFrame = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--serial") == 0) serialLoop = true;
+		else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) tracePath = argv[++i];
+		else if (strcmp(argv[i], "--particles") == 0 && i + 1 < argc) numOfBoxes = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--no-shader-cache") == 0) useShaderCache = false;
+		else if (strcmp(argv[i], "--upload-budget") == 0 && i + 1 < argc) uploadBudgetMilliseconds = strtod(argv[++i], nullptr);
+		else if (strcmp(argv[i], "--emit-rate") == 0 && i + 1 < argc) emitRate = strtof(argv[++i], nullptr);
+		else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = strtoull(argv[++i], nullptr, 10);
+	}
+}
 
 SDL_Window* CreateWindow()
 {
@@ -80,7 +124,9 @@ SDL_Window* CreateWindow()
 	//Create a window, note we have to free the pointer returned using the DestroyWindow Function
 	//https://wiki.libsdl.org/SDL_CreateWindow
 	//Creates screen to view image with its dimensions uses a pointer so it does not duplicate, can change windows settings using different values
-	window = SDL_CreateWindow("SDL2 Window", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 960, 720, SDL_WINDOW_OPENGL);
+	Uint32 windowFlags = SDL_WINDOW_OPENGL;
+	if (hiddenWindow) windowFlags |= SDL_WINDOW_HIDDEN;
+	window = SDL_CreateWindow("SDL2 Window", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, 960, 720, windowFlags);
 	//Checks to see if the window has been created, the pointer will have a value of some kind, if not it did not work
 	if (window == nullptr)
 	{
@@ -99,7 +145,8 @@ void IntializeSDLVersion()
 {
 	//Set SDL_GL version
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 1);
+	//3.3 is needed for glVertexAttribDivisor, which the instanced particles use
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
 }
 
@@ -170,22 +217,36 @@ glm::vec3 Vec4ToVec3(glm::vec4 vec4ToConvert)
 	return vec3ToReturn;
 }
 
-void Delay(int iterator)
+//Draws the bound mesh once for every model matrix, the fallback when instancing is off, returns how many draw calls it made
+unsigned int DrawParticleModels(const std::vector<glm::mat4>& models, const glm::mat4& viewProjection, unsigned int transformLoc, unsigned int modelLoc, size_t numOfIndices)
 {
-	//Create a new thread which lets multiple functions run at the same time
-	std::thread([iterator]()
-		{
-			//sleeps for a duration, because it is in a thread will not delay the rest of the program
-			std::this_thread::sleep_for(std::chrono::seconds(deletionDelay));
-			std::cout << "Deletion delay elapsed for cube " << iterator + 1 << std::endl;
-			//This is checked when rendering the cubes, if set to true that cube will stop rendering
-			deleteChecker[iterator] = true;
-		//Detatch the thread once it is no longer needed
-		}).detach();
+	for (size_t i = 0; i < models.size(); i++)
+	{
+		glm::mat4 particleMVP = viewProjection * models[i];
+		glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(particleMVP));
+		glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(models[i]));
+		glDrawElements(GL_TRIANGLES, numOfIndices, GL_UNSIGNED_INT, (void*)0);
+	}
+	return static_cast<unsigned int>(models.size());
 }
 
 int main(int argc, char ** argsv)
 {
+	//Runs the simulation on its own without creating a window
+	if (IsHeadlessRequested(argc, argsv))
+	{
+		return RunHeadless(argc, argsv);
+	}
+
+	//Time to first frame is measured from here
+	auto startupTime = std::chrono::steady_clock::now();
+
+	ReadCommandLine(argc, argsv);
+
+	//Worker threads for the particle update, lives until main returns
+	JobSystem jobSystem(threadCount);
+	simulation.setJobSystem(&jobSystem);
+
 	IntializeSDLVersion();
 
 	window = CreateWindow();
@@ -196,88 +257,51 @@ int main(int argc, char ** argsv)
 
 	IntializeGlew();
 
-	LoadModel("Crate.fbx", vertices, indices, texturePath);
-	
-	LoadModel("Crate.fbx", vertices2, indices2, texturePath2);
-
-	//Check if model has texture
-	bool hasTexture = !texturePath.empty();
+	//Declared before the queue so it outlives the worker that loads it
+	TextureData crateTexture;
+
+	//Models and textures load on worker threads while the loop below is already drawing, their GPU uploads are spread over the frames
+	AssetQueue assetQueue;
+
+	//Create buffer objects once the crate mesh has loaded
+	unsigned int VBO = 0, VAO = 0, EBO = 0;
+	crateMeshHandle = meshRegistry.loadAsync("Crate.fbx", assetQueue, [&] {
+		//Initalise them
+		glGenVertexArrays(1, &VAO);
+		glGenBuffers(1, &VBO);
+		glGenBuffers(1, &EBO);
+		//Load all their attributes and stuff in this function
+		const MeshData& loadedMesh = meshRegistry.getMesh(crateMeshHandle);
+		LoadBufferObjects(loadedMesh.vertices, loadedMesh.indices, VBO, VAO, EBO);
+	});
+	//The glass is the same file, so it shares the crate buffers
+	glassMeshHandle = meshRegistry.loadAsync("Crate.fbx", assetQueue, nullptr);
+	const MeshData& crateMesh = meshRegistry.getMesh(crateMeshHandle);
+	const MeshData& glassMesh = meshRegistry.getMesh(glassMeshHandle);
 
 	//hard coded texture path
-	SDL_Surface* image = IMG_Load("tex/crate_color.png");
-
-	// Create one OpenGL texture
-	GLuint textureID;
-	//Create buffer objects
-	unsigned int VBO, VAO, EBO;
-	//Initalise them
-	glGenVertexArrays(1, &VAO);
-	glGenBuffers(1, &VBO);
-	glGenBuffers(1, &EBO);
-	//Load all their attributes and stuff in this function
-	LoadBufferObjects(vertices, indices, VBO, VAO, EBO);
+	crateTexture.filePath = "tex/crate_color.png";
+	LoadTextureAsync(assetQueue, crateTexture);
 
-	//Texture binding for cubes
-	if (image) {
-		//NOTE: FOLLOWING CODE BLOCK DERIVED FROM: http://www.opengl-tutorial.org/beginners-tutorials/tutorial-5-a-textured-cube/#using-the-texture-in-opengl
-
-		//IF IMAGE BREAKING CHECK THIS
-		glGenTextures(1, &textureID);
-
-		// "Bind" the newly created texture : all future texture functions will modify this texture
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		int Mode = GL_RGB;
-
-		if (image->format->BytesPerPixel == 4) {
-			Mode = GL_RGBA;
-		}
-		glTexImage2D(GL_TEXTURE_2D, 0, Mode, image->w, image->h, 0, Mode, GL_UNSIGNED_BYTE, image->pixels);
-
-		// Nice trilinear filtering.
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT); //repeats if we go beyond TEXTURE UV maxima
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glGenerateMipmap(GL_TEXTURE_2D);
-	}
+	//Check if model has texture, known once the crate has loaded
+	bool hasTexture = false;
 
 	// Create and compile our GLSL programs from the shaders
+	SetShaderCacheEnabled(useShaderCache);
 	GLuint shaderProgram = LoadShaders("BasicVert.glsl",
 		"BasicFrag.glsl");
 	GLuint postShaderID = LoadShaders("vertShader_post.glsl",
 		"fragShader_post.glsl");
 	GLuint transparentShader = LoadShaders("BasicVert.glsl", "TransparentFrag.glsl");
+	const ShaderCacheStats& shaderStats = GetShaderCacheStats();
+	std::cout << "Shader cache: " << shaderStats.hitCount << "/" << shaderStats.hitCount + shaderStats.missCount << " programs from cache, "
+		<< shaderStats.compileMilliseconds << " ms compiling, " << shaderStats.savedMilliseconds << " ms saved" << std::endl;
 
-	//Glass identiy matrix
-	glm::mat4 glassModel = glm::mat4(1.0f);
-	glassPosition = glm::vec3(0, 0, 0.5);
-	glassModel = glm::translate(glassModel, glm::vec3(glassPosition));
-	glassScale = glm::vec3(0.01f, 0.01f, 0.001f);
-	glassModel = glm::scale(glassModel, glassScale);
-
-	//Min and max bounds of the glass declaration
-	glm::vec4 transformedGlassMinBound = glassModel * glm::vec4(vertices2[0].x, vertices2[0].y, vertices2[0].z, 1.0f);
-	glm::vec4 transformedGlassMaxBound = glassModel * glm::vec4(vertices2[0].x, vertices2[0].y, vertices2[0].z, 1.0f);
-
-	//iterates through every vertex in the glass
-	for (int i = 0; i < vertices2.size(); i++)
-	{
-		//Multiplies each vertex by the glassModel matrix to account for scaling and positioning in world space
-		glm::vec4 transformedVertex = glassModel * glm::vec4(vertices2[i].x, vertices2[i].y, vertices2[i].z, 1.0f);
-		//Gets the smallest value between the glass bound and the vertex bound and sets that to be the new min bound, ensuring the smallest one is found
-		transformedGlassMinBound.x = std::min(transformedGlassMinBound.x, transformedVertex.x);
-		transformedGlassMinBound.y = std::min(transformedGlassMinBound.y, transformedVertex.y);
-		transformedGlassMinBound.z = std::min(transformedGlassMinBound.z, transformedVertex.z);
-
-		transformedGlassMaxBound.x = std::max(transformedGlassMaxBound.x, transformedVertex.x);
-		transformedGlassMaxBound.y = std::max(transformedGlassMaxBound.y, transformedVertex.y);
-		transformedGlassMaxBound.z = std::max(transformedGlassMaxBound.z, transformedVertex.z);
-	}
+	//Filled in by setGlass once the glass mesh has loaded
+	const glm::mat4& glassModel = simulation.getGlassModel();
 
 	//Setup matricies
 	glm::mat4 glassPlaneMVP, //Glass plane model, view, projection matrix
-		particleMVP, //Particle model, view, projection matrix
 		view, //View matrix - handles everything that the camera sees
 		projection; //Projection matrix - gives the camera depth perspective
 
@@ -285,7 +309,12 @@ int main(int argc, char ** argsv)
 	unsigned int 
 		transformLoc = glGetUniformLocation(shaderProgram, "transform"), //Location of the object
 		objColourLoc = glGetUniformLocation(shaderProgram, "objColour"), //Color of the object, overwritten by texture
-		modelLoc = glGetUniformLocation(shaderProgram, "model"); //Model identity matrix
+		modelLoc = glGetUniformLocation(shaderProgram, "model"), //Model identity matrix
+		instancedLoc = glGetUniformLocation(shaderProgram, "instanced"), //Switches the vertex shader over to the instance attribute
+		viewProjectionLoc = glGetUniformLocation(shaderProgram, "viewProjection"); //Projection * view, used when instanced
+
+	//Per-instance buffer for the particles, hooked into the crate VAO once it exists
+	InstancedRenderer particleRenderer;
 
 	//LIGHT VALUES
 	float lightValues[] = {
@@ -362,59 +391,6 @@ int main(int argc, char ** argsv)
 		3, 2, 0
 	};
 
-	//Array to store their positions
-	std::vector <glm::vec3> boxPositions;
-	glm::mat4 boxModels[1000];
-
-	//List of vertices and indices of each loaded model
-	std::vector<std::vector<Vertex>> listOfVertices;
-	std::vector<std::vector<unsigned int>> listOfIndices;
-
-	//Declare list of vec3's to store the minimum and maximum bounds of the cubes
-	std::vector<glm::vec3> minimumBounds;
-	std::vector<glm::vec3> maximumBounds;
-
-	//Need to do this to make random actually random
-	srand(time(0));
-
-	//for loop for randomly setting the x and ys of the boxes
-	for (int i = 0; i < numOfBoxes; i++)
-	{	
-		//temp values to store indices and indices that load model will use
-		std::vector<Vertex> tempVertices;
-		std::vector<unsigned int> tempIndices;
-		LoadModel("Crate.fbx", tempVertices, tempIndices, texturePath);
-		//push back to the list after they have been populated
-		listOfVertices.push_back(tempVertices);
-		listOfIndices.push_back(tempIndices);
-
-		glm::mat4 newBoxModel = glm::mat4(1.0f);
-		//randomly places cube positions between -1 and 1 for the x and y values and between -2 and 0 for the z values
-		boxPositions.push_back(glm::vec3(static_cast<float>(rand()) / RAND_MAX * 2.0f - 1.0f, static_cast<float>(rand()) / RAND_MAX * 2.0f - 1.0f, static_cast<float>(rand()) / RAND_MAX * 2.0f - 2.0f));
-		newBoxModel = glm::translate(newBoxModel, boxPositions[i]);
-		newBoxModel = glm::scale(newBoxModel, glm::vec3(0.0001f, 0.0001f, 0.0001f));
-
-		glm::vec4 transformedTempParticleMinBound = newBoxModel * glm::vec4(tempVertices[0].x, tempVertices[0].y, tempVertices[0].z, 1.0f);
-		glm::vec4 transformedTempParticleMaxBound = transformedTempParticleMinBound;
-
-		for (int j = 0; j < tempVertices.size(); j++)
-		{
-			glm::vec4 transformedVertex = newBoxModel * glm::vec4(tempVertices[j].x, tempVertices[j].y, tempVertices[j].z, 1.0f);
-			transformedTempParticleMinBound.x = std::min(transformedTempParticleMinBound.x, transformedVertex.x);
-			transformedTempParticleMinBound.y = std::min(transformedTempParticleMinBound.y, transformedVertex.y);
-			transformedTempParticleMinBound.z = std::min(transformedTempParticleMinBound.z, transformedVertex.z);
-
-			transformedTempParticleMaxBound.x = std::max(transformedTempParticleMaxBound.x, transformedVertex.x);
-			transformedTempParticleMaxBound.y = std::max(transformedTempParticleMaxBound.y, transformedVertex.y);
-			transformedTempParticleMaxBound.z = std::max(transformedTempParticleMaxBound.z, transformedVertex.z);
-		}
-
-		boxModels[i] = newBoxModel;
-
-		maximumBounds.push_back(Vec4ToVec3(transformedTempParticleMaxBound));
-		minimumBounds.push_back(Vec4ToVec3(transformedTempParticleMinBound));
-	}	
-
 	//OID means object ID
 	GLuint screenQuadVBOID;
 	glGenBuffers(1, &screenQuadVBOID);
@@ -446,12 +422,134 @@ int main(int argc, char ** argsv)
 	//SDL Event structure, this will be checked in the while loop
 	SDL_Event ev;
 
+	//Draw call counters so the instanced and non-instanced paths can be compared
+	unsigned int frameCount = 0;
+	unsigned long long totalDrawCalls = 0;
+
+	//Steps the simulation by real time instead of once per frame, so it runs at the same speed at any frame rate
+	FixedTimestep timestep(1.0 / stepRate, maxStepsPerFrame);
+	Uint64 lastFrameCounter = SDL_GetPerformanceCounter();
+	Uint64 firstFrameCounter = lastFrameCounter;
+
+	//Unless --serial is passed the simulation steps on its own thread from here on and the loop below only draws its snapshots
+	SimulationThread simulationThread(simulation, 1.0 / stepRate, maxStepsPerFrame);
+	if (tracePath)
+	{
+		GetProfiler().setThreadName("Render");
+		GetProfiler().setEnabled(true);
+	}
+	unsigned int lastCollisionCount = 0;
+	//Nothing is simulated or drawn except the empty frame until the crate has loaded
+	bool sceneReady = false;
+	bool assetLoadFailed = false;
+	bool assetsReported = false;
+	unsigned int lastDeletionCount = 0;
+	//Model matrix of every particle drawn without instancing, kept between frames so it does not reallocate
+	std::vector<glm::mat4> particleModels;
+
 	while (running) //functions as an update function
 	{
+		PROFILE_ZONE("Frame");
+		unsigned int frameDrawCalls = 0;
+
+		ProfileZone inputZone("Input");
 		while (SDL_PollEvent(&ev))
 		{
 			HandleInput(ev);
 		}
+		inputZone.end();
+
+		ProfileZone uploadZone("Upload");
+		assetQueue.processUploads(uploadBudgetMilliseconds);
+		uploadZone.end();
+
+		if (!sceneReady && assetQueue.getState(crateMesh.asset) == ASSET_FAILED)
+		{
+			//The import ran on a worker, so its error is only shown now that it is back on this thread
+			SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Model import failed", assetQueue.getError(crateMesh.asset).c_str(), NULL);
+			assetLoadFailed = true;
+			break;
+		}
+		if (!sceneReady && assetQueue.getState(crateMesh.asset) == ASSET_READY)
+		{
+			std::cout << "Loaded " << crateMesh.filePath << " in " << crateMesh.loadMilliseconds << " ms from " << (crateMesh.loadedFromCache ? "cache" : "import") << std::endl;
+			hasTexture = !crateMesh.texturePath.empty();
+			particleRenderer.init(VAO);
+
+			//Places the glass using the bounds the registry worked out when it loaded the mesh
+			glassPosition = glm::vec3(0, 0, 0.5);
+			glassScale = glm::vec3(0.01f, 0.01f, 0.001f);
+			simulation.setGlass(glassMesh.localBounds, glassPosition, glassScale);
+
+			//Every particle shares the crate mesh
+			simulation.setParticleBounds(crateMesh.localBounds);
+
+			//Printed so any run can be repeated, pass a different --seed to see different particles
+			std::cout << "Seed " << seed << std::endl;
+			simulation.setSeed(seed);
+			simulation.spawn(numOfBoxes);
+			if (emitRate > 0.0f) simulation.addEmitter(CreateSpawnEmitter(emitRate));
+
+			std::cout << "Scene ready after " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupTime).count()
+				<< " ms, " << frameCount << " frames drawn while loading" << std::endl;
+			if (!serialLoop) simulationThread.start();
+			sceneReady = true;
+			//The time spent loading is not simulated time
+			lastFrameCounter = SDL_GetPerformanceCounter();
+		}
+		if (!assetsReported && assetQueue.isFinished())
+		{
+			assetQueue.printReport(stdout);
+			assetsReported = true;
+		}
+
+		Uint64 frameCounter = SDL_GetPerformanceCounter();
+		double frameSeconds = static_cast<double>(frameCounter - lastFrameCounter) / SDL_GetPerformanceFrequency();
+		lastFrameCounter = frameCounter;
+
+		//Runs as many fixed steps as the time since the last frame covers, fast frames can run none
+		//The simulation adds its own Update, Bounds, Collision and Deletion zones inside each step
+		ProfileZone simulateZone("Simulate");
+		unsigned int numOfSteps = serialLoop && sceneReady ? timestep.advance(frameSeconds) : 0;
+		for (unsigned int step = 0; step < numOfSteps; step++)
+		{
+			//Moves the particles on by one step and checks them against the glass
+			simulation.step(timestep.getStepSeconds());
+
+			//Prints a debug message for each new collision, the simulation stops rendering the cube a set time after it hits the glass
+			for (unsigned int collidedCube : simulation.getNewCollisions())
+			{
+				std::cout << "Collision detected with cube " << collidedCube + 1 << std::endl;
+			}
+			for (uint32_t deletedCube : simulation.getNewDeletions())
+			{
+				std::cout << "Deletion delay elapsed for cube " << deletedCube + 1 << std::endl;
+			}
+		}
+		//Draws the particles part way between the last two steps so their movement stays smooth between steps
+		float interpolation = timestep.getInterpolation();
+
+		//Takes whatever the simulation thread published last, if it has not published anything new the previous snapshot is drawn again
+		simulationThread.acquireLatest();
+		const ParticleSnapshot& snapshot = simulationThread.getLatest();
+		if (!serialLoop)
+		{
+			//The snapshot is a step behind, so it blends towards its newest positions over the time one step takes
+			double secondsSincePublish = std::chrono::duration<double>(std::chrono::steady_clock::now() - snapshot.publishTime).count();
+			interpolation = static_cast<float>(glm::min(secondsSincePublish / simulationThread.getStepSeconds(), 1.0));
+
+			//Messages for every cube would come from the other thread, so the totals are printed when they change instead
+			if (snapshot.collisionCount != lastCollisionCount || snapshot.deletionCount != lastDeletionCount)
+			{
+				std::cout << "Collisions: " << snapshot.collisionCount << ", deletions: " << snapshot.deletionCount << std::endl;
+				lastCollisionCount = snapshot.collisionCount;
+				lastDeletionCount = snapshot.deletionCount;
+			}
+		}
+		simulateZone.end();
+
+		//Only times handing the work to the driver, the GPU catching up shows up in Swap
+		ProfileZone drawZone("Draw");
 
 		//use imported shader program(s)
 		glUseProgram(shaderProgram);
@@ -478,82 +576,75 @@ int main(int argc, char ** argsv)
 		//glm::ortho for orthographic
 		glassPlaneMVP = projection * view * glassModel;
 
-		//if there is a texture it disables the colour and lets the texture handle it
-		if (hasTexture) {
-			glUniform3f(objColourLoc, -1.0f, -1.0f, -1.0f);
-		}
-		//If you do not have a texture it uses white as the default
-		else {
-			glUniform3f(objColourLoc, 1.0f, 1.0f, 1.0f);
-		}
-
-		glBindVertexArray(VAO);
-		glUseProgram(shaderProgram);
-		if (image) glBindTexture(GL_TEXTURE_2D, textureID);
-
-		//For each item in numOfBoxes
-		for (int i = 0; i < numOfBoxes; i++)
+		//Until the crate has loaded there is nothing to draw but the background
+		if (sceneReady)
 		{
-			//Checks if the cube has been marked to be deleted before rendering
-			if (deleteChecker[i] == false)
-			{
-				particleMVP = projection * view * boxModels[i];
-				glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(particleMVP));
-				glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(boxModels[i]));
-				glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, (void*)0);
+			//if there is a texture it disables the colour and lets the texture handle it
+			if (hasTexture) {
+				glUniform3f(objColourLoc, -1.0f, -1.0f, -1.0f);
 			}
-			//Checks if the box has hit the glass, if it has it will not move it
-			if (collidedChecker[i] == false)
-			{
-				boxModels[i] = glm::translate(boxModels[i], glm::vec3(0.0f, 0.0f, 20.0f));
+			//If you do not have a texture it uses white as the default
+			else {
+				glUniform3f(objColourLoc, 1.0f, 1.0f, 1.0f);
 			}
-				
-			//Reset maximum and minimum bounds before setting them to make sure that collisions do not continue after cubes have moved past
-			minimumBounds[i] = glm::vec3(listOfVertices[0][0].x, listOfVertices[0][0].y, listOfVertices[0][0].z);
-			maximumBounds[i] = glm::vec3(-listOfVertices[0][0].x, -listOfVertices[0][0].y, -listOfVertices[0][0].z);
 
-			//Iterates through each cubes vertices
-			for (int j = 0; j < listOfVertices[i].size(); j++)
+			glBindVertexArray(VAO);
+			glUseProgram(shaderProgram);
+			if (crateTexture.textureID) glBindTexture(GL_TEXTURE_2D, crateTexture.textureID);
+
+			if (useInstancing)
 			{
-				//Calculates the bounds of each cube multiplied by its model matrix to account for scale, position and continuous movement
-				glm::vec4 transformedVertex = boxModels[i] * glm::vec4(listOfVertices[i][j].x, listOfVertices[i][j].y, listOfVertices[i][j].z, 1.0f);
-				minimumBounds[i].x = std::min(minimumBounds[i].x, transformedVertex.x);
-				minimumBounds[i].y = std::min(minimumBounds[i].y, transformedVertex.y);
-				minimumBounds[i].z = std::min(minimumBounds[i].z, transformedVertex.z);
-
-				maximumBounds[i].x = std::max(maximumBounds[i].x, transformedVertex.x);
-				maximumBounds[i].y = std::max(maximumBounds[i].y, transformedVertex.y);
-				maximumBounds[i].z = std::max(maximumBounds[i].z, transformedVertex.z);
+				//Sends every live particle to the GPU once and draws them all with one call
+				if (serialLoop) particleRenderer.upload(simulation.getParticles(), interpolation);
+				else particleRenderer.upload(snapshot, interpolation);
+				glm::mat4 viewProjection = projection * view;
+				glUniform1i(instancedLoc, 1);
+				glUniformMatrix4fv(viewProjectionLoc, 1, GL_FALSE, glm::value_ptr(viewProjection));
+				particleRenderer.draw(crateMesh.indices.size());
+				glUniform1i(instancedLoc, 0);
+				frameDrawCalls += particleRenderer.getDrawCalls();
 			}
-
-			//AABB collision check for each cube compared to the glass
-			if (
-				maximumBounds[i].x >= transformedGlassMinBound.x && minimumBounds[i].x <= transformedGlassMaxBound.x &&
-				maximumBounds[i].y >= transformedGlassMinBound.y && minimumBounds[i].y <= transformedGlassMaxBound.y &&
-				maximumBounds[i].z >= transformedGlassMinBound.z && minimumBounds[i].z <= transformedGlassMaxBound.z)
+			else
 			{
-				//Marks the first collision, prints debug message as well as stopping movement
-				if (collidedChecker[i] == false)
+				//One draw per cube, the models come from whichever source the instanced path would have uploaded
+				particleModels.clear();
+				if (serialLoop)
 				{
-					std::cout << "Collision detected with cube " << i + 1 << std::endl;
-					collidedChecker[i] = true;
-
-					//Stops rendering the cube a set time after it hits the glass
-					Delay(i);
+					for (unsigned int i = 0; i < simulation.getParticleCount(); i++)
+					{
+						//Checks if the cube has been marked to be deleted before rendering
+						if (simulation.isDeleted(i) == false) particleModels.push_back(simulation.getParticleModel(i, interpolation));
+					}
 				}
+				else
+				{
+					//The snapshot only holds the cubes that have not been deleted, as position and scale
+					for (size_t i = 0; i + 3 < snapshot.instances.size(); i += 4)
+					{
+						glm::vec3 previousPosition = glm::vec3(snapshot.previousInstances[i], snapshot.previousInstances[i + 1], snapshot.previousInstances[i + 2]);
+						glm::vec3 position = glm::vec3(snapshot.instances[i], snapshot.instances[i + 1], snapshot.instances[i + 2]);
+						glm::mat4 boxModel = glm::translate(glm::mat4(1.0f), glm::mix(previousPosition, position, interpolation));
+						particleModels.push_back(glm::scale(boxModel, glm::vec3(snapshot.instances[i + 3])));
+					}
+				}
+				frameDrawCalls += DrawParticleModels(particleModels, projection * view, transformLoc, modelLoc, crateMesh.indices.size());
 			}
+
+			//Draw glass pane
+			glUseProgram(transparentShader);
+			glassPlaneMVP = projection * view * glassModel;
+			glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(glassPlaneMVP));
+			glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(glassModel));
+			glBindVertexArray(VAO);
+			if (crateTexture.textureID) glBindTexture(GL_TEXTURE_2D, crateTexture.textureID);
+			glDrawElements(GL_TRIANGLES, glassMesh.indices.size(), GL_UNSIGNED_INT, (void*)0);
+			frameDrawCalls++;
 		}
 
-		//Draw glass pane
-		glUseProgram(transparentShader);
-		glassPlaneMVP = projection * view * glassModel;
-		glUniformMatrix4fv(transformLoc, 1, GL_FALSE, glm::value_ptr(glassPlaneMVP));
-		glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(glassModel));
-		glBindVertexArray(VAO);
-		if (image) glBindTexture(GL_TEXTURE_2D, textureID);
-		glDrawElements(GL_TRIANGLES, indices2.size(), GL_UNSIGNED_INT, (void*)0);
+		drawZone.end();
 
 		//render texture on quad
+		ProfileZone postProcessZone("PostProcess");
 		glBindFramebuffer(GL_FRAMEBUFFER, 0);
 		glClearColor(0.0f, 0.0f, 0.0f, 0.1f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -564,15 +655,64 @@ int main(int argc, char ** argsv)
 		glBindVertexArray(screenVAOID);
 		glBindTexture(GL_TEXTURE_2D, renderTextureID);
 		glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, (void*)0);
+		frameDrawCalls++;
+		postProcessZone.end();
+
+		ProfileZone swapZone("Swap");
 		SDL_GL_SwapWindow(window);
+		swapZone.end();
+
+		frameCount++;
+		totalDrawCalls += frameDrawCalls;
+		if (frameCount == 1)
+		{
+			//Only the shaders are loaded before this, the assets are still on their way
+			std::cout << "First frame after " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupTime).count() << " ms" << std::endl;
+		}
+		if (frameLimit > 0 && frameCount >= frameLimit) running = false;
+	}
+
+	//Stops the simulation thread before reading its totals
+	simulationThread.stop();
+
+	if (tracePath)
+	{
+		GetProfiler().setEnabled(false);
+		GetProfiler().printSummary(stdout);
+		if (GetProfiler().writeChromeTrace(tracePath)) std::cout << "Trace written to " << tracePath << std::endl;
+		else std::cout << "Could not write trace to " << tracePath << std::endl;
+	}
+
+	if (frameCount > 0)
+	{
+		std::cout << "Frames: " << frameCount << ", draw calls per frame: " << static_cast<double>(totalDrawCalls) / frameCount
+			<< (useInstancing ? " (instanced)" : " (one draw per particle)") << std::endl;
+
+		//Anything under 1 means frames took so long the simulation had to drop time to keep up
+		double wallSeconds = static_cast<double>(SDL_GetPerformanceCounter() - firstFrameCounter) / SDL_GetPerformanceFrequency();
+		std::cout << "Render: " << frameCount / wallSeconds << " frames/sec" << std::endl;
+		if (serialLoop)
+		{
+			std::cout << "Simulated " << timestep.getSimulatedSeconds() << " s in " << wallSeconds << " s (" << timestep.getSimulatedSeconds() / wallSeconds
+				<< " sim s/wall s), " << timestep.getStepCount() << " steps, " << timestep.getDroppedSeconds() << " s dropped" << std::endl;
+		}
+		else
+		{
+			//Each side is reported on its own, the simulation thread is busy for the fraction of the time it is not asleep waiting for the next step
+			double simulatedSeconds = simulationThread.getStepCount() * simulationThread.getStepSeconds();
+			std::cout << "Simulation thread: " << simulationThread.getStepCount() / wallSeconds << " steps/sec, " << simulatedSeconds / wallSeconds << " sim s/wall s, "
+				<< 100.0 * simulationThread.getBusySeconds() / wallSeconds << "% busy, " << simulationThread.getSkippedCount() << " snapshots never drawn" << std::endl;
+		}
 	}
 
-	//clear memory before exit
+	//clear memory before exit, a load can still be running if the loop ended early so the workers are stopped first
+	assetQueue.shutdown();
+	particleRenderer.destroy();
 	glDisableVertexAttribArray(0);
 	glDeleteBuffers(1, &VBO);
 	glDeleteVertexArrays(1, &VAO);
 
-	SDL_FreeSurface(image);
+	DestroyTexture(crateTexture);
 	SDL_GL_DeleteContext(glContext);
 
 	glDeleteProgram(shaderProgram);
@@ -583,6 +723,6 @@ int main(int argc, char ** argsv)
 	//https://wiki.libsdl.org/SDL_Quit
 	SDL_Quit();
 
-	return 0;
+	return assetLoadFailed ? 1 : 0;
 }
 
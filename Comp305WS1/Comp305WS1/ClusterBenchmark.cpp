@@ -0,0 +1,113 @@
+#include "ClusterBenchmark.h"
+#include "LightClusters.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+static float RandomRange(float minimum, float maximum)
+{
+	return minimum + static_cast<float>(rand()) / RAND_MAX * (maximum - minimum);
+}
+
+int RunClusterBenchmark(int argc, char** argv)
+{
+	int numOfLights = 10000;
+	unsigned int numOfRepeats = 100;
+	unsigned int numOfThreads = std::max(1u, std::thread::hardware_concurrency());
+	for (int i = 1; i < argc; i++)
+	{
+		bool hasValue = i + 1 < argc;
+		if (strcmp(argv[i], "--lights") == 0 && hasValue) numOfLights = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--repeats") == 0 && hasValue) numOfRepeats = strtoul(argv[++i], nullptr, 10);
+		else if (strcmp(argv[i], "--threads") == 0 && hasValue) numOfThreads = strtoul(argv[++i], nullptr, 10);
+	}
+	numOfLights = std::min(std::max(numOfLights, 0), LightBuffers::maxPointLights);
+	numOfRepeats = std::max(numOfRepeats, 1u);
+	numOfThreads = std::max(numOfThreads, 1u);
+
+	//Same camera and projection as the scene, with the lights spread through the space it looks at
+	glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 0.0f, 3.0f), glm::vec3(0.0f, 0.0f, 2.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	srand(1);
+	std::vector<PointLightData> lights(numOfLights);
+	for (int i = 0; i < numOfLights; i++)
+	{
+		PointLightData& light = lights[i];
+		light.position = glm::vec3(RandomRange(-60.0f, 60.0f), RandomRange(-30.0f, 30.0f), RandomRange(-100.0f, 5.0f));
+		light.diffuse = glm::vec3(RandomRange(0.2f, 1.0f), RandomRange(0.2f, 1.0f), RandomRange(0.2f, 1.0f));
+		light.ambient = light.diffuse * 0.05f;
+		light.specular = light.diffuse;
+		//Picks how far the light reaches, 2 to 8 units, and works out the falloff that fades it out there
+		float reach = RandomRange(2.0f, 8.0f);
+		float brightest = std::max(light.diffuse.x, std::max(light.diffuse.y, light.diffuse.z));
+		light.constant = 1.0f;
+		light.linear = 0.1f;
+		light.quadratic = (brightest * 256.0f / 5.0f - light.constant - light.linear * reach) / (reach * reach);
+		light.radius = CalculateLightRadius(light);
+	}
+
+	struct Run
+	{
+		const char* name;
+		bool useSimd;
+		unsigned int threads;
+	};
+	const Run runs[] = { { "scalar", false, 1 }, { "sse2", true, 1 }, { "sse2", true, numOfThreads } };
+
+	printf("%d lights, %d clusters (%dx%dx%d), %u repeats\n", numOfLights, LightClusters::clusterCount, LightClusters::tilesX, LightClusters::tilesY, LightClusters::slicesZ, numOfRepeats);
+	printf("%8s %8s %12s %14s %10s\n", "binning", "threads", "ms/build", "Mlights/sec", "speedup");
+
+	std::vector<ClusterRange> scalarRanges;
+	std::vector<uint16_t> scalarIndices;
+	double scalarMilliseconds = 0.0;
+	for (size_t run = 0; run < sizeof(runs) / sizeof(runs[0]); run++)
+	{
+		LightClusters clusters(runs[run].threads);
+		clusters.setUseSimd(runs[run].useSimd);
+		//First build sizes every buffer, so it is left out of the timing
+		clusters.build(view, lights.data(), numOfLights);
+
+		auto startTime = std::chrono::steady_clock::now();
+		for (unsigned int repeat = 0; repeat < numOfRepeats; repeat++)
+		{
+			clusters.build(view, lights.data(), numOfLights);
+		}
+		double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count() / numOfRepeats;
+
+		const std::vector<ClusterRange>& ranges = clusters.getRanges();
+		const std::vector<uint16_t>& indices = clusters.getLightIndices();
+		if (run == 0)
+		{
+			scalarRanges = ranges;
+			scalarIndices = indices;
+			scalarMilliseconds = milliseconds;
+
+			//Every cluster a fragment can land in, weighted the same, against the whole list the old shader looped over
+			size_t busiestCluster = 0, usedClusters = 0;
+			for (size_t cluster = 0; cluster < ranges.size(); cluster++)
+			{
+				busiestCluster = std::max<size_t>(busiestCluster, ranges[cluster].count);
+				if (ranges[cluster].count) usedClusters++;
+			}
+			printf("%u lights in view, %zu light indices, %zu clusters lit, %zu lights in the busiest cluster, %u dropped from full clusters\n",
+				clusters.getVisibleCount(), indices.size(), usedClusters, busiestCluster, clusters.getDroppedCount());
+			printf("A fragment shades %.1f lights on average instead of %d\n", static_cast<double>(indices.size()) / ranges.size(), numOfLights);
+		}
+		else if (ranges.size() != scalarRanges.size() || indices != scalarIndices ||
+			memcmp(ranges.data(), scalarRanges.data(), ranges.size() * sizeof(ClusterRange)) != 0)
+		{
+			printf("%s on %u threads binned the lights differently to the scalar loop\n", runs[run].name, runs[run].threads);
+			return 1;
+		}
+
+		printf("%8s %8u %12.3f %14.2f %9.2fx\n", runs[run].name, runs[run].threads, milliseconds, numOfLights / milliseconds / 1000.0, scalarMilliseconds / milliseconds);
+	}
+
+	return 0;
+}
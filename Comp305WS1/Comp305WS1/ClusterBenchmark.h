@@ -0,0 +1,9 @@
+#pragma once
+
+/// <summary>
+/// Bins --lights point lights (10k by default) scattered through the view into clusters, --repeats times each
+/// with the scalar loop on one thread, SSE2 on one thread and SSE2 on --threads threads (every core by default)
+/// Reports the time per build and how many lights a fragment shades, and returns 1 if any way of binning disagrees with the scalar loop
+/// Needs no window or GL context, run with --bench clusters
+/// </summary>
+int RunClusterBenchmark(int argc, char** argv);
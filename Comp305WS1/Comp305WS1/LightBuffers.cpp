@@ -0,0 +1,165 @@
+#include "LightBuffers.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+static float MaxComponent(const glm::vec3& colour)
+{
+	return std::max(colour.x, std::max(colour.y, colour.z));
+}
+
+float CalculateLightRadius(const PointLightData& light)
+{
+	float brightest = std::max(MaxComponent(light.ambient), std::max(MaxComponent(light.diffuse), MaxComponent(light.specular)));
+	//Attenuation the brightest colour has to be divided by to drop under 5/256
+	float cutoff = brightest * 256.0f / 5.0f;
+	if (light.constant >= cutoff) return 0.0f;
+
+	//Solves constant + linear * d + quadratic * d * d = cutoff
+	if (light.quadratic > 0.0f)
+	{
+		float discriminant = light.linear * light.linear - 4.0f * light.quadratic * (light.constant - cutoff);
+		return (-light.linear + std::sqrt(discriminant)) / (2.0f * light.quadratic);
+	}
+	if (light.linear > 0.0f) return (cutoff - light.constant) / light.linear;
+	//No falloff, it lights everything
+	return std::numeric_limits<float>::max();
+}
+
+LightBuffers::LightBuffers()
+	: m_DirLight(), m_DirLightBuffer(0), m_PointLightBuffer(0), m_PointLightTexture(0), m_DirLightDirty(true), m_FirstDirtyLight(0), m_EndDirtyLight(0)
+{
+	m_PointLights.reserve(maxPointLights);
+}
+
+LightBuffers::~LightBuffers()
+{
+	destroy();
+}
+
+void LightBuffers::create()
+{
+	destroy();
+
+	glGenBuffers(1, &m_DirLightBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_DirLightBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(DirLightData), nullptr, GL_DYNAMIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, dirLightBindingPoint, m_DirLightBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	//Making the texture binds it to the active unit, so whatever was bound there is put back afterwards
+	GLint previousTexture = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_BUFFER, &previousTexture);
+
+	//Sized for every light up front so adding lights never reallocates the buffer
+	glGenBuffers(1, &m_PointLightBuffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, m_PointLightBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, maxPointLights * sizeof(PointLightData), nullptr, GL_DYNAMIC_DRAW);
+	glGenTextures(1, &m_PointLightTexture);
+	glBindTexture(GL_TEXTURE_BUFFER, m_PointLightTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, m_PointLightBuffer);
+	glBindTexture(GL_TEXTURE_BUFFER, previousTexture);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	//New buffers start empty, so everything goes up on the next upload
+	m_DirLightDirty = true;
+	m_FirstDirtyLight = 0;
+	m_EndDirtyLight = getPointLightCount();
+}
+
+void LightBuffers::destroy()
+{
+	if (m_DirLightBuffer) glDeleteBuffers(1, &m_DirLightBuffer);
+	if (m_PointLightBuffer) glDeleteBuffers(1, &m_PointLightBuffer);
+	if (m_PointLightTexture) glDeleteTextures(1, &m_PointLightTexture);
+	m_DirLightBuffer = 0;
+	m_PointLightBuffer = 0;
+	m_PointLightTexture = 0;
+}
+
+void LightBuffers::setDirLight(const DirLightData& light)
+{
+	if (memcmp(&m_DirLight, &light, sizeof(light)) == 0) return;
+	m_DirLight = light;
+	m_DirLightDirty = true;
+}
+
+int LightBuffers::addPointLight(const PointLightData& light)
+{
+	if (getPointLightCount() >= maxPointLights) return -1;
+	m_PointLights.push_back(light);
+	m_PointLights.back().radius = CalculateLightRadius(light);
+	markPointLightDirty(getPointLightCount() - 1);
+	return getPointLightCount() - 1;
+}
+
+void LightBuffers::setPointLight(int index, const PointLightData& light)
+{
+	PointLightData newLight = light;
+	newLight.radius = CalculateLightRadius(light);
+	if (memcmp(&m_PointLights[index], &newLight, sizeof(newLight)) == 0) return;
+	m_PointLights[index] = newLight;
+	markPointLightDirty(index);
+}
+
+void LightBuffers::setPointLightPosition(int index, const glm::vec3& position)
+{
+	if (m_PointLights[index].position == position) return;
+	m_PointLights[index].position = position;
+	markPointLightDirty(index);
+}
+
+void LightBuffers::clearPointLights()
+{
+	if (m_PointLights.empty()) return;
+	m_PointLights.clear();
+	m_FirstDirtyLight = m_EndDirtyLight = 0;
+}
+
+void LightBuffers::markPointLightDirty(int index)
+{
+	if (m_FirstDirtyLight == m_EndDirtyLight)
+	{
+		m_FirstDirtyLight = index;
+		m_EndDirtyLight = index + 1;
+		return;
+	}
+	m_FirstDirtyLight = std::min(m_FirstDirtyLight, index);
+	m_EndDirtyLight = std::max(m_EndDirtyLight, index + 1);
+}
+
+unsigned int LightBuffers::upload()
+{
+	unsigned int uploads = 0;
+
+	if (m_DirLightDirty)
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, m_DirLightBuffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(DirLightData), &m_DirLight);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		m_DirLightDirty = false;
+		uploads++;
+	}
+
+	//Lights past the end can be left dirty by a clear, only the ones still in use get sent
+	m_EndDirtyLight = std::min(m_EndDirtyLight, getPointLightCount());
+	if (m_FirstDirtyLight < m_EndDirtyLight)
+	{
+		glBindBuffer(GL_TEXTURE_BUFFER, m_PointLightBuffer);
+		glBufferSubData(GL_TEXTURE_BUFFER, m_FirstDirtyLight * sizeof(PointLightData),
+			(m_EndDirtyLight - m_FirstDirtyLight) * sizeof(PointLightData), &m_PointLights[m_FirstDirtyLight]);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+		uploads++;
+	}
+	m_FirstDirtyLight = m_EndDirtyLight = 0;
+
+	return uploads;
+}
+
+void LightBuffers::bindPointLightTexture(GLuint textureUnit) const
+{
+	glActiveTexture(GL_TEXTURE0 + textureUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, m_PointLightTexture);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+/// <summary>
+/// DirLight as it sits in DirLightBlock, std140 pads every vec3 out to 16 bytes
+/// </summary>
+struct DirLightData
+{
+	glm::vec4 direction;
+	glm::vec4 ambient;
+	glm::vec4 diffuse;
+	glm::vec4 specular;
+};
+
+/// <summary>
+/// PointLight as it sits in the pointLightData texture buffer, four RGBA32F texels with a float after each vec3
+/// </summary>
+struct PointLightData
+{
+	glm::vec3 position;
+	float constant;
+	glm::vec3 ambient;
+	float linear;
+	glm::vec3 diffuse;
+	float quadratic;
+	glm::vec3 specular;
+	//Filled in by LightBuffers from the attenuation, see CalculateLightRadius
+	float radius;
+};
+
+static_assert(sizeof(DirLightData) == 64, "DirLightData has to match the std140 layout of DirLightBlock");
+static_assert(sizeof(PointLightData) == 64, "PointLightData has to match the four texels GetPointLight reads");
+
+/// <summary>
+/// Distance where the light's attenuation brings its brightest colour below 5/256, close enough to black that it can stop there
+/// </summary>
+float CalculateLightRadius(const PointLightData& light);
+
+/// <summary>
+/// Keeps the lights of LightFragShader.glsl on the GPU and only sends the parts that changed
+/// The directional light is a uniform block, the point lights a texture buffer that LightClusters indexes into
+/// </summary>
+class LightBuffers
+{
+public:
+	//Binding point the shaders' DirLightBlock is attached to
+	static const GLuint dirLightBindingPoint = 0;
+	//4 texels a light fills the 65536 texel texture buffer every GL 3.3 driver allows, and keeps light indices within 16 bits
+	static const int maxPointLights = 16384;
+
+	LightBuffers();
+	~LightBuffers();
+
+	LightBuffers(const LightBuffers&) = delete;
+	LightBuffers& operator=(const LightBuffers&) = delete;
+
+	/// <summary>
+	/// Makes both buffers and attaches the directional light to its binding point
+	/// </summary>
+	void create();
+	void destroy();
+
+	void setDirLight(const DirLightData& light);
+
+	/// <summary>
+	/// Adds a light after the existing ones and returns its index, -1 once maxPointLights are in use
+	/// The radius is worked out here, whatever the light had in it is ignored
+	/// </summary>
+	int addPointLight(const PointLightData& light);
+	void setPointLight(int index, const PointLightData& light);
+	void setPointLightPosition(int index, const glm::vec3& position);
+	void clearPointLights();
+
+	const PointLightData& getPointLight(int index) const { return m_PointLights[index]; }
+	const PointLightData* getPointLights() const { return m_PointLights.data(); }
+	int getPointLightCount() const { return static_cast<int>(m_PointLights.size()); }
+
+	/// <summary>
+	/// Sends whatever changed since the last call, the changed point lights go up as one range
+	/// Returns the number of glBufferSubData calls, 0 when nothing changed
+	/// </summary>
+	unsigned int upload();
+
+	/// <summary>
+	/// Binds the point light texture buffer to a texture unit for the shader's pointLightData sampler
+	/// </summary>
+	void bindPointLightTexture(GLuint textureUnit) const;
+
+private:
+	void markPointLightDirty(int index);
+
+	DirLightData m_DirLight;
+	std::vector<PointLightData> m_PointLights;
+
+	GLuint m_DirLightBuffer;
+	GLuint m_PointLightBuffer;
+	GLuint m_PointLightTexture;
+
+	bool m_DirLightDirty;
+	//Range of point lights that changed, empty when m_FirstDirtyLight == m_EndDirtyLight
+	int m_FirstDirtyLight;
+	int m_EndDirtyLight;
+};
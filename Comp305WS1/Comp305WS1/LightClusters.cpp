@@ -0,0 +1,471 @@
+#include "LightClusters.h"
+
+#include <algorithm>
+#include <cmath>
+
+//SSE2 is always there on x86-64, anything else bins with the scalar loop
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LIGHT_CLUSTERS_SSE 1
+#endif
+
+//Below this many lights a thread costs more to wake than it saves
+static const int minLightsPerThread = 256;
+
+//Normalised device x or y to the tile it falls in, clamped to the grid
+static int ToTile(float ndc, int numOfTiles)
+{
+	float tile = (ndc * 0.5f + 0.5f) * numOfTiles;
+	tile = std::min(std::max(tile, 0.0f), static_cast<float>(numOfTiles - 1));
+	return static_cast<int>(tile);
+}
+
+static int ClusterIndex(int x, int y, int z)
+{
+	return x + LightClusters::tilesX * (y + LightClusters::tilesY * z);
+}
+
+LightClusters::LightClusters(unsigned int threadCount)
+	: m_NearPlane(0.1f), m_FarPlane(100.0f), m_ProjectionScaleX(1.0f), m_ProjectionScaleY(1.0f), m_SliceScale(0.0f), m_SliceBias(0.0f),
+	m_ViewportWidth(800), m_ViewportHeight(600), m_UseSimd(true), m_VisibleCount(0), m_DroppedCount(0),
+	m_ClusterBlockBuffer(0), m_RangeBuffer(0), m_RangeTexture(0), m_IndexBuffer(0), m_IndexTexture(0), m_IndexCapacity(0),
+	m_MaxLightIndices(static_cast<size_t>(clusterCount) * maxLightsPerCluster), m_ClusterBlockDirty(true),
+	m_Job(nullptr), m_JobThreads(0), m_ThreadsRemaining(0), m_Generation(0), m_Quit(false)
+{
+	m_ThreadCount = threadCount ? threadCount : std::max(1u, std::thread::hardware_concurrency());
+	m_ThreadCounts.resize(static_cast<size_t>(m_ThreadCount) * clusterCount);
+	m_ThreadCursors.resize(m_ThreadCounts.size());
+	m_ThreadEnds.resize(m_ThreadCounts.size());
+	m_ThreadVisibleCounts.resize(m_ThreadCount);
+	ClusterRange emptyRange = {};
+	m_Ranges.assign(clusterCount, emptyRange);
+	setProjection(glm::radians(45.0f), 800.0f / 600.0f, m_NearPlane, m_FarPlane);
+
+	for (unsigned int i = 1; i < m_ThreadCount; i++)
+	{
+		m_Workers.push_back(std::thread(&LightClusters::workerLoop, this, i));
+	}
+}
+
+LightClusters::~LightClusters()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_WakeMutex);
+		m_Quit = true;
+	}
+	m_WakeCondition.notify_all();
+	for (size_t i = 0; i < m_Workers.size(); i++)
+	{
+		m_Workers[i].join();
+	}
+	destroy();
+}
+
+void LightClusters::create()
+{
+	destroy();
+
+	glGenBuffers(1, &m_ClusterBlockBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, m_ClusterBlockBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(ClusterBlockData), nullptr, GL_DYNAMIC_DRAW);
+	glBindBufferBase(GL_UNIFORM_BUFFER, clusterBindingPoint, m_ClusterBlockBuffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	//Making the textures binds them to the active unit, so whatever was bound there is put back afterwards
+	GLint previousTexture = 0;
+	glGetIntegerv(GL_TEXTURE_BINDING_BUFFER, &previousTexture);
+
+	//Every cluster has a range every frame, so this one never changes size
+	glGenBuffers(1, &m_RangeBuffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, m_RangeBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, clusterCount * sizeof(ClusterRange), nullptr, GL_STREAM_DRAW);
+	glGenTextures(1, &m_RangeTexture);
+	glBindTexture(GL_TEXTURE_BUFFER, m_RangeTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RG32UI, m_RangeBuffer);
+
+	//Starts with room for a few lights a cluster and grows when a build needs more
+	m_IndexCapacity = clusterCount * 16;
+	glGenBuffers(1, &m_IndexBuffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, m_IndexBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, m_IndexCapacity * sizeof(uint16_t), nullptr, GL_STREAM_DRAW);
+	glGenTextures(1, &m_IndexTexture);
+	glBindTexture(GL_TEXTURE_BUFFER, m_IndexTexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_R16UI, m_IndexBuffer);
+	glBindTexture(GL_TEXTURE_BUFFER, previousTexture);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	//GL 3.3 only promises 65536 texels in a texture buffer, plenty of drivers allow far more
+	GLint maxTexels = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+	m_MaxLightIndices = std::min(static_cast<size_t>(clusterCount) * maxLightsPerCluster, static_cast<size_t>(maxTexels));
+
+	m_ClusterBlockDirty = true;
+}
+
+void LightClusters::destroy()
+{
+	if (m_ClusterBlockBuffer) glDeleteBuffers(1, &m_ClusterBlockBuffer);
+	if (m_RangeBuffer) glDeleteBuffers(1, &m_RangeBuffer);
+	if (m_RangeTexture) glDeleteTextures(1, &m_RangeTexture);
+	if (m_IndexBuffer) glDeleteBuffers(1, &m_IndexBuffer);
+	if (m_IndexTexture) glDeleteTextures(1, &m_IndexTexture);
+	m_ClusterBlockBuffer = 0;
+	m_RangeBuffer = m_RangeTexture = 0;
+	m_IndexBuffer = m_IndexTexture = 0;
+	m_IndexCapacity = 0;
+}
+
+void LightClusters::setProjection(float fovY, float aspect, float nearPlane, float farPlane)
+{
+	float scaleY = 1.0f / std::tan(fovY * 0.5f);
+	float scaleX = scaleY / aspect;
+	//Slices get deeper further away, so each one covers about as much of the screen's depth precision as the last
+	float sliceScale = slicesZ / std::log(farPlane / nearPlane);
+	float sliceBias = -sliceScale * std::log(nearPlane);
+	if (scaleX == m_ProjectionScaleX && scaleY == m_ProjectionScaleY && nearPlane == m_NearPlane && farPlane == m_FarPlane && sliceScale == m_SliceScale) return;
+
+	m_ProjectionScaleX = scaleX;
+	m_ProjectionScaleY = scaleY;
+	m_NearPlane = nearPlane;
+	m_FarPlane = farPlane;
+	m_SliceScale = sliceScale;
+	m_SliceBias = sliceBias;
+	for (int slice = 1; slice < slicesZ; slice++)
+	{
+		m_SliceStarts[slice - 1] = std::exp((slice - sliceBias) / sliceScale);
+	}
+	m_ClusterBlockDirty = true;
+}
+
+void LightClusters::setViewport(int width, int height)
+{
+	if (width == m_ViewportWidth && height == m_ViewportHeight) return;
+	m_ViewportWidth = width;
+	m_ViewportHeight = height;
+	m_ClusterBlockDirty = true;
+}
+
+int LightClusters::findSlice(float depth) const
+{
+	return static_cast<int>(std::upper_bound(m_SliceStarts, m_SliceStarts + slicesZ - 1, depth) - m_SliceStarts);
+}
+
+void LightClusters::setBounds(int light, bool visible, const int tiles[6])
+{
+	LightBounds& bounds = m_Bounds[light];
+	if (!visible)
+	{
+		bounds.minimumX = 1;
+		bounds.maximumX = 0;
+		return;
+	}
+	bounds.minimumX = static_cast<uint8_t>(tiles[0]);
+	bounds.maximumX = static_cast<uint8_t>(tiles[1]);
+	bounds.minimumY = static_cast<uint8_t>(tiles[2]);
+	bounds.maximumY = static_cast<uint8_t>(tiles[3]);
+	bounds.minimumZ = static_cast<uint8_t>(tiles[4]);
+	bounds.maximumZ = static_cast<uint8_t>(tiles[5]);
+}
+
+void LightClusters::boundLightsScalar(const glm::mat4& view, const PointLightData* lights, int begin, int end)
+{
+	for (int i = begin; i < end; i++)
+	{
+		const glm::vec3& position = lights[i].position;
+		float radius = lights[i].radius;
+		float x = view[0][0] * position.x + view[1][0] * position.y + view[2][0] * position.z + view[3][0];
+		float y = view[0][1] * position.x + view[1][1] * position.y + view[2][1] * position.z + view[3][1];
+		float depth = -(view[0][2] * position.x + view[1][2] * position.y + view[2][2] * position.z + view[3][2]);
+
+		bool visible = depth + radius > m_NearPlane && depth - radius < m_FarPlane;
+		float nearestDepth = std::max(depth - radius, m_NearPlane);
+		float furthestDepth = std::min(depth + radius, m_FarPlane);
+
+		//Each side of the box around the light reaches furthest across the screen at whichever end of its depth range is further from the centre
+		float left = x - radius, right = x + radius, bottom = y - radius, top = y + radius;
+		float minimumX = m_ProjectionScaleX * (left < 0.0f ? left / nearestDepth : left / furthestDepth);
+		float maximumX = m_ProjectionScaleX * (right > 0.0f ? right / nearestDepth : right / furthestDepth);
+		float minimumY = m_ProjectionScaleY * (bottom < 0.0f ? bottom / nearestDepth : bottom / furthestDepth);
+		float maximumY = m_ProjectionScaleY * (top > 0.0f ? top / nearestDepth : top / furthestDepth);
+		visible = visible && maximumX >= -1.0f && minimumX <= 1.0f && maximumY >= -1.0f && minimumY <= 1.0f;
+
+		int tiles[6] = { ToTile(minimumX, tilesX), ToTile(maximumX, tilesX), ToTile(minimumY, tilesY), ToTile(maximumY, tilesY), findSlice(nearestDepth), findSlice(furthestDepth) };
+		setBounds(i, visible, tiles);
+	}
+}
+
+#if defined(LIGHT_CLUSTERS_SSE)
+//(ndc * 0.5 + 0.5) * numOfTiles clamped to the grid, the same steps as ToTile so both loops agree exactly
+static __m128i ToTiles(__m128 ndc, int numOfTiles)
+{
+	__m128 half = _mm_set1_ps(0.5f);
+	__m128 tile = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(ndc, half), half), _mm_set1_ps(static_cast<float>(numOfTiles)));
+	tile = _mm_min_ps(_mm_max_ps(tile, _mm_setzero_ps()), _mm_set1_ps(static_cast<float>(numOfTiles - 1)));
+	return _mm_cvttps_epi32(tile);
+}
+
+//condition ? a : b for each lane, SSE2 has no blend
+static __m128 Select(__m128 condition, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(condition, a), _mm_andnot_ps(condition, b));
+}
+#endif
+
+void LightClusters::boundLightsSimd(const glm::mat4& view, const PointLightData* lights, int begin, int end)
+{
+	int i = begin;
+#if defined(LIGHT_CLUSTERS_SSE)
+	__m128 zero = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 minusOne = _mm_set1_ps(-1.0f);
+	__m128 nearPlane = _mm_set1_ps(m_NearPlane);
+	__m128 farPlane = _mm_set1_ps(m_FarPlane);
+	__m128 projectionScaleX = _mm_set1_ps(m_ProjectionScaleX);
+	__m128 projectionScaleY = _mm_set1_ps(m_ProjectionScaleY);
+	__m128 view00 = _mm_set1_ps(view[0][0]), view10 = _mm_set1_ps(view[1][0]), view20 = _mm_set1_ps(view[2][0]), view30 = _mm_set1_ps(view[3][0]);
+	__m128 view01 = _mm_set1_ps(view[0][1]), view11 = _mm_set1_ps(view[1][1]), view21 = _mm_set1_ps(view[2][1]), view31 = _mm_set1_ps(view[3][1]);
+	__m128 view02 = _mm_set1_ps(view[0][2]), view12 = _mm_set1_ps(view[1][2]), view22 = _mm_set1_ps(view[2][2]), view32 = _mm_set1_ps(view[3][2]);
+
+	for (; i + 4 <= end; i += 4)
+	{
+		//Each light is 16 floats, position and constant first, specular and radius last
+		const float* light = reinterpret_cast<const float*>(lights + i);
+		__m128 positionX = _mm_loadu_ps(light);
+		__m128 positionY = _mm_loadu_ps(light + 16);
+		__m128 positionZ = _mm_loadu_ps(light + 32);
+		__m128 constant = _mm_loadu_ps(light + 48);
+		_MM_TRANSPOSE4_PS(positionX, positionY, positionZ, constant);
+		__m128 specularR = _mm_loadu_ps(light + 12);
+		__m128 specularG = _mm_loadu_ps(light + 28);
+		__m128 specularB = _mm_loadu_ps(light + 44);
+		__m128 radius = _mm_loadu_ps(light + 60);
+		_MM_TRANSPOSE4_PS(specularR, specularG, specularB, radius);
+
+		__m128 x = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(view00, positionX), _mm_mul_ps(view10, positionY)), _mm_mul_ps(view20, positionZ)), view30);
+		__m128 y = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(view01, positionX), _mm_mul_ps(view11, positionY)), _mm_mul_ps(view21, positionZ)), view31);
+		__m128 depth = _mm_sub_ps(zero, _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(view02, positionX), _mm_mul_ps(view12, positionY)), _mm_mul_ps(view22, positionZ)), view32));
+
+		__m128 visible = _mm_and_ps(_mm_cmpgt_ps(_mm_add_ps(depth, radius), nearPlane), _mm_cmplt_ps(_mm_sub_ps(depth, radius), farPlane));
+		__m128 nearestDepth = _mm_max_ps(_mm_sub_ps(depth, radius), nearPlane);
+		__m128 furthestDepth = _mm_min_ps(_mm_add_ps(depth, radius), farPlane);
+
+		__m128 left = _mm_sub_ps(x, radius), right = _mm_add_ps(x, radius), bottom = _mm_sub_ps(y, radius), top = _mm_add_ps(y, radius);
+		__m128 minimumX = _mm_mul_ps(projectionScaleX, Select(_mm_cmplt_ps(left, zero), _mm_div_ps(left, nearestDepth), _mm_div_ps(left, furthestDepth)));
+		__m128 maximumX = _mm_mul_ps(projectionScaleX, Select(_mm_cmpgt_ps(right, zero), _mm_div_ps(right, nearestDepth), _mm_div_ps(right, furthestDepth)));
+		__m128 minimumY = _mm_mul_ps(projectionScaleY, Select(_mm_cmplt_ps(bottom, zero), _mm_div_ps(bottom, nearestDepth), _mm_div_ps(bottom, furthestDepth)));
+		__m128 maximumY = _mm_mul_ps(projectionScaleY, Select(_mm_cmpgt_ps(top, zero), _mm_div_ps(top, nearestDepth), _mm_div_ps(top, furthestDepth)));
+		visible = _mm_and_ps(visible, _mm_and_ps(_mm_cmpge_ps(maximumX, minusOne), _mm_cmple_ps(minimumX, one)));
+		visible = _mm_and_ps(visible, _mm_and_ps(_mm_cmpge_ps(maximumY, minusOne), _mm_cmple_ps(minimumY, one)));
+
+		//Counts the slice starts each depth has reached, a passed compare is all ones so subtracting it adds one
+		__m128i nearestSlice = _mm_setzero_si128();
+		__m128i furthestSlice = _mm_setzero_si128();
+		for (int slice = 0; slice < slicesZ - 1; slice++)
+		{
+			__m128 sliceStart = _mm_set1_ps(m_SliceStarts[slice]);
+			nearestSlice = _mm_sub_epi32(nearestSlice, _mm_castps_si128(_mm_cmpge_ps(nearestDepth, sliceStart)));
+			furthestSlice = _mm_sub_epi32(furthestSlice, _mm_castps_si128(_mm_cmpge_ps(furthestDepth, sliceStart)));
+		}
+
+		int tiles[6][4];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(tiles[0]), ToTiles(minimumX, tilesX));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(tiles[1]), ToTiles(maximumX, tilesX));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(tiles[2]), ToTiles(minimumY, tilesY));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(tiles[3]), ToTiles(maximumY, tilesY));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(tiles[4]), nearestSlice);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(tiles[5]), furthestSlice);
+		int visibleMask = _mm_movemask_ps(visible);
+
+		for (int lane = 0; lane < 4; lane++)
+		{
+			int laneTiles[6] = { tiles[0][lane], tiles[1][lane], tiles[2][lane], tiles[3][lane], tiles[4][lane], tiles[5][lane] };
+			setBounds(i + lane, (visibleMask >> lane) & 1, laneTiles);
+		}
+	}
+#endif
+	boundLightsScalar(view, lights, i, end);
+}
+
+void LightClusters::build(const glm::mat4& view, const PointLightData* lights, int numOfLights)
+{
+	m_Bounds.resize(numOfLights);
+	unsigned int numOfThreads = std::min(m_ThreadCount, static_cast<unsigned int>(std::max(1, numOfLights / minLightsPerThread)));
+
+	//Each thread bounds its share of the lights and counts how many land in each cluster
+	std::function<void(unsigned int)> boundAndCount = [&](unsigned int thread)
+	{
+		int begin = static_cast<int>(static_cast<long long>(numOfLights) * thread / numOfThreads);
+		int end = static_cast<int>(static_cast<long long>(numOfLights) * (thread + 1) / numOfThreads);
+		if (m_UseSimd) boundLightsSimd(view, lights, begin, end);
+		else boundLightsScalar(view, lights, begin, end);
+
+		uint32_t* counts = &m_ThreadCounts[static_cast<size_t>(thread) * clusterCount];
+		std::fill(counts, counts + clusterCount, 0u);
+		unsigned int visibleCount = 0;
+		for (int light = begin; light < end; light++)
+		{
+			const LightBounds& bounds = m_Bounds[light];
+			if (bounds.minimumX > bounds.maximumX) continue;
+			visibleCount++;
+			for (int z = bounds.minimumZ; z <= bounds.maximumZ; z++)
+			{
+				for (int y = bounds.minimumY; y <= bounds.maximumY; y++)
+				{
+					for (int x = bounds.minimumX; x <= bounds.maximumX; x++)
+					{
+						counts[ClusterIndex(x, y, z)]++;
+					}
+				}
+			}
+		}
+		m_ThreadVisibleCounts[thread] = visibleCount;
+	};
+	runOnThreads(numOfThreads, boundAndCount);
+
+	//Lays the clusters out one after another, each thread's lights after the threads before it so the lists come out in light order
+	//Full clusters and a full index list just stop taking lights
+	uint32_t total = 0;
+	m_DroppedCount = 0;
+	m_VisibleCount = 0;
+	for (int cluster = 0; cluster < clusterCount; cluster++)
+	{
+		uint32_t clusterTotal = 0;
+		for (unsigned int thread = 0; thread < numOfThreads; thread++)
+		{
+			size_t slot = static_cast<size_t>(thread) * clusterCount + cluster;
+			uint32_t count = m_ThreadCounts[slot];
+			uint32_t room = static_cast<uint32_t>(std::min<size_t>(maxLightsPerCluster - clusterTotal, m_MaxLightIndices - total - clusterTotal));
+			uint32_t kept = std::min(count, room);
+			m_ThreadCursors[slot] = total + clusterTotal;
+			m_ThreadEnds[slot] = total + clusterTotal + kept;
+			clusterTotal += kept;
+			m_DroppedCount += count - kept;
+		}
+		m_Ranges[cluster].offset = total;
+		m_Ranges[cluster].count = clusterTotal;
+		total += clusterTotal;
+	}
+	for (unsigned int thread = 0; thread < numOfThreads; thread++)
+	{
+		m_VisibleCount += m_ThreadVisibleCounts[thread];
+	}
+	m_LightIndices.resize(total);
+
+	//Then writes its lights into the places it was given
+	std::function<void(unsigned int)> scatter = [&](unsigned int thread)
+	{
+		int begin = static_cast<int>(static_cast<long long>(numOfLights) * thread / numOfThreads);
+		int end = static_cast<int>(static_cast<long long>(numOfLights) * (thread + 1) / numOfThreads);
+		uint32_t* cursors = &m_ThreadCursors[static_cast<size_t>(thread) * clusterCount];
+		const uint32_t* ends = &m_ThreadEnds[static_cast<size_t>(thread) * clusterCount];
+		for (int light = begin; light < end; light++)
+		{
+			const LightBounds& bounds = m_Bounds[light];
+			if (bounds.minimumX > bounds.maximumX) continue;
+			for (int z = bounds.minimumZ; z <= bounds.maximumZ; z++)
+			{
+				for (int y = bounds.minimumY; y <= bounds.maximumY; y++)
+				{
+					for (int x = bounds.minimumX; x <= bounds.maximumX; x++)
+					{
+						int cluster = ClusterIndex(x, y, z);
+						if (cursors[cluster] < ends[cluster]) m_LightIndices[cursors[cluster]++] = static_cast<uint16_t>(light);
+					}
+				}
+			}
+		}
+	};
+	runOnThreads(numOfThreads, scatter);
+}
+
+unsigned int LightClusters::upload()
+{
+	unsigned int uploads = 0;
+
+	if (m_ClusterBlockDirty)
+	{
+		ClusterBlockData block;
+		block.grid = glm::ivec4(tilesX, tilesY, slicesZ, 0);
+		block.scale = glm::vec4(static_cast<float>(tilesX) / m_ViewportWidth, static_cast<float>(tilesY) / m_ViewportHeight, m_SliceScale, m_SliceBias);
+		block.depth = glm::vec4(m_NearPlane, m_FarPlane, 0.0f, 0.0f);
+		glBindBuffer(GL_UNIFORM_BUFFER, m_ClusterBlockBuffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+		m_ClusterBlockDirty = false;
+		uploads++;
+	}
+
+	glBindBuffer(GL_TEXTURE_BUFFER, m_RangeBuffer);
+	glBufferSubData(GL_TEXTURE_BUFFER, 0, m_Ranges.size() * sizeof(ClusterRange), m_Ranges.data());
+	uploads++;
+
+	if (!m_LightIndices.empty())
+	{
+		glBindBuffer(GL_TEXTURE_BUFFER, m_IndexBuffer);
+		if (m_LightIndices.size() > m_IndexCapacity)
+		{
+			//The texture keeps pointing at the buffer, so it sees the new storage without being told
+			m_IndexCapacity = std::min(std::max(m_LightIndices.size(), m_IndexCapacity * 2), m_MaxLightIndices);
+			glBufferData(GL_TEXTURE_BUFFER, m_IndexCapacity * sizeof(uint16_t), nullptr, GL_STREAM_DRAW);
+		}
+		glBufferSubData(GL_TEXTURE_BUFFER, 0, m_LightIndices.size() * sizeof(uint16_t), m_LightIndices.data());
+		uploads++;
+	}
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	return uploads;
+}
+
+void LightClusters::bindTextures(GLuint rangeTextureUnit, GLuint indexTextureUnit) const
+{
+	glActiveTexture(GL_TEXTURE0 + rangeTextureUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, m_RangeTexture);
+	glActiveTexture(GL_TEXTURE0 + indexTextureUnit);
+	glBindTexture(GL_TEXTURE_BUFFER, m_IndexTexture);
+}
+
+void LightClusters::runOnThreads(unsigned int numOfThreads, const std::function<void(unsigned int)>& job)
+{
+	if (numOfThreads <= 1)
+	{
+		job(0);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_WakeMutex);
+		m_Job = &job;
+		m_JobThreads = numOfThreads;
+		m_ThreadsRemaining = numOfThreads - 1;
+		m_Generation++;
+	}
+	m_WakeCondition.notify_all();
+
+	job(0);
+
+	std::unique_lock<std::mutex> lock(m_WakeMutex);
+	m_DoneCondition.wait(lock, [this] { return m_ThreadsRemaining == 0; });
+}
+
+void LightClusters::workerLoop(unsigned int threadIndex)
+{
+	unsigned long long lastGeneration = 0;
+	for (;;)
+	{
+		const std::function<void(unsigned int)>* job;
+		{
+			std::unique_lock<std::mutex> lock(m_WakeMutex);
+			m_WakeCondition.wait(lock, [&] { return m_Quit || m_Generation != lastGeneration; });
+			if (m_Quit) return;
+			lastGeneration = m_Generation;
+			//Small builds only wake some of the threads
+			if (threadIndex >= m_JobThreads) continue;
+			job = m_Job;
+		}
+
+		(*job)(threadIndex);
+
+		std::lock_guard<std::mutex> lock(m_WakeMutex);
+		if (--m_ThreadsRemaining == 0) m_DoneCondition.notify_one();
+	}
+}
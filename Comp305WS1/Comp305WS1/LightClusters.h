@@ -0,0 +1,169 @@
+#pragma once
+
+#include "LightBuffers.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// Where one cluster's lights start in the index list and how many there are, one RG32UI texel of clusterLightRanges
+/// </summary>
+struct ClusterRange
+{
+	uint32_t offset;
+	uint32_t count;
+};
+
+/// <summary>
+/// ClusterBlock in LightFragShader.glsl, std140
+/// </summary>
+struct ClusterBlockData
+{
+	//Tiles across, tiles up, depth slices, unused
+	glm::ivec4 grid;
+	//Tiles per pixel across and up, then the scale and bias that turn log view depth into a slice
+	glm::vec4 scale;
+	//Near plane, far plane, unused, unused
+	glm::vec4 depth;
+};
+
+static_assert(sizeof(ClusterBlockData) == 48, "ClusterBlockData has to match the std140 layout of ClusterBlock");
+
+/// <summary>
+/// Splits the view frustum into a grid of clusters, screen tiles by exponential depth slices, and lists the point lights that reach into each
+/// The fragment shader finds its cluster and only shades those lights, so each fragment pays for the lights near it rather than every light
+/// Lights are binned by the box around their radius on the CPU, 4 at a time with SSE2 and split across worker threads
+/// </summary>
+class LightClusters
+{
+public:
+	static const int tilesX = 16;
+	static const int tilesY = 9;
+	static const int slicesZ = 24;
+	static const int clusterCount = tilesX * tilesY * slicesZ;
+	//Binding point the shaders' ClusterBlock is attached to
+	static const GLuint clusterBindingPoint = 1;
+	//Most lights one cluster lists, any more are left out of that cluster and counted by getDroppedCount
+	static const int maxLightsPerCluster = 256;
+
+	/// <summary>
+	/// threadCount includes the calling thread, 0 uses one thread per hardware core
+	/// </summary>
+	explicit LightClusters(unsigned int threadCount = 0);
+	~LightClusters();
+
+	LightClusters(const LightClusters&) = delete;
+	LightClusters& operator=(const LightClusters&) = delete;
+
+	/// <summary>
+	/// Makes the cluster block and the two texture buffers the shader reads the light lists from
+	/// </summary>
+	void create();
+	void destroy();
+
+	//Both have to match the projection and viewport the lit objects are drawn with
+	void setProjection(float fovY, float aspect, float nearPlane, float farPlane);
+	void setViewport(int width, int height);
+
+	/// <summary>
+	/// Off bins with the plain scalar loop, only useful to compare against
+	/// </summary>
+	void setUseSimd(bool useSimd) { m_UseSimd = useSimd; }
+
+	/// <summary>
+	/// Bins the lights into clusters for this view, lights are in world space like PointLightData
+	/// Only touches memory, so it can be run and timed without a GL context
+	/// </summary>
+	void build(const glm::mat4& view, const PointLightData* lights, int numOfLights);
+
+	/// <summary>
+	/// Sends the cluster block if the projection or viewport changed, and the light lists from the last build
+	/// Returns the number of buffer uploads
+	/// </summary>
+	unsigned int upload();
+
+	/// <summary>
+	/// Binds the texture buffers for the shader's clusterLightRanges and clusterLightIndices samplers
+	/// </summary>
+	void bindTextures(GLuint rangeTextureUnit, GLuint indexTextureUnit) const;
+
+	const std::vector<ClusterRange>& getRanges() const { return m_Ranges; }
+	const std::vector<uint16_t>& getLightIndices() const { return m_LightIndices; }
+	//Lights that were within the view, and how many times a light was left out of a full cluster
+	unsigned int getVisibleCount() const { return m_VisibleCount; }
+	unsigned int getDroppedCount() const { return m_DroppedCount; }
+	unsigned int getThreadCount() const { return m_ThreadCount; }
+
+private:
+	/// <summary>
+	/// Clusters a light's box covers, inclusive, empty when minimumX > maximumX
+	/// </summary>
+	struct LightBounds
+	{
+		uint8_t minimumX, maximumX;
+		uint8_t minimumY, maximumY;
+		uint8_t minimumZ, maximumZ;
+	};
+
+	void boundLightsScalar(const glm::mat4& view, const PointLightData* lights, int begin, int end);
+	void boundLightsSimd(const glm::mat4& view, const PointLightData* lights, int begin, int end);
+	/// <summary>
+	/// Slice a view depth falls in, found by counting the slice starts it has passed, which agrees with the log the shader uses
+	/// </summary>
+	int findSlice(float depth) const;
+	/// <summary>
+	/// Stores the clusters a light covers, tiles are the first and last tile across, up and in depth
+	/// </summary>
+	void setBounds(int light, bool visible, const int tiles[6]);
+
+	/// <summary>
+	/// Runs job(threadIndex) on the first numOfThreads threads, the calling thread being 0, and returns once they all have
+	/// </summary>
+	void runOnThreads(unsigned int numOfThreads, const std::function<void(unsigned int)>& job);
+	void workerLoop(unsigned int threadIndex);
+
+	float m_NearPlane, m_FarPlane;
+	//Projection matrix scale for x and y, view space x / depth times this is normalised device x
+	float m_ProjectionScaleX, m_ProjectionScaleY;
+	float m_SliceScale, m_SliceBias;
+	//View depth each slice after the first starts at, so binning needs no log
+	float m_SliceStarts[slicesZ - 1];
+	int m_ViewportWidth, m_ViewportHeight;
+	bool m_UseSimd;
+
+	std::vector<LightBounds> m_Bounds;
+	//Lights each thread counted into each cluster, then where each thread writes its lights for each cluster and where it has to stop
+	std::vector<uint32_t> m_ThreadCounts;
+	std::vector<uint32_t> m_ThreadCursors;
+	std::vector<uint32_t> m_ThreadEnds;
+	std::vector<ClusterRange> m_Ranges;
+	std::vector<uint16_t> m_LightIndices;
+	std::vector<unsigned int> m_ThreadVisibleCounts;
+	unsigned int m_VisibleCount;
+	unsigned int m_DroppedCount;
+
+	GLuint m_ClusterBlockBuffer;
+	GLuint m_RangeBuffer, m_RangeTexture;
+	GLuint m_IndexBuffer, m_IndexTexture;
+	//Indices the index buffer has room for, it only grows
+	size_t m_IndexCapacity;
+	//Most indices one build writes, lowered by create to what the driver allows in a texture buffer
+	size_t m_MaxLightIndices;
+	bool m_ClusterBlockDirty;
+
+	unsigned int m_ThreadCount;
+	std::vector<std::thread> m_Workers;
+	//Workers sleep on this until runOnThreads bumps the generation
+	std::mutex m_WakeMutex;
+	std::condition_variable m_WakeCondition;
+	std::condition_variable m_DoneCondition;
+	const std::function<void(unsigned int)>* m_Job;
+	unsigned int m_JobThreads;
+	unsigned int m_ThreadsRemaining;
+	unsigned long long m_Generation;
+	bool m_Quit;
+};
@@ -13,6 +13,7 @@ struct Material {
 uniform Material material;
 
 //Directional struct controls diretional light
+//Lives in a std140 uniform block, so every vec3 takes up 16 bytes and the C++ side mirrors it with vec4s
 struct DirLight{
     vec3 direction;
     
@@ -21,23 +22,43 @@ struct DirLight{
     vec3 specular;
 };
 
-uniform DirLight dirLight;
+layout (std140) uniform DirLightBlock
+{
+    DirLight dirLight;
+};
 
+//Laid out like PointLightData, each line is one RGBA32F texel of pointLightData
 struct PointLight {
     vec3 position;
-
     float constant;
-    float linear;
-    float quadratic;
 
     vec3 ambient;
+    float linear;
     vec3 diffuse;
+    float quadratic;
     vec3 specular;
+    //Distance where the light has faded below 5/256 of its brightness, it is skipped past this
+    float radius;
+};
+//Every point light, 4 texels each, a texture buffer so the scene can have thousands rather than what fits in a uniform block
+uniform samplerBuffer pointLightData;
+
+//The view is split into clusters, tiles across the screen and slices along the depth
+//Each cluster lists only the lights that reach into it, so a fragment skips every light that cannot touch it
+//Offset and count of each cluster's lights in clusterLightIndices
+uniform usamplerBuffer clusterLightRanges;
+uniform usamplerBuffer clusterLightIndices;
+
+//Matches ClusterBlockData in LightClusters.h
+layout (std140) uniform ClusterBlock
+{
+    //Tiles across, tiles up, depth slices
+    ivec4 clusterGrid;
+    //Tiles per pixel across and up, then the scale and bias that turn log depth into a slice
+    vec4 clusterScale;
+    //Near and far planes of the projection
+    vec4 clusterDepth;
 };
-//Defines how many point lights we want
-#define NR_POINT_LIGHTS 4
-//Creats an array of point lights using the number of point lights specified
-uniform PointLight pointLights[NR_POINT_LIGHTS];
 
 //Get the normals of the cube
 in vec3 Normal;
@@ -52,6 +73,8 @@ uniform vec3 viewPos;
 // function prototypes
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+PointLight GetPointLight(int index);
+int GetCluster();
 
 void main()
 {
@@ -62,11 +85,13 @@ void main()
     vec3 result = CalcDirLight(dirLight, norm, viewDir);
 
     //Add point lights to the result
-    //For each point light to render
-    for (int i = 0; i < NR_POINT_LIGHTS; i++)
+    //Only the lights in this fragment's cluster are looked at
+    uvec2 lightRange = texelFetch(clusterLightRanges, GetCluster()).xy;
+    for (uint i = 0u; i < lightRange.y; i++)
     {
+        int lightIndex = int(texelFetch(clusterLightIndices, int(lightRange.x + i)).r);
         //Add point light calcs to the result
-        result += CalcPointLight(pointLights[i], norm, FragPos, viewDir);
+        result += CalcPointLight(GetPointLight(lightIndex), norm, FragPos, viewDir);
     }
 
     FragColor = vec4(result, 1.0);
@@ -89,6 +114,12 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
 
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
 {
+    //Clusters are binned by radius, so the light has to stop there or it would show where it was left out of a cluster
+    float distance = length(light.position - fragPos);
+    if (distance > light.radius)
+    {
+        return vec3(0.0);
+    }
     vec3 lightDir = normalize(light.position - fragPos);
     // diffuse shading
     float diff = max(dot(normal, lightDir), 0.0);
@@ -96,7 +127,6 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     vec3 reflectDir = reflect(-lightDir, normal);
     float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
     // attenuation
-    float distance = length(light.position - fragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));
     // combine results
     vec3 ambient = light.ambient * vec3(texture(material.diffuse, TexCoords));
@@ -106,4 +136,28 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     diffuse *= attenuation;
     specular *= attenuation;
     return (ambient + diffuse + specular);
-}
\ No newline at end of file
+}
+
+PointLight GetPointLight(int index)
+{
+    vec4 positionConstant = texelFetch(pointLightData, index * 4);
+    vec4 ambientLinear = texelFetch(pointLightData, index * 4 + 1);
+    vec4 diffuseQuadratic = texelFetch(pointLightData, index * 4 + 2);
+    vec4 specularRadius = texelFetch(pointLightData, index * 4 + 3);
+    return PointLight(positionConstant.xyz, positionConstant.w, ambientLinear.xyz, ambientLinear.w,
+        diffuseQuadratic.xyz, diffuseQuadratic.w, specularRadius.xyz, specularRadius.w);
+}
+
+//Works out which cluster this fragment is in the same way LightClusters bins the lights
+int GetCluster()
+{
+    //Depth buffer value back to distance from the camera
+    float near = clusterDepth.x;
+    float far = clusterDepth.y;
+    float ndcDepth = gl_FragCoord.z * 2.0 - 1.0;
+    float viewDepth = 2.0 * near * far / (far + near - ndcDepth * (far - near));
+
+    ivec3 cluster = ivec3(gl_FragCoord.xy * clusterScale.xy, log(viewDepth) * clusterScale.z + clusterScale.w);
+    cluster = clamp(cluster, ivec3(0), clusterGrid.xyz - 1);
+    return cluster.x + clusterGrid.x * (cluster.y + clusterGrid.y * cluster.z);
+}
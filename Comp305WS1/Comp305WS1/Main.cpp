@@ -6,8 +6,14 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include "Shaders.h"
+#include "ShaderProgram.h"
+#include "LightBuffers.h"
+#include "LightClusters.h"
+#include "ClusterBenchmark.h"
 
 //Camera variables
 glm::vec3 cameraPos = glm::vec3(0.0f, 0.0f, 3.0f);
@@ -30,6 +36,10 @@ float lastY = 300.0f;
 // lighting
 glm::vec3 lightPos(1.2f, 1.0f, 2.0f);
 
+//Size of the window's framebuffer, the light clusters are tiles of it
+int viewportWidth = 800;
+int viewportHeight = 600;
+
 //Convertes loaded image into texture
 int LoadTexture(char const* path)
 {
@@ -99,6 +109,8 @@ int LoadTexture(char const* path)
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     glViewport(0, 0, width, height);
+    viewportWidth = width;
+    viewportHeight = height;
     std::cout << "Re-sizing window" << std::endl;
 }
 
@@ -172,8 +184,22 @@ void processInput(GLFWwindow* window)
     }
 }
 
-int main()
+int main(int argc, char** argv)
 {
+    //--bench clusters times binning lights into clusters and exits without opening a window
+    //--lights <count> scatters that many more point lights around the cubes
+    int numOfExtraLights = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc)
+        {
+            if (strcmp(argv[i + 1], "clusters") == 0) return RunClusterBenchmark(argc, argv);
+            std::cout << "Unknown benchmark " << argv[i + 1] << std::endl;
+            return 1;
+        }
+        if (strcmp(argv[i], "--lights") == 0 && i + 1 < argc) numOfExtraLights = atoi(argv[++i]);
+    }
+
     //Initialises the glfw library
     glfwInit();
     //Sets glfw params like version
@@ -219,8 +245,18 @@ int main()
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
     //Creates shader program objects with vertex shaders and fragment shaders linked to them
-    int lightShaderProgram = LoadShaders("LightVertShader.glsl", "LightFragShader.glsl");
-    int shaderProgram = LoadShaders("VertexShader.glsl", "FragmentShader.glsl");
+    ShaderProgram lightShader, lampShader;
+    if (!lightShader.load("LightVertShader.glsl", "LightFragShader.glsl") || !lampShader.load("VertexShader.glsl", "FragmentShader.glsl"))
+    {
+        std::cout << "Failed to load shader programs" << std::endl;
+        lightShader.destroy();
+        lampShader.destroy();
+        glfwTerminate();
+        return -1;
+    }
+    const ShaderCacheStats& shaderStats = GetShaderCacheStats();
+    std::cout << "Shader cache: " << shaderStats.hitCount << "/" << shaderStats.hitCount + shaderStats.missCount << " programs from cache, "
+        << shaderStats.compileMilliseconds << " ms compiling, " << shaderStats.savedMilliseconds << " ms saved" << std::endl;
 
     glEnable(GL_DEPTH_TEST);
 
@@ -341,16 +377,101 @@ int main()
     int diffuseMap = LoadTexture("container2.png");
     int specularMap = LoadTexture("container2_specular.png");
 
-    glUseProgram(lightShaderProgram);
-    int materialDiffuseLoc = glGetUniformLocation(lightShaderProgram, "material.diffuse");
-    glUniform1i(materialDiffuseLoc, 0);
+    //Every uniform location is looked up here once, the loop below only uses the stored locations
+    const int numOfPointLights = 4;
+    GLint materialDiffuseLoc = lightShader.getLocation("material.diffuse");
+    GLint materialSpecularLoc = lightShader.getLocation("material.specular");
+    GLint materialShininessLoc = lightShader.getLocation("material.shininess");
+    GLint viewPosLoc = lightShader.getLocation("viewPos");
+    GLint pointLightDataLoc = lightShader.getLocation("pointLightData");
+    GLint clusterLightRangesLoc = lightShader.getLocation("clusterLightRanges");
+    GLint clusterLightIndicesLoc = lightShader.getLocation("clusterLightIndices");
+    GLint lightProjectionLoc = lightShader.getLocation("projection");
+    GLint lightViewLoc = lightShader.getLocation("view");
+    GLint lightModelLoc = lightShader.getLocation("model");
+    GLint lampProjectionLoc = lampShader.getLocation("projection");
+    GLint lampViewLoc = lampShader.getLocation("view");
+    GLint lampModelLoc = lampShader.getLocation("model");
+
+    lightShader.use();
+    lightShader.setInt(materialDiffuseLoc, 0);
+    lightShader.setInt(materialSpecularLoc, 1);
+
+    //Texture units after the material's two, these are bound once and never change
+    const GLuint pointLightTextureUnit = 2, clusterRangeTextureUnit = 3, clusterIndexTextureUnit = 4;
+    lightShader.setInt(pointLightDataLoc, pointLightTextureUnit);
+    lightShader.setInt(clusterLightRangesLoc, clusterRangeTextureUnit);
+    lightShader.setInt(clusterLightIndicesLoc, clusterIndexTextureUnit);
+
+    //Projection the scene is drawn with, the clusters are cut from the same frustum
+    const float fieldOfView = glm::radians(45.0f), aspectRatio = 800.0f / 600.0f, nearPlane = 0.1f, farPlane = 100.0f;
+
+    //The lights live in buffers the shader reads through binding points and texture units, only the parts that change get sent again
+    LightBuffers lights;
+    lights.create();
+    lights.bindPointLightTexture(pointLightTextureUnit);
+    LightClusters clusters;
+    clusters.create();
+    clusters.setProjection(fieldOfView, aspectRatio, nearPlane, farPlane);
+    clusters.bindTextures(clusterRangeTextureUnit, clusterIndexTextureUnit);
+    if (!lightShader.bindUniformBlock("DirLightBlock", LightBuffers::dirLightBindingPoint) || !lightShader.bindUniformBlock("ClusterBlock", LightClusters::clusterBindingPoint))
+    {
+        std::cout << "Light shader is missing its light blocks" << std::endl;
+    }
 
-    int materialSpecularLoc = glGetUniformLocation(lightShaderProgram, "material.specular");
-    glUniform1i(materialSpecularLoc, 1);
+    //Directional light, never changes so it only goes up once
+    DirLightData dirLight;
+    dirLight.direction = glm::vec4(-0.2f, -1.0f, -0.3f, 0.0f);
+    dirLight.ambient = glm::vec4(0.05f, 0.05f, 0.05f, 0.0f);
+    dirLight.diffuse = glm::vec4(0.4f, 0.4f, 0.4f, 0.0f);
+    dirLight.specular = glm::vec4(0.5f, 0.5f, 0.5f, 0.0f);
+    lights.setDirLight(dirLight);
+
+    //Point lights:
+    for (int i = 0; i < numOfPointLights; i++)
+    {
+        PointLightData pointLight = {};
+        pointLight.position = pointLightPositions[i];
+        pointLight.ambient = glm::vec3(0.05f, 0.05f, 0.05f);
+        pointLight.diffuse = glm::vec3(0.8f, 0.8f, 0.8f);
+        pointLight.specular = glm::vec3(1.0f, 1.0f, 1.0f);
+        pointLight.constant = 1.0f;
+        pointLight.linear = 0.09f;
+        pointLight.quadratic = 0.032f;
+        lights.addPointLight(pointLight);
+    }
+    //Extra lights are dimmer and reach a few units, scattered through the space the cubes are in
+    auto randomRange = [](float minimum, float maximum) { return minimum + static_cast<float>(rand()) / RAND_MAX * (maximum - minimum); };
+    for (int i = 0; i < numOfExtraLights; i++)
+    {
+        PointLightData pointLight = {};
+        pointLight.position = glm::vec3(randomRange(-6.0f, 6.0f), randomRange(-4.0f, 6.0f), randomRange(-16.0f, 2.0f));
+        pointLight.diffuse = glm::vec3(randomRange(0.1f, 0.5f), randomRange(0.1f, 0.5f), randomRange(0.1f, 0.5f));
+        pointLight.ambient = pointLight.diffuse * 0.05f;
+        pointLight.specular = pointLight.diffuse;
+        pointLight.constant = 1.0f;
+        pointLight.linear = 0.7f;
+        pointLight.quadratic = 1.8f;
+        if (lights.addPointLight(pointLight) < 0)
+        {
+            std::cout << "Only room for " << LightBuffers::maxPointLights << " point lights" << std::endl;
+            break;
+        }
+    }
+
+    //GL calls per frame, printed about once a second
+    unsigned long long framesSinceReport = 0, drawCallsSinceReport = 0;
+    unsigned long long uploadsSinceReport = 0, skippedUploadsSinceReport = 0, bindsSinceReport = 0, queriesSinceReport = 0, lightUploadsSinceReport = 0;
+    unsigned long long lightIndicesSinceReport = 0;
+    double clusterSecondsSinceReport = 0.0;
+    float lastReportTime = glfwGetTime();
 
     //Runs until the window is told to close
     while (!glfwWindowShouldClose(window))
     {
+        ShaderProgram::resetCallCounts();
+        unsigned int frameDrawCalls = 0;
+
         //Gets delta time to use for smoothing out camera movement
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
@@ -365,107 +486,32 @@ int main()
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         //Use light source program
-        glUseProgram(lightShaderProgram);
-        int viewPosLoc = glGetUniformLocation(lightShaderProgram, "viewPos");
-        glUniform3fv(viewPosLoc, 1, glm::value_ptr(cameraPos));
-        int materialShininessLoc = glGetUniformLocation(lightShaderProgram, "material.shininess");
-        glUniform1f(materialShininessLoc, 64.0f);
-
-
-        //Directional light uniform variables
-        int dirLightDirectionLoc = glGetUniformLocation(lightShaderProgram, "dirLight.direction");
-        glUniform3fv(dirLightDirectionLoc, 1, glm::value_ptr(glm::vec3(-0.2f, -1.0f, -0.3f)));
-
-        int dirLightAmbientLoc = glGetUniformLocation(lightShaderProgram, "dirLight.ambient");
-        glUniform3fv(dirLightAmbientLoc, 1, glm::value_ptr(glm::vec3(0.05f, 0.05f, 0.05f)));
-
-        int dirLightDiffuseLoc = glGetUniformLocation(lightShaderProgram, "dirLight.diffuse");
-        glUniform3fv(dirLightDiffuseLoc, 1, glm::value_ptr(glm::vec3(0.4f, 0.4f, 0.4f)));
-
-        int dirLightSpecularLoc = glGetUniformLocation(lightShaderProgram, "dirLight.specular");
-        glUniform3fv(dirLightSpecularLoc, 1, glm::value_ptr(glm::vec3(0.5f, 0.5f, 0.5f)));
-        
-        //Point lights:
-        //Point light 1:
-        int pointLight0PositionLoc = glGetUniformLocation(lightShaderProgram, "pointLights[0].position");
-        glUniform3fv(pointLight0PositionLoc, 1, glm::value_ptr(glm::vec3(pointLightPositions[0])));
-        int pointLight0AmbientLoc = glGetUniformLocation(lightShaderProgram, "pointLights[0].ambient");
-        glUniform3fv(pointLight0AmbientLoc, 1, glm::value_ptr(glm::vec3(0.05f, 0.05f, 0.05f)));
-        int pointLight0DiffuseLoc = glGetUniformLocation(lightShaderProgram, "pointLights[0].diffuse");
-        glUniform3fv(pointLight0DiffuseLoc, 1, glm::value_ptr(glm::vec3(0.8f, 0.8f, 0.8f)));
-        int pointLight0SpecularLoc = glGetUniformLocation(lightShaderProgram, "pointLights[0].specular");
-        glUniform3fv(pointLight0SpecularLoc, 1, glm::value_ptr(glm::vec3(1.0f, 1.0f, 1.0f)));
-        int pointLight0ConstantLoc = glGetUniformLocation(lightShaderProgram, "pointLights[0].constant");
-        glUniform1f(pointLight0ConstantLoc, 1.0f);
-        int pointLight0LinearLoc = glGetUniformLocation(lightShaderProgram, "pointLights[0].linear");
-        glUniform1f(pointLight0LinearLoc, 0.09f);
-        int pointLight0QuadraticLoc = glGetUniformLocation(lightShaderProgram, "pointLights[0].quadratic");
-        glUniform1f(pointLight0QuadraticLoc, 0.032f);
-
-        //Point light 2:
-        int pointLight1PositionLoc = glGetUniformLocation(lightShaderProgram, "pointLights[1].position");
-        glUniform3fv(pointLight1PositionLoc, 1, glm::value_ptr(glm::vec3(pointLightPositions[1])));
-        int pointLight1AmbientLoc = glGetUniformLocation(lightShaderProgram, "pointLights[1].ambient");
-        glUniform3fv(pointLight1AmbientLoc, 1, glm::value_ptr(glm::vec3(0.05f, 0.05f, 0.05f)));
-        int pointLight1DiffuseLoc = glGetUniformLocation(lightShaderProgram, "pointLights[1].diffuse");
-        glUniform3fv(pointLight1DiffuseLoc, 1, glm::value_ptr(glm::vec3(0.8f, 0.8f, 0.8f)));
-        int pointLight1SpecularLoc = glGetUniformLocation(lightShaderProgram, "pointLights[1].specular");
-        glUniform3fv(pointLight1SpecularLoc, 1, glm::value_ptr(glm::vec3(1.0f, 1.0f, 1.0f)));
-        int pointLight1ConstantLoc = glGetUniformLocation(lightShaderProgram, "pointLights[1].constant");
-        glUniform1f(pointLight1ConstantLoc, 1.0f);
-        int pointLight1LinearLoc = glGetUniformLocation(lightShaderProgram, "pointLights[1].linear");
-        glUniform1f(pointLight1LinearLoc, 0.09f);
-        int pointLight1QuadraticLoc = glGetUniformLocation(lightShaderProgram, "pointLights[1].quadratic");
-        glUniform1f(pointLight1QuadraticLoc, 0.032f);
-
-        //Point light 3:
-        int pointLight2PositionLoc = glGetUniformLocation(lightShaderProgram, "pointLights[2].position");
-        glUniform3fv(pointLight2PositionLoc, 1, glm::value_ptr(glm::vec3(pointLightPositions[2])));
-        int pointLight2AmbientLoc = glGetUniformLocation(lightShaderProgram, "pointLights[2].ambient");
-        glUniform3fv(pointLight2AmbientLoc, 1, glm::value_ptr(glm::vec3(0.05f, 0.05f, 0.05f)));
-        int pointLight2DiffuseLoc = glGetUniformLocation(lightShaderProgram, "pointLights[2].diffuse");
-        glUniform3fv(pointLight2DiffuseLoc, 1, glm::value_ptr(glm::vec3(0.8f, 0.8f, 0.8f)));
-        int pointLight2SpecularLoc = glGetUniformLocation(lightShaderProgram, "pointLights[2].specular");
-        glUniform3fv(pointLight2SpecularLoc, 1, glm::value_ptr(glm::vec3(1.0f, 1.0f, 1.0f)));
-        int pointLight2ConstantLoc = glGetUniformLocation(lightShaderProgram, "pointLights[2].constant");
-        glUniform1f(pointLight2ConstantLoc, 1.0f);
-        int pointLight2LinearLoc = glGetUniformLocation(lightShaderProgram, "pointLights[2].linear");
-        glUniform1f(pointLight2LinearLoc, 0.09f);
-        int pointLight2QuadraticLoc = glGetUniformLocation(lightShaderProgram, "pointLights[2].quadratic");
-        glUniform1f(pointLight2QuadraticLoc, 0.032f);
-
-        //Point light 4:
-        int pointLight3PositionLoc = glGetUniformLocation(lightShaderProgram, "pointLights[3].position");
-        glUniform3fv(pointLight3PositionLoc, 1, glm::value_ptr(glm::vec3(pointLightPositions[3])));
-        int pointLight3AmbientLoc = glGetUniformLocation(lightShaderProgram, "pointLights[3].ambient");
-        glUniform3fv(pointLight3AmbientLoc, 1, glm::value_ptr(glm::vec3(0.05f, 0.05f, 0.05f)));
-        int pointLight3DiffuseLoc = glGetUniformLocation(lightShaderProgram, "pointLights[3].diffuse");
-        glUniform3fv(pointLight3DiffuseLoc, 1, glm::value_ptr(glm::vec3(0.8f, 0.8f, 0.8f)));
-        int pointLight3SpecularLoc = glGetUniformLocation(lightShaderProgram, "pointLights[3].specular");
-        glUniform3fv(pointLight3SpecularLoc, 1, glm::value_ptr(glm::vec3(1.0f, 1.0f, 1.0f)));
-        int pointLight3ConstantLoc = glGetUniformLocation(lightShaderProgram, "pointLights[3].constant");
-        glUniform1f(pointLight3ConstantLoc, 1.0f);
-        int pointLight3LinearLoc = glGetUniformLocation(lightShaderProgram, "pointLights[3].linear");
-        glUniform1f(pointLight3LinearLoc, 0.09f);
-        int pointLight3QuadraticLoc = glGetUniformLocation(lightShaderProgram, "pointLights[3].quadratic");
-        glUniform1f(pointLight3QuadraticLoc, 0.032f);
+        lightShader.use();
+        lightShader.setVec3(viewPosLoc, cameraPos);
+        lightShader.setFloat(materialShininessLoc, 64.0f);
+
+        //Sends any lights that changed since the last frame, nothing after the first frame while they stay still
+        unsigned int frameLightUploads = lights.upload();
 
         //Creates a projection matrix which gives things perspective (makes things further away appear smaller) by creating a frustrum (area that renders things inside and does not render things outside)
-        glm::mat4 projection = glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f,100.0f);
+        glm::mat4 projection = glm::perspective(fieldOfView, aspectRatio, nearPlane, farPlane);
         //creates view martrix (space seen from camera pov)
         glm::mat4 view = glm::lookAt(cameraPos, cameraPos + cameraFront, cameraUp);
+
+        //Bins the lights into clusters from where the camera is now, so each fragment only shades the lights that reach it
+        double clusterStartTime = glfwGetTime();
+        clusters.setViewport(viewportWidth, viewportHeight);
+        clusters.build(view, lights.getPointLights(), lights.getPointLightCount());
+        frameLightUploads += clusters.upload();
+        clusterSecondsSinceReport += glfwGetTime() - clusterStartTime;
+        lightIndicesSinceReport += clusters.getLightIndices().size();
+
         //Creates model matrix (transformations to apply to objects)
         glm::mat4 model = glm::mat4(1.0f);
 
         //Set uniform variables in the lighting vertex shader
-        int projectionLoc = glGetUniformLocation(lightShaderProgram, "projection");
-        glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
-
-        int viewLoc = glGetUniformLocation(lightShaderProgram, "view");
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view)); 
-
-        int modelLoc = glGetUniformLocation(lightShaderProgram, "model");
-        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+        lightShader.setMat4(lightProjectionLoc, projection);
+        lightShader.setMat4(lightViewLoc, view);
 
         // bind diffuse map
         glActiveTexture(GL_TEXTURE0);
@@ -482,31 +528,48 @@ int main()
             model = glm::translate(model, cubePositions[i]);
             float angle = 20.0f * i;
             model = glm::rotate(model, glm::radians(angle), glm::vec3(1.0f, 0.3f, 0.5f));
-            int modelLoc = glGetUniformLocation(lightShaderProgram, "model");
-            glUniformMatrix4fv(
-                modelLoc, //Location of the global/uniform variable
-                1, //How many matrices to send
-                GL_FALSE, //If you want to transpose the matrix (swapping colums and rows) leave as false
-                glm::value_ptr(model)); //Actual matrix data, converted to usable data using value_ptr
+            lightShader.setMat4(lightModelLoc, model);
             glDrawArrays(GL_TRIANGLES, 0, 36);
+            frameDrawCalls++;
         }
 
         // also draw the lamp object
-        glUseProgram(shaderProgram);
-        projectionLoc = glGetUniformLocation(shaderProgram, "projection");
-        glUniformMatrix4fv(projectionLoc, 1, GL_FALSE, glm::value_ptr(projection));
-        viewLoc = glGetUniformLocation(shaderProgram, "view");
-        glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
+        lampShader.use();
+        lampShader.setMat4(lampProjectionLoc, projection);
+        lampShader.setMat4(lampViewLoc, view);
 
         glBindVertexArray(lightVAO);
-        for (unsigned int i = 0; i < 4; i++)
+        for (int i = 0; i < lights.getPointLightCount(); i++)
         {
             model = glm::mat4(1.0f);
-            model = glm::translate(model, pointLightPositions[i]);
-            model = glm::scale(model, glm::vec3(0.2f)); // a smaller cube
-            modelLoc = glGetUniformLocation(shaderProgram, "model");
-            glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+            model = glm::translate(model, lights.getPointLight(i).position);
+            model = glm::scale(model, glm::vec3(i < numOfPointLights ? 0.2f : 0.05f)); // a smaller cube, smaller still for the extra lights
+            lampShader.setMat4(lampModelLoc, model);
             glDrawArrays(GL_TRIANGLES, 0, 36);
+            frameDrawCalls++;
+        }
+
+        //Averages the GL calls over the frames since the last report
+        const ShaderCallCounts& callCounts = ShaderProgram::getCallCounts();
+        framesSinceReport++;
+        drawCallsSinceReport += frameDrawCalls;
+        uploadsSinceReport += callCounts.uniformUploads;
+        skippedUploadsSinceReport += callCounts.skippedUploads;
+        bindsSinceReport += callCounts.programBinds;
+        queriesSinceReport += callCounts.locationQueries;
+        lightUploadsSinceReport += frameLightUploads;
+        if (currentFrame - lastReportTime >= 1.0f)
+        {
+            std::cout << "Per frame: " << static_cast<double>(uploadsSinceReport) / framesSinceReport << " uniform uploads ("
+                << static_cast<double>(skippedUploadsSinceReport) / framesSinceReport << " skipped as unchanged), "
+                << static_cast<double>(lightUploadsSinceReport) / framesSinceReport << " light buffer uploads, "
+                << clusterSecondsSinceReport * 1000.0 / framesSinceReport << " ms binning " << lights.getPointLightCount() << " lights into "
+                << static_cast<double>(lightIndicesSinceReport) / framesSinceReport << " cluster entries, "
+                << static_cast<double>(bindsSinceReport) / framesSinceReport << " program binds, "
+                << static_cast<double>(drawCallsSinceReport) / framesSinceReport << " draw calls, " << static_cast<double>(queriesSinceReport) / framesSinceReport << " uniform location queries" << std::endl;
+            framesSinceReport = drawCallsSinceReport = uploadsSinceReport = skippedUploadsSinceReport = bindsSinceReport = queriesSinceReport = lightUploadsSinceReport = lightIndicesSinceReport = 0;
+            clusterSecondsSinceReport = 0.0;
+            lastReportTime = currentFrame;
         }
 
         //Swaps the color buffer
@@ -515,6 +578,11 @@ int main()
         glfwPollEvents();
     }
 
+    //Programs and buffers have to go while the context still exists
+    clusters.destroy();
+    lights.destroy();
+    lightShader.destroy();
+    lampShader.destroy();
     glfwTerminate();
     return 0;
 }
@@ -0,0 +1,141 @@
+#include "ShaderProgram.h"
+
+#include <glm/gtc/type_ptr.hpp>
+#include <cstring>
+
+GLuint ShaderProgram::s_CurrentProgram = 0;
+ShaderCallCounts ShaderProgram::s_CallCounts = {};
+
+ShaderProgram::ShaderProgram()
+	: m_ProgramID(0)
+{
+}
+
+ShaderProgram::~ShaderProgram()
+{
+	destroy();
+}
+
+bool ShaderProgram::load(const char* vertexFilePath, const char* fragmentFilePath)
+{
+	destroy();
+	m_ProgramID = LoadShaders(vertexFilePath, fragmentFilePath);
+	if (!m_ProgramID) return false;
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(m_ProgramID, GL_LINK_STATUS, &linked);
+	if (linked != GL_TRUE)
+	{
+		destroy();
+		return false;
+	}
+
+	GLint numOfUniforms = 0, maxNameLength = 0;
+	glGetProgramiv(m_ProgramID, GL_ACTIVE_UNIFORMS, &numOfUniforms);
+	glGetProgramiv(m_ProgramID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+	std::vector<char> nameBuffer(maxNameLength + 1);
+
+	GLint highestLocation = -1;
+	for (GLint i = 0; i < numOfUniforms; i++)
+	{
+		GLint arraySize = 0;
+		GLenum type = 0;
+		GLsizei nameLength = 0;
+		glGetActiveUniform(m_ProgramID, i, static_cast<GLsizei>(nameBuffer.size()), &nameLength, &arraySize, &type, nameBuffer.data());
+		std::string name(nameBuffer.data(), nameLength);
+
+		//Arrays of plain types come back once as "name[0]", every element gets its own entry and "name" is kept for the first
+		//Arrays of structs already come back one member at a time
+		size_t arraySuffix = name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0 ? name.size() - 3 : std::string::npos;
+		for (GLint element = 0; element < arraySize; element++)
+		{
+			std::string elementName = arraySuffix == std::string::npos ? name : name.substr(0, arraySuffix) + "[" + std::to_string(element) + "]";
+			GLint location = glGetUniformLocation(m_ProgramID, elementName.c_str());
+			s_CallCounts.locationQueries++;
+			//Uniforms inside a block have no location, they are set through the buffer bound to the block
+			if (location < 0) continue;
+
+			m_UniformsByName[elementName] = location;
+			if (element == 0 && arraySuffix != std::string::npos) m_UniformsByName[name.substr(0, arraySuffix)] = location;
+			if (location > highestLocation) highestLocation = location;
+		}
+	}
+
+	UniformValue emptyValue = {};
+	m_Values.assign(highestLocation + 1, emptyValue);
+	return true;
+}
+
+void ShaderProgram::destroy()
+{
+	if (m_ProgramID)
+	{
+		if (s_CurrentProgram == m_ProgramID) s_CurrentProgram = 0;
+		glDeleteProgram(m_ProgramID);
+	}
+	m_ProgramID = 0;
+	m_UniformsByName.clear();
+	m_Values.clear();
+}
+
+void ShaderProgram::use()
+{
+	if (s_CurrentProgram == m_ProgramID)
+	{
+		s_CallCounts.skippedBinds++;
+		return;
+	}
+	glUseProgram(m_ProgramID);
+	s_CurrentProgram = m_ProgramID;
+	s_CallCounts.programBinds++;
+}
+
+GLint ShaderProgram::getLocation(const std::string& name) const
+{
+	std::unordered_map<std::string, GLint>::const_iterator uniform = m_UniformsByName.find(name);
+	return uniform != m_UniformsByName.end() ? uniform->second : -1;
+}
+
+bool ShaderProgram::bindUniformBlock(const char* blockName, GLuint bindingPoint)
+{
+	GLuint blockIndex = glGetUniformBlockIndex(m_ProgramID, blockName);
+	if (blockIndex == GL_INVALID_INDEX) return false;
+	glUniformBlockBinding(m_ProgramID, blockIndex, bindingPoint);
+	return true;
+}
+
+bool ShaderProgram::changeValue(GLint location, const void* data, size_t size)
+{
+	if (location < 0 || location >= static_cast<GLint>(m_Values.size())) return false;
+
+	UniformValue& uniform = m_Values[location];
+	if (uniform.hasValue && memcmp(uniform.value, data, size) == 0)
+	{
+		s_CallCounts.skippedUploads++;
+		return false;
+	}
+	memcpy(uniform.value, data, size);
+	uniform.hasValue = true;
+	s_CallCounts.uniformUploads++;
+	return true;
+}
+
+void ShaderProgram::setInt(GLint location, int value)
+{
+	if (changeValue(location, &value, sizeof(value))) glUniform1i(location, value);
+}
+
+void ShaderProgram::setFloat(GLint location, float value)
+{
+	if (changeValue(location, &value, sizeof(value))) glUniform1f(location, value);
+}
+
+void ShaderProgram::setVec3(GLint location, const glm::vec3& value)
+{
+	if (changeValue(location, glm::value_ptr(value), sizeof(value))) glUniform3fv(location, 1, glm::value_ptr(value));
+}
+
+void ShaderProgram::setMat4(GLint location, const glm::mat4& value)
+{
+	if (changeValue(location, glm::value_ptr(value), sizeof(value))) glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Shaders.h"
+
+#include <glm/glm.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// <summary>
+/// GL calls made through ShaderProgram, and the ones it skipped because nothing would have changed
+/// </summary>
+struct ShaderCallCounts
+{
+	unsigned int uniformUploads;
+	unsigned int skippedUploads;
+	unsigned int programBinds;
+	unsigned int skippedBinds;
+	//glGetUniformLocation calls, only made while a program is being loaded
+	unsigned int locationQueries;
+};
+
+/// <summary>
+/// Linked shader program that finds every active uniform once at load time and remembers the last value sent to each
+/// Setters skip the upload when the value has not changed, so constant uniforms only cost a compare after the first frame
+/// </summary>
+class ShaderProgram
+{
+public:
+	ShaderProgram();
+	~ShaderProgram();
+
+	ShaderProgram(const ShaderProgram&) = delete;
+	ShaderProgram& operator=(const ShaderProgram&) = delete;
+
+	/// <summary>
+	/// Compiles or loads the program through LoadShaders and resolves all of its active uniforms, false if it did not link
+	/// </summary>
+	bool load(const char* vertexFilePath, const char* fragmentFilePath);
+	void destroy();
+
+	/// <summary>
+	/// Makes this the current program, skipped if it already is
+	/// </summary>
+	void use();
+
+	/// <summary>
+	/// Location of an active uniform, -1 if the shader has no such uniform or the compiler removed it
+	/// This is a string lookup, so locations should be fetched once and kept rather than asked for every frame
+	/// </summary>
+	GLint getLocation(const std::string& name) const;
+
+	/// <summary>
+	/// Points a uniform block at a binding point, false if the shader has no such block
+	/// The program keeps this, so it only needs doing once after load
+	/// </summary>
+	bool bindUniformBlock(const char* blockName, GLuint bindingPoint);
+
+	//Each setter needs this program to be current, and does nothing for location -1 the same as glUniform
+	void setInt(GLint location, int value);
+	void setFloat(GLint location, float value);
+	void setVec3(GLint location, const glm::vec3& value);
+	void setMat4(GLint location, const glm::mat4& value);
+
+	GLuint getID() const { return m_ProgramID; }
+	size_t getUniformCount() const { return m_UniformsByName.size(); }
+
+	//Shared by every program, main resets them at the start of each frame
+	static const ShaderCallCounts& getCallCounts() { return s_CallCounts; }
+	static void resetCallCounts() { s_CallCounts = ShaderCallCounts(); }
+
+private:
+	struct UniformValue
+	{
+		//Bytes of the last upload, big enough for a mat4
+		float value[16];
+		bool hasValue;
+	};
+
+	/// <summary>
+	/// Compares size bytes of data against the last upload to location and stores it, true if it needs uploading
+	/// </summary>
+	bool changeValue(GLint location, const void* data, size_t size);
+
+	GLuint m_ProgramID;
+	std::unordered_map<std::string, GLint> m_UniformsByName;
+	//Indexed by location, sized to the highest active location since drivers hand them out from 0 upwards
+	std::vector<UniformValue> m_Values;
+
+	static GLuint s_CurrentProgram;
+	static ShaderCallCounts s_CallCounts;
+};
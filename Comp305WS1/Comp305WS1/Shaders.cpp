@@ -1,17 +1,201 @@
 #include "Shaders.h"
 
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+//The loader in Dependencies was generated for GL 3.3, so the program binary entry points (GL 4.1 or ARB_get_program_binary) are fetched here
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+
+namespace
+{
+	//Bumped whenever the layout below changes so old caches are treated as misses
+	const uint32_t programCacheVersion = 1;
+	const char programCacheMagic[4] = { 'P', 'R', 'G', 'C' };
+
+	//Start of every program cache file, the binary glGetProgramBinary gave back follows it
+	struct ProgramCacheHeader
+	{
+		char magic[4];
+		uint32_t version;
+		//Hash of both sources and the driver, a binary only loads on the driver that made it
+		uint64_t sourceHash;
+		uint32_t binaryFormat;
+		uint32_t binaryLength;
+		//How long compiling and linking took when this was written
+		double compileMilliseconds;
+	};
+
+	bool shaderCacheEnabled = true;
+	ShaderCacheStats shaderCacheStats = {};
+
+	PFNGLGETPROGRAMBINARYPROC getProgramBinary = nullptr;
+	PFNGLPROGRAMBINARYPROC programBinary = nullptr;
+	PFNGLPROGRAMPARAMETERIPROC programParameteri = nullptr;
+
+	double MillisecondsSince(std::chrono::steady_clock::time_point startTime)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+	}
+
+	/// <summary>
+	/// Fetches the program binary functions the first time it is called, true if the driver has them and offers at least one binary format
+	/// </summary>
+	bool IsProgramBinarySupported()
+	{
+		static int supported = -1;
+		if (supported >= 0) return supported != 0;
+
+		bool hasExtension = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 1);
+		GLint numOfExtensions = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &numOfExtensions);
+		for (GLint i = 0; i < numOfExtensions && !hasExtension; i++)
+		{
+			const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+			hasExtension = extension && strcmp(extension, "GL_ARB_get_program_binary") == 0;
+		}
+
+		GLint numOfFormats = 0;
+		if (hasExtension)
+		{
+			getProgramBinary = reinterpret_cast<PFNGLGETPROGRAMBINARYPROC>(glfwGetProcAddress("glGetProgramBinary"));
+			programBinary = reinterpret_cast<PFNGLPROGRAMBINARYPROC>(glfwGetProcAddress("glProgramBinary"));
+			programParameteri = reinterpret_cast<PFNGLPROGRAMPARAMETERIPROC>(glfwGetProcAddress("glProgramParameteri"));
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numOfFormats);
+		}
+		supported = getProgramBinary && programBinary && programParameteri && numOfFormats > 0;
+		return supported != 0;
+	}
+
+	/// <summary>
+	/// 64 bit FNV-1a, chained through seed so both sources and the driver strings end up in one hash
+	/// </summary>
+	uint64_t HashBytes(const void* data, size_t size, uint64_t seed)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		uint64_t hash = (14695981039346656037ull ^ seed) ^ size;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+		return hash ^ (hash >> 32);
+	}
+
+	uint64_t HashProgramSources(const std::string& vertexCode, const std::string& fragmentCode)
+	{
+		uint64_t hash = HashBytes(vertexCode.data(), vertexCode.size(), 0);
+		hash = HashBytes(fragmentCode.data(), fragmentCode.size(), hash);
+		//A driver update can change the binary format without changing its number
+		const GLenum driverStrings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+		for (GLenum name : driverStrings)
+		{
+			const char* value = reinterpret_cast<const char*>(glGetString(name));
+			if (value) hash = HashBytes(value, strlen(value), hash);
+		}
+		return hash;
+	}
+
+	/// <summary>
+	/// Kept beside the vertex shader, named after both files since a vertex shader can be shared between programs
+	/// </summary>
+	std::string GetProgramCachePath(const char* vertexFilePath, const char* fragmentFilePath)
+	{
+		std::string fragmentName = fragmentFilePath;
+		size_t lastSlash = fragmentName.find_last_of("/\\");
+		if (lastSlash != std::string::npos) fragmentName = fragmentName.substr(lastSlash + 1);
+		return std::string(vertexFilePath) + "+" + fragmentName + ".programcache";
+	}
+
+	/// <summary>
+	/// Returns the linked program, or 0 if there is no matching cache or the driver will not take the binary
+	/// </summary>
+	GLuint LoadCachedProgram(const std::string& cachePath, uint64_t sourceHash, double& compileMilliseconds)
+	{
+		FILE* file = fopen(cachePath.c_str(), "rb");
+		if (!file) return 0;
+
+		ProgramCacheHeader header;
+		std::vector<char> binary;
+		bool valid = fread(&header, sizeof(header), 1, file) == 1 && memcmp(header.magic, programCacheMagic, sizeof(header.magic)) == 0
+			&& header.version == programCacheVersion && header.sourceHash == sourceHash && header.binaryLength > 0;
+		if (valid)
+		{
+			binary.resize(header.binaryLength);
+			valid = fread(binary.data(), 1, binary.size(), file) == binary.size();
+		}
+		fclose(file);
+		if (!valid) return 0;
+
+		GLuint ProgramID = glCreateProgram();
+		programBinary(ProgramID, header.binaryFormat, binary.data(), static_cast<GLsizei>(binary.size()));
+		GLint Result = GL_FALSE;
+		glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
+		if (Result != GL_TRUE)
+		{
+			glDeleteProgram(ProgramID);
+			return 0;
+		}
+		compileMilliseconds = header.compileMilliseconds;
+		return ProgramID;
+	}
+
+	/// <summary>
+	/// Failing to write only costs the next run a compile, so nothing is reported
+	/// </summary>
+	void SaveProgramBinary(const std::string& cachePath, GLuint ProgramID, uint64_t sourceHash, double compileMilliseconds)
+	{
+		GLint binaryLength = 0;
+		glGetProgramiv(ProgramID, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+		if (binaryLength <= 0) return;
+
+		ProgramCacheHeader header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, programCacheMagic, sizeof(header.magic));
+		header.version = programCacheVersion;
+		header.sourceHash = sourceHash;
+		header.compileMilliseconds = compileMilliseconds;
+
+		std::vector<char> binary(binaryLength);
+		GLenum binaryFormat = 0;
+		GLsizei writtenLength = 0;
+		getProgramBinary(ProgramID, binaryLength, &writtenLength, &binaryFormat, binary.data());
+		if (writtenLength <= 0) return;
+		header.binaryFormat = binaryFormat;
+		header.binaryLength = static_cast<uint32_t>(writtenLength);
+
+		FILE* file = fopen(cachePath.c_str(), "wb");
+		if (!file) return;
+		bool written = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(binary.data(), 1, writtenLength, file) == static_cast<size_t>(writtenLength);
+		fclose(file);
+		if (!written) remove(cachePath.c_str());
+	}
+}
+
+void SetShaderCacheEnabled(bool enabled)
+{
+	shaderCacheEnabled = enabled;
+}
+
+const ShaderCacheStats& GetShaderCacheStats()
+{
+	return shaderCacheStats;
+}
+
 /// <summary>
 /// Loads vertex and fragment shader source code using their file paths, also links them both to a shader program and returns it, with checks to see if anything fails
+/// If the same sources were linked on this driver before, the program binary saved then is loaded instead of compiling
 /// </summary>
 /// <param name="vertex_file_path"></param>
 /// <param name="fragment_file_path"></param>
 /// <returns></returns>
 GLuint LoadShaders(const char* vertex_file_path, const char* fragment_file_path)
 {
-	// Create the shaders as a GL integer
-	GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER /*creates a shader using vertex buffer this creates a set of co-ords that defines our pixels*/);
-	GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER /*creates a shader using fragment buffer this colours a cluster/fragment of pixels*/);
-
 	// Read the Vertex Shader code from the file
 	std::string VertexShaderCode;
 	std::ifstream VertexShaderStream(vertex_file_path, std::ios::in);
@@ -44,6 +228,30 @@ GLuint LoadShaders(const char* vertex_file_path, const char* fragment_file_path)
 		return 0;
 	}
 
+	//Tries the binary from last time before compiling anything
+	auto startTime = std::chrono::steady_clock::now();
+	bool useCache = shaderCacheEnabled && IsProgramBinarySupported();
+	uint64_t sourceHash = 0;
+	std::string cachePath;
+	if (useCache)
+	{
+		sourceHash = HashProgramSources(VertexShaderCode, FragmentShaderCode);
+		cachePath = GetProgramCachePath(vertex_file_path, fragment_file_path);
+		double cachedCompileMilliseconds = 0.0;
+		GLuint CachedProgramID = LoadCachedProgram(cachePath, sourceHash, cachedCompileMilliseconds);
+		if (CachedProgramID)
+		{
+			shaderCacheStats.hitCount++;
+			shaderCacheStats.savedMilliseconds += cachedCompileMilliseconds - MillisecondsSince(startTime);
+			std::cout << "Loaded program " << cachePath << " from cache" << std::endl;
+			return CachedProgramID;
+		}
+	}
+
+	// Create the shaders as a GL integer
+	GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER /*creates a shader using vertex buffer this creates a set of co-ords that defines our pixels*/);
+	GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER /*creates a shader using fragment buffer this colours a cluster/fragment of pixels*/);
+
 	//Setting a gl int as false represents 0
 	GLint Result = GL_FALSE;
 	int InfoLogLength;
@@ -83,6 +291,8 @@ GLuint LoadShaders(const char* vertex_file_path, const char* fragment_file_path)
 	GLuint ProgramID = glCreateProgram();
 	glAttachShader(ProgramID, VertexShaderID);
 	glAttachShader(ProgramID, FragmentShaderID);
+	//Lets the driver know the binary will be asked for, some only keep it around when told
+	if (useCache) programParameteri(ProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glLinkProgram(ProgramID);
 
 	// Check the program
@@ -100,5 +310,11 @@ GLuint LoadShaders(const char* vertex_file_path, const char* fragment_file_path)
 	glDeleteShader(VertexShaderID);
 	glDeleteShader(FragmentShaderID);
 
+	double compileMilliseconds = MillisecondsSince(startTime);
+	shaderCacheStats.missCount++;
+	shaderCacheStats.compileMilliseconds += compileMilliseconds;
+	//Only programs that linked are worth keeping
+	if (useCache && Result == GL_TRUE) SaveProgramBinary(cachePath, ProgramID, sourceHash, compileMilliseconds);
+
 	return ProgramID;
-}
\ No newline at end of file
+}
@@ -8,4 +8,21 @@
 #include <sstream>
 #include <vector>
 
-GLuint LoadShaders(const char* vertex_file_path, const char* fragment_file_path);
\ No newline at end of file
+/// <summary>
+/// Totals for every LoadShaders call so far, savedMilliseconds is what compiling the cached programs took when they were written less what loading them took
+/// </summary>
+struct ShaderCacheStats
+{
+	unsigned int hitCount;
+	unsigned int missCount;
+	double compileMilliseconds;
+	double savedMilliseconds;
+};
+
+GLuint LoadShaders(const char* vertex_file_path, const char* fragment_file_path);
+
+/// <summary>
+/// Turns the program binary cache on or off, it is on by default and skipped anyway if the driver cannot save program binaries
+/// </summary>
+void SetShaderCacheEnabled(bool enabled);
+const ShaderCacheStats& GetShaderCacheStats();